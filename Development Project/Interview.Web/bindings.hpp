@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "json.reader.h"
+
+// bindings are the request bodies of the API, read straight from the bytes
+// of the body with `iti::json::Reader` (see "json.reader.h").
+
+// ProductInput is the body of `POST /api/v1/products`:
+//
+//	{
+//		"name" : <string>,
+//		"general-details" : <string>,
+//		"categories" : [<string>,...,<string>],
+//		"metadata" : [<string>,...,<string>]
+//	}
+struct ProductInput {
+	std::string name;
+	std::string details;
+	std::vector<std::string> categories;
+	std::vector<std::string> metadata;
+};
+
+inline bool read_json(iti::json::Reader &r, ProductInput &p) {
+	using iti::json::field;
+	return iti::json::read_fields(
+	    r, p, field("name", &ProductInput::name),
+	    field("general-details", &ProductInput::details),
+	    field("categories", &ProductInput::categories),
+	    field("metadata", &ProductInput::metadata));
+}
+
+// InventoryInput is the body of `POST /api/v1/products/{id}/inventory`:
+// units to add to, or remove from, the stock of a product.
+//
+//	{"add" : <integer>}
+//	{"remove" : <integer>}
+struct InventoryInput {
+	uint64_t add    = 0;
+	uint64_t remove = 0;
+};
+
+inline bool read_json(iti::json::Reader &r, InventoryInput &inv) {
+	using iti::json::field;
+	return iti::json::read_fields(r, inv, field("add", &InventoryInput::add),
+	                              field("remove", &InventoryInput::remove));
+}
+
+// InventoryBatchInput is the body of `POST /api/v1/inventory/batch`:
+// changes of the stock of products, made in order. A positive delta adds
+// units, a negative one removes them, 0 reports the stock.
+//
+//	{
+//		"mode" : "all-or-nothing" | "best-effort",
+//		"changes" : [{"id" : <integer>, "delta" : <integer>},...]
+//	}
+//
+// "mode" is "all-or-nothing" when left out.
+struct InventoryChangeInput {
+	uint64_t id   = 0;
+	int64_t delta = 0;
+};
+
+inline bool read_json(iti::json::Reader &r, InventoryChangeInput &c) {
+	using iti::json::field;
+	return iti::json::read_fields(r, c, field("id", &InventoryChangeInput::id),
+	                              field("delta", &InventoryChangeInput::delta));
+}
+
+struct InventoryBatchInput {
+	std::string mode = "all-or-nothing";
+	std::vector<InventoryChangeInput> changes;
+};
+
+inline bool read_json(iti::json::Reader &r, InventoryBatchInput &b) {
+	using iti::json::field;
+	return iti::json::read_fields(
+	    r, b, field("mode", &InventoryBatchInput::mode),
+	    field("changes", &InventoryBatchInput::changes));
+}
+
+// read_body reads the whole of `body` into `v`. On failure, `r` tells why.
+template <class T>
+bool read_body(iti::json::Reader &r, std::string_view body, T &v) {
+	return r.parse(body) && read_json(r, v) && r.end();
+}
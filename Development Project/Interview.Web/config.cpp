@@ -10,6 +10,11 @@ std::string CfgService::GetConnectionString() const {
     return std::string(connectionStr);
 }
 
+std::string CfgService::GetProductBackend() const {
+    std::shared_lock<std::shared_mutex> l(mtx);
+    return productBackend;
+}
+
 unsigned int CfgService::GetServerPort() const {
     std::shared_lock<std::shared_mutex> l(mtx);
     return serverPort;
@@ -20,6 +25,11 @@ unsigned int CfgService::GetPageSize() const {
     return pageSize;
 }
 
+unsigned int CfgService::GetCursorTimeout() const {
+    std::shared_lock<std::shared_mutex> l(mtx);
+    return cursorTimeout;
+}
+
 void CfgService::init() {
 
     toml::table tbl;
@@ -31,8 +41,13 @@ void CfgService::init() {
     }
 
     connectionStr = tbl["database"]["connectionString"].value_or("");
+    productBackend =
+        tbl["database"]["backend"].value_or(std::string(productBackend));
     serverPort    = static_cast<uint16_t>(
         tbl["server"]["port"].value_or<int64_t>((int64_t)serverPort));
+    cursorTimeout = static_cast<unsigned int>(
+        tbl["server"]["cursorTimeout"].value_or<int64_t>(
+            (int64_t)cursorTimeout));
 }
 
 CfgService::CfgService() {
@@ -11,8 +11,12 @@ class CfgService {
 	}
 
 	std::string GetConnectionString() const;
+	// "mssql" (the default) or "memory", see iti::ProductHandlerType
+	std::string GetProductBackend() const;
 	unsigned int GetServerPort() const;
 	unsigned int GetPageSize() const;
+	// seconds a listing cursor (`?cursor=`) is kept between two pages
+	unsigned int GetCursorTimeout() const;
 
   private:
 	CfgService();
@@ -22,7 +26,9 @@ class CfgService {
 
 	mutable std::shared_mutex mtx;
 	std::string connectionStr;
+	std::string productBackend = "mssql";
 	uint16_t serverPort = 8080;
 	unsigned int pageSize = 50;
+	unsigned int cursorTimeout = 60;
 	void init();
 };
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "IProductHandlerV2.h"
+
+// CursorRegistry keeps the collection handles of the listings in progress
+// between two requests, under opaque tokens the clients pass back as
+// `?cursor=`. A listing resumes where its handle stopped, so a deep page
+// costs what the first one does.
+//
+// A handle is used by one request at a time: `take()` removes it from the
+// registry, and the request puts it back (under a new token) if there's more
+// to list, or closes it. Handles idle for longer than the timeout are closed
+// on the next `put()` or `take()`; past `maxCursors`, the least recently used
+// one is closed. A request holds its handle in an `Owned`, which closes it
+// on the way out unless it was put back, whichever way the request ends.
+// Handles are closed after the registry's lock is released, so a slow close
+// doesn't hold up the other requests.
+class CursorRegistry {
+  public:
+	using Handle = iti::IProductHandlerV2::Handle;
+	using clock  = std::chrono::steady_clock;
+
+	static constexpr size_t maxCursors = 10000;
+
+	CursorRegistry(std::shared_ptr<iti::IProductHandlerV2> handler,
+	               clock::duration timeout)
+	    : handler(std::move(handler)), timeout(timeout) {}
+	CursorRegistry(const CursorRegistry &) = delete;
+	CursorRegistry &operator=(const CursorRegistry &) = delete;
+	~CursorRegistry() { close_all(); }
+
+	// put registers `handle` and returns its token.
+	std::string put(Handle handle) {
+		std::vector<Handle> expired;
+		std::string token;
+		{
+			std::lock_guard<std::mutex> l(mtx);
+			const auto now = clock::now();
+			expire(now, expired);
+			if (idle.size() >= maxCursors) {
+				pop_front(expired);
+			}
+
+			token = new_token();
+			idle.push_back({token, handle, now + timeout});
+			byToken.emplace(token, std::prev(idle.end()));
+		}
+		close(expired);
+		return token;
+	}
+
+	// take removes the cursor `token` and returns its handle, or nullptr if
+	// there's none (unknown, expired or already taken). The caller then owns
+	// the handle: it must `put()` it back or `close()` it.
+	Handle take(std::string_view token) {
+		std::vector<Handle> expired;
+		Handle handle = nullptr;
+		{
+			std::lock_guard<std::mutex> l(mtx);
+			expire(clock::now(), expired);
+
+			auto it = byToken.find(std::string(token));
+			if (it != byToken.end()) {
+				handle = it->second->handle;
+				idle.erase(it->second);
+				byToken.erase(it);
+			}
+		}
+		close(expired);
+		return handle;
+	}
+
+	void close(Handle handle) { handler->CloseCollectionHandle(handle); }
+
+	void close(const std::vector<Handle> &handles) {
+		for (Handle h : handles) {
+			close(h);
+		}
+	}
+
+	// Owned is a handle a request owns: it is closed when the Owned goes
+	// out of scope, unless it was `put()` back in the registry.
+	class Owned {
+	  public:
+		explicit Owned(CursorRegistry &registry) : registry(registry) {}
+		Owned(const Owned &) = delete;
+		Owned &operator=(const Owned &) = delete;
+		~Owned() { reset(); }
+
+		Handle get() const { return handle; }
+		explicit operator bool() const { return handle != nullptr; }
+
+		// out is where a call opening a listing returns its handle.
+		Handle *out() {
+			reset();
+			return &handle;
+		}
+
+		// reset closes the handle, and owns `h` instead.
+		void reset(Handle h = nullptr) {
+			if (handle != nullptr) {
+				registry.close(handle);
+			}
+			handle = h;
+		}
+
+		// put hands the handle back to the registry, and returns its token.
+		std::string put() {
+			Handle h = handle;
+			handle   = nullptr;
+			return registry.put(h);
+		}
+
+	  private:
+		CursorRegistry &registry;
+		Handle handle = nullptr;
+	};
+
+	// close_all closes the idle handles, before the handler shuts down.
+	void close_all() {
+		std::vector<Handle> all;
+		{
+			std::lock_guard<std::mutex> l(mtx);
+			while (!idle.empty()) {
+				pop_front(all);
+			}
+		}
+		close(all);
+	}
+
+	size_t size() const {
+		std::lock_guard<std::mutex> l(mtx);
+		return idle.size();
+	}
+
+  private:
+	struct Entry {
+		std::string token;
+		Handle handle;
+		clock::time_point expiry;
+	};
+
+	// expire removes the handles idle since before `now - timeout`, to be
+	// closed by the caller. The entries are in the order they were put,
+	// hence of expiry.
+	void expire(clock::time_point now, std::vector<Handle> &expired) {
+		while (!idle.empty() && idle.front().expiry <= now) {
+			pop_front(expired);
+		}
+	}
+
+	void pop_front(std::vector<Handle> &removed) {
+		removed.push_back(idle.front().handle);
+		byToken.erase(idle.front().token);
+		idle.pop_front();
+	}
+
+	// new_token returns 128 bits from the system's random source in hex.
+	// Each token is drawn afresh: one can't be guessed from the others, so
+	// a client can't page through another client's listing.
+	std::string new_token() {
+		static const char hex[] = "0123456789abcdef";
+
+		std::string token(32, '0');
+		for (size_t i = 0; i < token.size(); i += 8) {
+			uint32_t bits = uint32_t(random());
+			for (size_t k = 0; k < 8; k++, bits >>= 4) {
+				token[i + k] = hex[bits & 0xf];
+			}
+		}
+		return token;
+	}
+
+	std::shared_ptr<iti::IProductHandlerV2> handler;
+	const clock::duration timeout;
+
+	mutable std::mutex mtx;
+	std::list<Entry> idle;
+	std::unordered_map<std::string, std::list<Entry>::iterator> byToken;
+	std::random_device random; // used under `mtx`
+};
@@ -0,0 +1,119 @@
+// Response serialization benchmark (see "bench.h"). From
+// Sparcpoint.Core.Lib:
+//
+//	./run.sh ../Interview.Web/evHttpResponse.bench.cpp -levent
+
+#include "bench.h"
+
+#include <evhttp.h>
+#include <stdexcept>
+#include <string>
+
+#include "StrUtils.h"
+#include "evHttpResponse.hpp"
+#include "http.h"
+
+namespace before {
+
+// evHttpResponse as it was before it wrote into the output evbuffer: the
+// body is copied into a string, then into a new evbuffer, and the reason
+// phrase is cut out of `StatusCode::str()` for every reply.
+class evHttpResponse : public iti::http::Response {
+  public:
+	void write(const std::string &body = "") override {
+		responseReadyToSend = true;
+		this->body          = body;
+	}
+
+	void append(std::string_view /*chunk*/) override {}
+
+	bool process_response() {
+		if (!responseReadyToSend) {
+			return false;
+		}
+
+		auto buf = evbuffer_new();
+		evbuffer_add(buf, body.data(), body.size());
+
+		iti::http::StatusCode statusCode;
+		if (iti::http::StatusCode::try_parse(status, statusCode)) {
+			statusCode = iti::http::StatusCode::Status200OK;
+		}
+
+		auto outHeaders = evhttp_request_get_output_headers(req);
+		auto headerEnd  = header.cend();
+		for (auto it = header.cbegin(); it != headerEnd; it++) {
+			// fields sharing a name are sent once, with all their values
+			if (header.find(it->name()) != it) {
+				continue;
+			}
+
+			std::string hContent{it->value()};
+			for (auto v = it + 1; v != headerEnd; v++) {
+				if (iti::strutils::iequals(v->name(), it->name())) {
+					hContent += "; ";
+					hContent += v->value();
+				}
+			}
+
+			std::string hName{it->name()};
+			evhttp_add_header(outHeaders, hName.c_str(), hContent.c_str());
+		}
+
+		// figure out the status code
+		std::string statusCodeReason{statusCode.str()};
+		statusCodeReason = statusCodeReason.substr(statusCodeReason.find(' '));
+
+		evhttp_send_reply(req, status, statusCodeReason.c_str(), buf);
+
+		evbuffer_free(buf);
+		return true;
+	}
+
+	void reset() override {
+		iti::http::Response::reset();
+		responseReadyToSend = false;
+		body.clear();
+	}
+
+	void set_request(struct evhttp_request *r) { req = r; }
+
+  private:
+	struct evhttp_request *req = nullptr;
+	bool responseReadyToSend   = false;
+	std::string body;
+};
+
+} // namespace before
+
+// respond sends a typical JSON response through `resp`: 6 header fields, 3
+// of them named Vary, and a 2 KB body. The request has no connection, so
+// libevent frees it once the reply is made.
+template <class Response>
+static void respond(Response &resp, const std::string &body, int i) {
+	resp.reset();
+	resp.set_request(evhttp_request_new(nullptr, nullptr));
+	resp.status = i % 4 == 0 ? 404 : 200;
+	resp.header.set("Content-Type", "application/json");
+	resp.header.add("X-Request-Id", "host/abcdef-000001");
+	resp.header.add("Vary", "Accept");
+	resp.header.add("Vary", "Accept-Encoding");
+	resp.header.add("Cache-Control", "no-cache");
+	resp.header.add("Vary", "Origin");
+	resp.write(body);
+	resp.process_response();
+}
+
+int main() {
+	const std::string body(2048, 'x');
+
+	before::evHttpResponse oldResp;
+	int i = 0;
+	iti::bench::run("response with a 2 KB body, before", 200000,
+	                [&] { respond(oldResp, body, i++); });
+
+	evHttpResponse resp;
+	iti::bench::run("response with a 2 KB body, after", 200000,
+	                [&] { respond(resp, body, i++); });
+	return 0;
+}
@@ -1,19 +1,39 @@
 #pragma once
 
 #include <evhttp.h>
-#include <numeric>
+#include <memory>
 
 #include "http.h"
 
 class evHttpResponse : public iti::http::Response {
   public:
-	evHttpResponse() = default;
-	evHttpResponse(struct evhttp_request *r) : req(r) {}
+	evHttpResponse() : out(evbuffer_new()) {}
+	evHttpResponse(struct evhttp_request *r) : evHttpResponse() { req = r; }
+
+	~evHttpResponse() { evbuffer_free(out); }
+
+	evHttpResponse(const evHttpResponse &) = delete;
+	evHttpResponse &operator=(const evHttpResponse &) = delete;
 
 	void write(const std::string &body = "") override {
+		append(body);
 		responseReadyToSend = true;
 
-		this->body = body;
+		// HEAD: if the handler built the body anyway, advertise its length.
+		// Handlers that skip it (see `omitBody`) send no Content-Length,
+		// which HEAD allows (RFC 7231, section 4.3.2).
+		if (omitBody && bodySize > 0) {
+			header.set("Content-Length", std::to_string(bodySize));
+		}
+	}
+
+	void append(std::string_view chunk) override {
+		bodySize += chunk.size();
+
+		// the body goes straight to the buffer handed to libevent
+		if (!omitBody) {
+			evbuffer_add(out, chunk.data(), chunk.size());
+		}
 	}
 
 	bool process_response() {
@@ -26,45 +46,46 @@ class evHttpResponse : public iti::http::Response {
 			return false;
 		}
 
-		auto buf = evbuffer_new();
-		evbuffer_add(buf, body.data(), body.size());
-
-		iti::http::StatusCode statusCode;
-		if (iti::http::StatusCode::try_parse(status, statusCode)) {
-			statusCode = iti::http::StatusCode::Status200OK;
+		// an unknown status code is a bug in the handler
+		auto reason = iti::http::StatusCode::reason_phrase(status);
+		if (reason.empty()) {
+			status = iti::http::StatusCode::Status500InternalServerError;
+			reason = iti::http::StatusCode::reason_phrase(status);
 		}
 
-		auto outHeaders = evhttp_request_get_output_headers(req);
-		auto headerEnd  = header.cend();
-		for (auto it = header.cbegin(); it != headerEnd; it++) {
-			// skip headers with no content
-			if (it->second.empty()) {
-				continue;
-			}
+		write_headers(evhttp_request_get_output_headers(req));
 
-			std::string hContent = *it->second.begin();
+		// the phrase is NUL-terminated (see `StatusCode::reason_phrase()`)
+		evhttp_send_reply(req, status, reason.data(), out);
 
-			hContent = std::accumulate(
-			    ++it->second.begin(), it->second.end(), hContent,
-			    [](const std::string &a, const std::string &b) {
-				    return a + "; " + b;
-			    });
+		responseSent = true;
+		return true;
+	}
 
-			evhttp_add_header(outHeaders, it->first.c_str(), hContent.c_str());
-		}
+	size_t get_body_size() const override { return omitBody ? 0 : bodySize; }
 
-		// figure out the status code
-		std::string statusCodeReason{statusCode.str()};
-		statusCodeReason = statusCodeReason.substr(statusCodeReason.find(' '));
+	void reset() override {
+		iti::http::Response::reset();
 
-		evhttp_send_reply(req, status, statusCodeReason.c_str(), buf);
+		req                 = nullptr;
+		request             = nullptr;
+		responseSent        = false;
+		responseReadyToSend = false;
+		bodySize            = 0;
+		evbuffer_drain(out, evbuffer_get_length(out));
+	}
 
-		evbuffer_free(buf);
+	void set_request(struct evhttp_request *r) { req = r; }
 
-		responseSent = true;
-		return true;
+	// attach keeps the request this responds to, and with it the request
+	// arena (see "arena.h"), alive until the response has been sent.
+	void attach(std::shared_ptr<iti::http::Request> r) {
+		request = std::move(r);
 	}
 
+	// detach hands the attached request back, once the response is sent.
+	std::shared_ptr<iti::http::Request> detach() { return std::move(request); }
+
 	bool get_ready_to_send() const {
 		return responseReadyToSend && !responseSent;
 	}
@@ -72,8 +93,60 @@ class evHttpResponse : public iti::http::Response {
 	bool get_response_sent() const { return responseSent; }
 
   protected:
+	// write_headers adds the response headers to `outHeaders`. Fields sharing
+	// a name are sent once, their values joined with ", " in a single pass
+	// (RFC 7230, section 3.2.2); "Set-Cookie" can't be joined and is sent as
+	// many times as it was set.
+	void write_headers(struct evkeyvalq *outHeaders) {
+		auto begin = header.cbegin();
+		auto end   = header.cend();
+		for (auto it = begin; it != end; it++) {
+			bool repeated = it->id() == iti::http::HeaderName::SetCookie;
+
+			bool seen  = false;
+			size_t len = it->value().size();
+			for (auto f = begin; f != end && !repeated; f++) {
+				if (f == it || !f->same_name(*it)) {
+					continue;
+				}
+				if (f < it) {
+					seen = true; // sent with the first field of that name
+					break;
+				}
+				len += 2 + f->value().size();
+			}
+			if (seen) {
+				continue;
+			}
+
+			nameBuf.assign(it->name().data(), it->name().size());
+
+			valueBuf.clear();
+			valueBuf.reserve(len);
+			valueBuf.append(it->value().data(), it->value().size());
+			for (auto f = it + 1; len != valueBuf.size() && f != end; f++) {
+				if (f->same_name(*it)) {
+					valueBuf += ", ";
+					valueBuf.append(f->value().data(), f->value().size());
+				}
+			}
+
+			evhttp_add_header(outHeaders, nameBuf.c_str(), valueBuf.c_str());
+		}
+	}
+
 	struct evhttp_request *req = nullptr;
+	std::shared_ptr<iti::http::Request> request;
 	bool responseSent          = false;
 	bool responseReadyToSend   = false;
-	std::string body;
+
+	// body of the response, handed to libevent as is; `bodySize` also counts
+	// what was dropped for HEAD requests
+	struct evbuffer *out = nullptr;
+	size_t bodySize      = 0;
+
+	// scratch buffers for the header fields, reused from one response to the
+	// next
+	std::string nameBuf;
+	std::string valueBuf;
 };
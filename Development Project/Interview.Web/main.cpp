@@ -17,53 +17,186 @@
 #endif
 
 #include "fmt/format.h"
-#include "json.hpp"
 
 #include "StatusCode.h"
+#include "encoding.h"
 #include "http.h"
+#include "json.reader.h"
+#include "json.writer.h"
+#include "pool.h"
+#include "router.metrics.h"
 #include "router.mux.h"
+#include "router.pipeline.h"
+#include "router.snapshot.h"
 #include "uri.h"
 
+#include "bindings.hpp"
 #include "config.h"
+#include "cursors.hpp"
 #include "evHttpResponse.hpp"
 #include "middlewares.hpp"
 
-#include "IProductHandler.h"
-#include "ProductUtil.h"
+#include "IProductHandlerV2.h"
 
+using iti::encoding::Encoder;
 using iti::http::Request;
 using iti::http::Response;
 using iti::http::StatusCode;
 using iti::http::router::IRouter;
 using iti::http::router::Mux;
+using iti::http::router::RouteMetrics;
+using iti::http::router::MuxSnapshot;
 using iti::http::router::RoutingContext;
-using nlohmann::json;
 
 using namespace std::chrono_literals;
 
 // we would use a real thread pool in production
-std::list<std::future<evHttpResponse>> eventPool;
+std::list<std::future<std::shared_ptr<evHttpResponse>>> eventPool;
+
+// largest page the listing endpoints serve (`?limit=`)
+constexpr int maxPageSize = 1000;
+
+// largest `?offset=` of a listing: the product handler skips the products
+// before it without reading them, but may still have to walk them to
+// filter them. Deeper pages are reached with `?cursor=`.
+constexpr int maxListingOffset = 10 * maxPageSize;
+
+// most changes `POST /api/v1/inventory/batch` takes at once
+constexpr size_t maxInventoryBatch = 100000;
+
+// encoder returns an encoder streaming into the body of `resp`, in the
+// format negotiated from the Accept header of `req`: JSON (indented with
+// `?pretty=true`), MessagePack or CBOR. If the client accepts none of them,
+// it answers 406 and returns nullptr. The body is sent by `send()`.
+static std::unique_ptr<Encoder> encoder(const Request &req, Response &resp) {
+    // set, not added: an error sent after the encoder was made (see
+    // `send_error()`) asks for one again
+    resp.header.set("Vary", "Accept");
+
+    iti::encoding::Format format;
+    if (!iti::encoding::negotiate(req.header, format)) {
+        resp.status = StatusCode::Status406NotAcceptable;
+        resp.write();
+        return nullptr;
+    }
+
+    resp.header.set("Content-Type", iti::encoding::content_type(format));
+    return iti::encoding::make_encoder(
+        format, [&resp](std::string_view chunk) { resp.append(chunk); },
+        req.url.query().get<bool>("pretty", false));
+}
+
+// send flushes `enc` and sends the response.
+static void send(Encoder &enc, Response &resp) {
+    enc.flush();
+    resp.write();
+}
+
+// write_product writes a product, with the fields of the product handler's
+// JSON.
+static void write_product(Encoder &enc, const iti::ProductDefinition &p) {
+    fmt::format_int id(p.id);
+
+    enc.begin_object();
+    enc.key("id").value(std::string_view(id.data(), id.size()));
+    enc.key("name").value(p.name);
+    enc.key("categories").begin_array();
+    for (auto category : p.categories) {
+        enc.value(category);
+    }
+    enc.end_array();
+    enc.key("metadata").begin_array();
+    for (auto m : p.metadata) {
+        enc.value(m);
+    }
+    enc.end_array();
+    enc.key("general-details").value(p.generalDetails);
+    enc.end_object();
+}
+
+// compact_json tells whether `req` is answered in compact JSON. The JSON the
+// product handler writes is then copied into the body as it is (see
+// `Writer::raw()`), rather than visited and encoded again; the encoder is a
+// json::Writer.
+static bool compact_json(const Request &req) {
+    iti::encoding::Format format;
+    return iti::encoding::negotiate(req.header, format) &&
+           format == iti::encoding::Format::json &&
+           !req.url.query().get<bool>("pretty", false);
+}
+
+// send_error answers `status`, with a `{"code", "message"}` body.
+static void send_error(const Request &req, Response &resp, int status,
+                       std::string_view message) {
+    auto enc = encoder(req, resp);
+    if (enc == nullptr) {
+        return;
+    }
+
+    resp.status = status;
+    enc->begin_object();
+    enc->key("code").value(status);
+    enc->key("message").value(message);
+    enc->end_object();
+    send(*enc, resp);
+}
+
+// send_read_error answers 400, telling why the body couldn't be read.
+static void send_read_error(const Request &req, Response &resp,
+                            const iti::json::Reader &reader) {
+    send_error(req, resp, StatusCode::Status400BadRequest,
+               fmt::format("invalid body: {} at offset {}",
+                           iti::json::read_error_str(reader.error()),
+                           reader.error_offset()));
+}
+
+// status_of returns the status answered when the product handler fails.
+static int status_of(iti::IProductHandlerV2::ErrorCode err) {
+    using ErrorCode = iti::IProductHandlerV2::ErrorCode;
+    switch (err) {
+    case ErrorCode::INVALID_INPUT_PARAM:
+        return StatusCode::Status400BadRequest;
+    case ErrorCode::NOT_FOUND:
+        return StatusCode::Status404NotFound;
+    case ErrorCode::INCORRECT_STATE:
+        return StatusCode::Status409Conflict;
+    case ErrorCode::NOT_IMPLEMENTED:
+        return StatusCode::Status501NotImplemented;
+    case ErrorCode::RESOURCE_UNAVAILABLE:
+    case ErrorCode::PARTIAL_RESOURCE_UNAVAILABLE:
+    case ErrorCode::NOT_READY:
+        return StatusCode::Status503ServiceUnavailable;
+    default:
+        return StatusCode::Status500InternalServerError;
+    }
+}
 
 // we use libevent (non-blocking) as the webserver
 // evHttpHandleRequest is generic handler we use for all the requests
 // it grabs the request data and router and pushes all the actual work of
 // processing the request to a new thread
-static void evHttpHandleRequest(struct evhttp_request *req, void *pRouter) {
+static void evHttpHandleRequest(struct evhttp_request *req, void *pRoutes) {
 
     if (req == nullptr) {
         throw std::logic_error("evHttpHandleRequest: request is a nullptr!");
     }
 
-    if (pRouter == nullptr) {
-        throw std::logic_error("evHttpHandleRequest: router is a nullptr!");
+    if (pRoutes == nullptr) {
+        throw std::logic_error("evHttpHandleRequest: routes is a nullptr!");
     }
 
     // do all the actual work in a new thread
-    eventPool.emplace_back(
-        std::async(std::launch::async, [req, pRouter]() -> evHttpResponse {
-            evHttpResponse resp(req);
-            Request r;
-            r.url = iti::http::Uri::parse(evhttp_request_get_uri(req));
+    // requests and responses are recycled through object pools, so that
+    // steady-state traffic reuses their buffers instead of reallocating them
+    eventPool.emplace_back(std::async(
+        std::launch::async,
+        [req, pRoutes]() -> std::shared_ptr<evHttpResponse> {
+            auto resp = iti::ObjectPool<evHttpResponse>::acquire();
+            resp->set_request(req);
+
+            auto pReq = iti::ObjectPool<Request>::acquire();
+            Request &r = *pReq;
+            iti::http::Uri::parse(evhttp_request_get_uri(req), r.url);
 
             // populate request method
             switch (req->type) {
@@ -99,10 +232,13 @@ static void evHttpHandleRequest(struct evhttp_request *req, void *pRouter) {
             }
 
             // populate request headers
+            // the fields are views into the libevent request, which stays
+            // alive until the response is sent; the Request isn't read after
+            // that
             auto const headers = evhttp_request_get_input_headers(req);
             for (auto header = headers->tqh_first; header;
                  header      = header->next.tqe_next) {
-                r.header.add(header->key, header->value);
+                r.header.add_view(header->key, header->value);
             }
 
             // pull the body content out of the request
@@ -112,10 +248,16 @@ static void evHttpHandleRequest(struct evhttp_request *req, void *pRouter) {
             if (bufLen > 0) {
                 r.body.resize(bufLen);
                 evbuffer_remove(buf, r.body.data(), bufLen);
-                r.body.resize(r.body.find('\0'));
+                if (auto nul = r.body.find('\0'); nul != std::string::npos) {
+                    r.body.resize(nul);
+                }
             }
 
-            ((Mux *)pRouter)->handle_request(r, resp);
+            ((MuxSnapshot *)pRoutes)->handle_request(r, *resp);
+
+            // the request, and its arena, go back to the pool once the
+            // response has been sent
+            resp->attach(std::move(pReq));
 
             return resp;
         }));
@@ -132,88 +274,513 @@ int main() {
 
     CfgService &cfg = CfgService::GetInstance();
 
+    // per-route runtime statistics, served on /debug/routes
+    RouteMetrics routeMetrics;
+
+    // routes serves requests from the most recently published router. A new
+    // router (e.g. with feature routes enabled) can be published at any time
+    // without restarting the server.
+    // Both are locals: their destructors retire memory through "epoch.h",
+    // whose own statics must still be alive then.
+    MuxSnapshot routes;
+
     std::shared_ptr<Mux> router = std::make_shared<Mux>();
 
     iti::ProductHandlerFactory factory;
-    std::shared_ptr<iti::IProductHandler> productHandler;
-    productHandler.reset(factory.Create(iti::ProductHandlerType::MSSQL));
-    std::wstring configJson = TEXT(R"({"ConnStr" : ")") + StrToWstr(cfg.GetConnectionString()) +
-                              + TEXT(R"("}")");
+    std::shared_ptr<iti::IProductHandlerV2> productHandler;
+    const std::string backend = cfg.GetProductBackend();
+    productHandler.reset(factory.CreateV2(
+        backend == "memory" ? iti::ProductHandlerType::InMemory
+                            : iti::ProductHandlerType::MSSQL));
+    iti::json::Writer configJson;
+    configJson.begin_object()
+        .key("ConnStr")
+        .value(cfg.GetConnectionString())
+        .end_object();
     if (productHandler == nullptr) {
-        std::cerr << "Couldn't create MSSQL product handler\n";
+        std::cerr << "Couldn't create " << backend << " product handler\n";
         return 1;
     } else if (auto err =
-                   productHandler->Init(configJson, nullptr);
-               err != iti::IProductHandler::ErrorCode::SUCCESS) {
+                   productHandler->Init(configJson.str(), nullptr);
+               err != iti::IProductHandlerV2::ErrorCode::SUCCESS) {
         std::cerr << "productHandler->Init() failed: " << (int)err << '\n';
         return 1;
     }
 
+    // the listings in progress, see `GET /api/v1/products?cursor=`
+    CursorRegistry cursors(productHandler,
+                           std::chrono::seconds(cfg.GetCursorTimeout()));
+
     // add all the routes we want to handle to the router
-    router->use(middlewares::trim_trailing_slash);
-    router->use(middlewares::logging);
+    // trim_trailing_slash and logging are fused into a single handler at
+    // compile time, see "router.pipeline.h"
+    router->use(iti::http::router::pipeline_middleware<
+                middlewares::compiled::trim_trailing_slash,
+                middlewares::compiled::logging>());
+    router->use(middlewares::route_metrics(routeMetrics));
     router->get("/", [](const Request &req, Response &resp) {
         std::cout << "Hi There!" << '\n';
         resp.write("Hello from main.cpp");
     });
 
+    // runtime statistics of every route, to find hot and slow routes
+    router->get("/debug/routes", [&routeMetrics](const Request &req,
+                                                 Response &resp) {
+        auto enc = encoder(req, resp);
+        if (enc == nullptr) {
+            return;
+        }
+
+        auto &w = *enc;
+        w.begin_object().key("routes").begin_array();
+        for (const auto &[pattern, stats] : routeMetrics.snapshot()) {
+            w.begin_object();
+            w.key("pattern").value(pattern);
+            w.key("hits").value(stats.hits);
+            w.key("bytesOut").value(stats.bytesOut);
+
+            w.key("arenaBytes").begin_object();
+            w.key("mean").value(
+                stats.hits > 0 ? stats.arenaBytes / stats.hits : 0);
+            w.key("max").value(stats.arenaBytesMax);
+            w.end_object();
+
+            w.key("status").begin_object();
+            w.key("1xx").value(stats.statusClasses[0]);
+            w.key("2xx").value(stats.statusClasses[1]);
+            w.key("3xx").value(stats.statusClasses[2]);
+            w.key("4xx").value(stats.statusClasses[3]);
+            w.key("5xx").value(stats.statusClasses[4]);
+            w.end_object();
+
+            w.key("latencyNs").begin_object();
+            w.key("mean").value(stats.latencyMeanNs);
+            w.key("p50").value(stats.latencyP50Ns);
+            w.key("p90").value(stats.latencyP90Ns);
+            w.key("p99").value(stats.latencyP99Ns);
+            w.key("p999").value(stats.latencyP999Ns);
+            w.key("max").value(stats.latencyMaxNs);
+            w.end_object();
+
+            w.end_object();
+        }
+        w.end_array().end_object();
+        send(w, resp);
+    });
+
+    // connection pool of the product backend, if it has one (SQL Server):
+    // utilization, how long requests wait for a connection, and the hit rate
+    // of the prepared statement caches
+    router->get("/debug/db", [&productHandler](const Request &req,
+                                               Response &resp) {
+        const auto pool = productHandler->PoolStats();
+        if (!pool) {
+            send_error(req, resp, StatusCode::Status404NotFound,
+                       "the product backend has no connection pool");
+            return;
+        }
+
+        auto enc = encoder(req, resp);
+        if (enc == nullptr) {
+            return;
+        }
+
+        const auto &stats = *pool;
+        auto &w           = *enc;
+        w.begin_object().key("pool").begin_object();
+        w.key("size").value(stats.size);
+        w.key("inUse").value(stats.inUse);
+        w.key("maxSize").value(stats.maxSize);
+        w.key("waiting").value(stats.waiting);
+        w.key("checkouts").value(stats.checkouts);
+        w.key("timeouts").value(stats.timeouts);
+        w.key("waits").value(stats.waits);
+
+        w.key("waitNs").begin_object();
+        w.key("mean").value(
+            stats.checkouts > 0 ? stats.waitNsTotal / stats.checkouts : 0);
+        w.key("max").value(stats.waitNsMax);
+        w.end_object();
+
+        w.key("opened").value(stats.opened);
+        w.key("openFailures").value(stats.openFailures);
+        w.key("deadOnCheckout").value(stats.deadOnCheckout);
+        w.key("evicted").value(stats.evicted);
+        w.end_object();
+
+        if (const auto statements = productHandler->StatementCacheStats()) {
+            const auto lookups = statements->hits + statements->misses;
+            w.key("statements").begin_object();
+            w.key("hits").value(statements->hits);
+            w.key("misses").value(statements->misses);
+            w.key("evictions").value(statements->evictions);
+            w.key("hitRate").value(
+                lookups > 0 ? double(statements->hits) / double(lookups)
+                            : 0.0);
+            w.end_object();
+        }
+        w.end_object();
+        send(w, resp);
+    });
+
     // API routes for "products" resource
-    router->route("/api/v1/products", [&productHandler](
+    router->route("/api/v1/products", [&productHandler, &cursors](
                                           std::shared_ptr<IRouter> r) {
-        r->get("/", [&productHandler](const Request &req, Response &resp) {
-            resp.header.set("Content-Type", "application/json");
-
-            // TODO:
-            // * pull products from the database
-            // * limit?
-            // * paginate?
-            std::wstring jsonStrW;
-            if (auto err = productHandler->GetProductDefinitions(
-                    L"", L"", iti::IProductHandler::StrList(),
-                    iti::IProductHandler::StrList(), CfgService::GetInstance().GetPageSize(),
-                    jsonStrW, nullptr);
-                err == iti::IProductHandler::ErrorCode::SUCCESS) {
-                std::string jsonStr = WstrToStr(jsonStrW);
-                json j2             = json::parse(jsonStr);
-                json j;
-                j["products"] = j2;
-                resp.write(j.dump(4));
+        r->get("/", [&productHandler, &cursors](const Request &req,
+                                                Response &resp) {
+            // ?limit=&offset=&category= (category may be repeated) starts a
+            // listing. A full page comes with a `next` cursor: ?cursor=&limit=
+            // gets the page after it, resuming the listing where it stopped.
+            // The products before an offset are skipped by the handler, but
+            // may have to be walked, so it is capped; cursors cost nothing
+            // to resume.
+            const auto &query = req.url.query();
+            int limit  = int(CfgService::GetInstance().GetPageSize());
+            int offset = 0;
+            const std::string_view cursor = query.get("cursor");
+
+            if ((query.has("limit") && !query.try_get("limit", limit)) ||
+                (query.has("offset") && !query.try_get("offset", offset)) ||
+                limit <= 0 || limit > maxPageSize || offset < 0 ||
+                offset > maxListingOffset) {
+                send_error(req, resp, StatusCode::Status400BadRequest,
+                           fmt::format("limit must be an integer in [1, {}] "
+                                       "and offset one in [0, {}]",
+                                       maxPageSize, maxListingOffset));
+                return;
+            }
+            if (!cursor.empty() && (offset != 0 || query.has("category"))) {
+                send_error(req, resp, StatusCode::Status400BadRequest,
+                           "a cursor carries the filters of its listing: it "
+                           "can't be combined with offset or category");
+                return;
+            }
+
+            const auto categories = query.get_all("category");
+
+            auto enc = encoder(req, resp);
+            if (enc == nullptr) {
+                return;
+            }
+
+            // compact JSON: the page is the JSON array of the handler.
+            // Otherwise the products are written as they are visited,
+            // opening `{"products": [` on the first one. HEAD: the body is
+            // never sent, don't build it.
+            const bool passThrough = !resp.omitBody && compact_json(req);
+            std::string page;
+            int visited = 0;
+            bool opened = false;
+            auto open   = [&] {
+                if (!opened) {
+                    enc->begin_object().key("products").begin_array();
+                    opened = true;
+                }
+            };
+            iti::ProductVisitor visit = [&](const iti::ProductDefinition &p) {
+                visited++;
+                if (!resp.omitBody) {
+                    open();
+                    write_product(*enc, p);
+                }
+            };
+
+            // this request owns the handle until it is put back; it is
+            // closed otherwise, however the request ends
+            CursorRegistry::Owned handle(cursors);
+            auto err = iti::IProductHandlerV2::ErrorCode::SUCCESS;
+            if (!cursor.empty()) {
+                handle.reset(cursors.take(cursor));
+                if (!handle) {
+                    send_error(req, resp, StatusCode::Status410Gone,
+                               "unknown or expired cursor");
+                    return;
+                }
+            } else if (offset > 0) {
+                // an empty visitor skips the products, unread
+                err = productHandler->GetProductDefinitions(
+                    "", "", categories, {}, offset, iti::ProductVisitor(),
+                    handle.out());
+            }
+            // then the page, from the listing or opening it
+            const bool ok = err == iti::IProductHandlerV2::ErrorCode::SUCCESS;
+            if (ok && passThrough) {
+                err = handle ? productHandler->GetNextProductDefinitions(
+                                   handle.get(), limit, page, &visited)
+                             : productHandler->GetProductDefinitions(
+                                   "", "", categories, {}, limit, page,
+                                   handle.out(), &visited);
+            } else if (ok) {
+                err = handle ? productHandler->GetNextProductDefinitions(
+                                   handle.get(), limit, visit)
+                             : productHandler->GetProductDefinitions(
+                                   "", "", categories, {}, limit, visit,
+                                   handle.out());
+            }
+
+            // errors come before any product is visited
+            if (err != iti::IProductHandlerV2::ErrorCode::SUCCESS) {
+                send_error(req, resp, status_of(err),
+                           "the products couldn't be listed");
+                return;
+            }
+
+            // a short page is the last one. HEAD: nobody sees the cursor.
+            std::string next;
+            if (visited == limit && !resp.omitBody) {
+                next = handle.put();
+            }
+            if (resp.omitBody) {
+                resp.write();
+                return;
             }
-        });
-        r->with(middlewares::extract_id)
-            ->get("/{id:[\\d]+}",
-                  [&productHandler](const Request &req, Response &resp) {
-                resp.header.set("Content-Type", "application/json");
 
+            if (passThrough) {
+                static_cast<iti::json::Writer &>(*enc)
+                    .begin_object()
+                    .key("products")
+                    .raw(page);
+            } else {
+                open();
+                enc->end_array();
+            }
+            if (!next.empty()) {
+                enc->key("next").value(next);
+            }
+            enc->end_object();
+            send(*enc, resp);
+        });
+        r->method(
+            iti::http::Method::GET, "/{id:[\\d]+}",
+            iti::http::router::make_pipeline_handler<
+                middlewares::compiled::extract_id>(
+                [&productHandler](const Request &req, Response &resp) {
                 long long id;
-                req.context.try_get_value("id", id);
+                req.context.try_get_value(middlewares::idCtxKey, id);
 
-                // TODO:
-                // pull product from the database
-                std::wstring jsonStrW;
+                // compact JSON: the handler's JSON of the product is the
+                // body's; HEAD: the body is never sent, don't build it
+                const bool passThrough = !resp.omitBody && compact_json(req);
+                std::string json;
+                iti::ProductDefinition product;
                 if (auto err =
-                        productHandler->GetProductDefinitionById(id, jsonStrW);
-                    err == iti::IProductHandler::ErrorCode::SUCCESS) {
-
-                    // json product;
-                    // product["id"]   = id;
-                    // product["name"] = fmt::format("Fake Product {:d}", id);
-
-                std::string jsonStr = WstrToStr(jsonStrW);
-                    json j2             = json::parse(jsonStr);
-                    json j;
-                    j["product"] = j2;
-                    resp.write(j.dump(4));
+                        passThrough
+                            ? productHandler->GetProductDefinitionById(id, json)
+                            : productHandler->GetProductDefinitionById(
+                                  id, product);
+                    err != iti::IProductHandlerV2::ErrorCode::SUCCESS) {
+                    send_error(req, resp, status_of(err),
+                               fmt::format("no product {}", id));
+                    return;
+                }
+
+                auto enc = encoder(req, resp);
+                if (enc == nullptr) {
+                    return;
+                }
+
+                if (resp.omitBody) {
+                    resp.write();
+                    return;
+                }
+
+                enc->begin_object().key("product");
+                if (passThrough) {
+                    static_cast<iti::json::Writer &>(*enc).raw(json);
+                } else {
+                    write_product(*enc, product);
+                }
+                enc->end_object();
+                send(*enc, resp);
+            }));
+        // the body is bound straight to a ProductInput, see "bindings.hpp"
+        r->post("/", [&productHandler](const Request &req, Response &resp) {
+            ProductInput product;
+            iti::json::Reader reader(req.arena.resource());
+            if (!read_body(reader, req.body, product)) {
+                send_read_error(req, resp, reader);
+                return;
+            }
+            if (product.name.empty()) {
+                send_error(req, resp, StatusCode::Status400BadRequest,
+                           "a product needs a name");
+                return;
+            }
+
+            const iti::IProductHandlerV2::StrViewList categories(
+                product.categories.begin(), product.categories.end());
+            const iti::IProductHandlerV2::StrViewList metadata(
+                product.metadata.begin(), product.metadata.end());
+
+            uint64_t id = 0;
+            if (auto err = productHandler->AddProductDefinition(
+                    product.name, product.details, categories, metadata, id);
+                err != iti::IProductHandlerV2::ErrorCode::SUCCESS) {
+                send_error(req, resp, status_of(err),
+                           "the product couldn't be added");
+                return;
+            }
+
+            auto enc = encoder(req, resp);
+            if (enc == nullptr) {
+                return;
+            }
+
+            resp.status = StatusCode::Status201Created;
+            resp.header.set("Location",
+                            fmt::format("/api/v1/products/{}", id));
+            enc->begin_object();
+            enc->key("id").value(id);
+            enc->end_object();
+            send(*enc, resp);
+        });
+        r->method(
+            iti::http::Method::POST, "/{id:[\\d]+}/inventory",
+            iti::http::router::make_pipeline_handler<
+                middlewares::compiled::extract_id>(
+                [&productHandler](const Request &req, Response &resp) {
+                long long id;
+                req.context.try_get_value(middlewares::idCtxKey, id);
+
+                InventoryInput inv;
+                iti::json::Reader reader(req.arena.resource());
+                if (!read_body(reader, req.body, inv)) {
+                    send_read_error(req, resp, reader);
+                    return;
                 }
-            });
+                if ((inv.add == 0) == (inv.remove == 0)) {
+                    send_error(req, resp, StatusCode::Status400BadRequest,
+                               "either add or remove a number of units");
+                    return;
+                }
+
+                uint64_t present = 0;
+                uint64_t removed = 0;
+                auto err =
+                    inv.add > 0
+                        ? productHandler->AddProductInventory(id, inv.add,
+                                                              present)
+                        : productHandler->RemoveProductInventory(
+                              id, inv.remove, removed, present);
+                if (err != iti::IProductHandlerV2::ErrorCode::SUCCESS) {
+                    send_error(req, resp, status_of(err),
+                               "the inventory couldn't be updated");
+                    return;
+                }
+
+                auto enc = encoder(req, resp);
+                if (enc == nullptr) {
+                    return;
+                }
+
+                enc->begin_object();
+                enc->key("id").value(id);
+                enc->key("present").value(present);
+                if (inv.remove > 0) {
+                    enc->key("removed").value(removed);
+                }
+                enc->end_object();
+                send(*enc, resp);
+            }));
+    });
+
+    // API routes for the inventory of many products at once
+    router->route("/api/v1/inventory", [&productHandler](
+                                           std::shared_ptr<IRouter> r) {
+        // the body is bound to an InventoryBatchInput, see "bindings.hpp".
+        // Each change gets its own status; with "all-or-nothing", a change
+        // that fails cancels them all, and gives its status to the response;
+        // the others are then "applied": false, without counts.
+        r->post("/batch", [&productHandler](const Request &req,
+                                            Response &resp) {
+            using iti::IProductHandlerV2;
+
+            InventoryBatchInput batch;
+            iti::json::Reader reader(req.arena.resource());
+            if (!read_body(reader, req.body, batch)) {
+                send_read_error(req, resp, reader);
+                return;
+            }
+            IProductHandlerV2::Atomicity atomicity;
+            if (batch.mode == "all-or-nothing") {
+                atomicity = IProductHandlerV2::Atomicity::AllOrNothing;
+            } else if (batch.mode == "best-effort") {
+                atomicity = IProductHandlerV2::Atomicity::BestEffort;
+            } else {
+                send_error(req, resp, StatusCode::Status400BadRequest,
+                           "mode is either all-or-nothing or best-effort");
+                return;
+            }
+            if (batch.changes.size() > maxInventoryBatch) {
+                send_error(req, resp, StatusCode::Status413PayloadTooLarge,
+                           fmt::format("at most {} changes at once",
+                                       maxInventoryBatch));
+                return;
+            }
+
+            std::vector<IProductHandlerV2::InventoryChange> changes;
+            changes.reserve(batch.changes.size());
+            for (const auto &c : batch.changes) {
+                changes.push_back({c.id, c.delta});
+            }
+            std::vector<IProductHandlerV2::InventoryResult> results;
+            auto err = productHandler->AdjustProductInventories(
+                changes, atomicity, results);
+            if (err != IProductHandlerV2::ErrorCode::SUCCESS &&
+                results.size() != changes.size()) {
+                send_error(req, resp, status_of(err),
+                           "the inventory couldn't be updated");
+                return;
+            }
+
+            auto enc = encoder(req, resp);
+            if (enc == nullptr) {
+                return;
+            }
+
+            const bool applied = err == IProductHandlerV2::ErrorCode::SUCCESS;
+            if (!applied) {
+                resp.status = status_of(err);
+            }
+            enc->begin_object();
+            enc->key("applied").value(applied);
+            enc->key("results").begin_array();
+            for (size_t i = 0; i < changes.size(); i++) {
+                const auto &result = results[i];
+                const bool ok =
+                    result.error == IProductHandlerV2::ErrorCode::SUCCESS;
+                enc->begin_object();
+                enc->key("id").value(changes[i].id);
+                enc->key("status").value(ok ? int(StatusCode::Status200OK)
+                                            : status_of(result.error));
+                if (ok && !applied) {
+                    // it could be made, but another failed, so it wasn't
+                    enc->key("applied").value(false);
+                } else if (ok) {
+                    if (changes[i].delta > 0) {
+                        enc->key("added").value(result.numChanged);
+                    } else if (changes[i].delta < 0) {
+                        enc->key("removed").value(result.numChanged);
+                    }
+                    enc->key("present").value(result.numPresent);
+                }
+                enc->end_object();
+            }
+            enc->end_array();
+            enc->end_object();
+            send(*enc, resp);
+        });
     });
 
+    // make the router live
+    routes.publish(router);
+
     // create event base and http server
     auto evbase = event_base_new();
     auto server = evhttp_new(evbase);
 
     // bind callbacks
-    evhttp_set_gencb(server, evHttpHandleRequest, router.get());
+    evhttp_set_gencb(server, evHttpHandleRequest, &routes);
 
     // bind http server to socket
     uint16_t port = cfg.GetServerPort();
@@ -228,6 +795,9 @@ int main() {
             auto rtn = event_base_loop(evbase, EVLOOP_NONBLOCK);
             if (rtn == -1) {
                 std::cerr << "Error with event loop!" << '\n';
+                // wait for the requests in flight, which use `routes`
+                eventPool.clear();
+                cursors.close_all();
                 if (productHandler != nullptr)
                     productHandler->Shutdown();
                 return 1;
@@ -237,10 +807,13 @@ int main() {
             for (auto it = eventPool.begin(); it != eventPool.end();) {
                 if (it->wait_for(0ns) == std::future_status::ready) {
                     auto resp = it->get();
-                    if (resp.get_ready_to_send()) {
-                        resp.process_response();
+                    if (resp->get_ready_to_send()) {
+                        resp->process_response();
                     }
-                    if (resp.get_response_sent()) {
+                    if (resp->get_response_sent()) {
+                        iti::ObjectPool<Request>::release(resp->detach());
+                        iti::ObjectPool<evHttpResponse>::release(
+                            std::move(resp));
                         it = eventPool.erase(it);
                     } else {
                         // if we didn't send the response for some reason then
@@ -258,6 +831,7 @@ int main() {
         std::cerr << "Could not bind to 127.0.0.1:" << port << '\n';
     }
 
+    cursors.close_all();
     if (productHandler != nullptr)
         productHandler->Shutdown();
 
@@ -11,12 +11,25 @@
 #include "StrUtils.h"
 #include "http.h"
 #include "router.h"
+#include "router.metrics.h"
+#include "router.pipeline.h"
 
 namespace middlewares {
-std::shared_ptr<iti::http::IHandler>
-logging(std::shared_ptr<iti::http::IHandler> next) {
-	auto func = [nxt = std::move(next)](const iti::http::Request &req,
-	                                    iti::http::Response &resp) {
+
+// idCtxKey is the request context key `extract_id` stores the parsed `{id}`
+// URL parameter under.
+inline const iti::ContextKey<long long> idCtxKey{"id"};
+
+// compiled middlewares are the pipeline middleware types (see
+// "router.pipeline.h"). Compose them at compile time with
+// `iti::http::router::pipeline<...>()`; the functions further down wrap the
+// same implementations for `IRouter::use()` and `IRouter::with()`.
+namespace compiled {
+
+struct logging {
+	template <class Next>
+	void handle_request(const iti::http::Request &req,
+	                    iti::http::Response &resp, Next &next) {
 		using iti::http::router::RoutingContext;
 		using clock_type = std::chrono::high_resolution_clock;
 
@@ -26,7 +39,7 @@ logging(std::shared_ptr<iti::http::IHandler> next) {
 
 		std::string_view path{rctx->routePath};
 		if (path.empty()) {
-			path = req.url.path;
+			path = req.url.path();
 		}
 
 		std::chrono::time_point<clock_type> begin = clock_type::now();
@@ -38,9 +51,7 @@ logging(std::shared_ptr<iti::http::IHandler> next) {
 
 		std::cout << msg << '\n';
 
-		if (nxt != nullptr) {
-			nxt->handle_request(req, resp);
-		}
+		next(req, resp);
 
 		auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
 		    clock_type::now() - begin);
@@ -48,15 +59,13 @@ logging(std::shared_ptr<iti::http::IHandler> next) {
 		msg = fmt::format("LoggingMiddleware: {}: Exit {}", pReq,
 		                  iti::strutils::humanize_duration(duration));
 		std::cout << msg << '\n';
-	};
-
-	return iti::http::IHandler::make_handler(new iti::http::BasicHandler(func));
-}
+	}
+};
 
-std::shared_ptr<iti::http::IHandler>
-trim_trailing_slash(std::shared_ptr<iti::http::IHandler> next) {
-	auto func = [nxt = std::move(next)](const iti::http::Request &req,
-	                                    iti::http::Response &resp) {
+struct trim_trailing_slash {
+	template <class Next>
+	void handle_request(const iti::http::Request &req,
+	                    iti::http::Response &resp, Next &next) {
 		using iti::http::router::RoutingContext;
 
 		// get or create routing context
@@ -65,28 +74,25 @@ trim_trailing_slash(std::shared_ptr<iti::http::IHandler> next) {
 
 		// make sure we populate routePath
 		if (rctx->routePath.empty()) {
-			rctx->routePath = req.url.path;
+			rctx->routePath = req.url.path();
 		}
 
 		// trim the trailing slash ('/')
 		// we don't want to empty the path
 		auto newroutePathSize = rctx->routePath.size() - 1;
-		if (newroutePathSize > 0 && rctx->routePath[newroutePathSize] == '/') {
+		if (newroutePathSize > 0 &&
+		    rctx->routePath[newroutePathSize] == '/') {
 			rctx->routePath.resize(newroutePathSize);
 		}
 
-		if (nxt != nullptr) {
-			nxt->handle_request(req, resp);
-		}
-	};
-
-	return iti::http::IHandler::make_handler(new iti::http::BasicHandler(func));
-}
+		next(req, resp);
+	}
+};
 
-std::shared_ptr<iti::http::IHandler>
-extract_id(std::shared_ptr<iti::http::IHandler> next) {
-	auto func = [nxt = std::move(next)](const iti::http::Request &req,
-	                                    iti::http::Response &resp) {
+struct extract_id {
+	template <class Next>
+	void handle_request(const iti::http::Request &req,
+	                    iti::http::Response &resp, Next &next) {
 		using iti::http::StatusCode;
 		using iti::http::router::RoutingContext;
 		using nlohmann::json;
@@ -116,20 +122,68 @@ extract_id(std::shared_ptr<iti::http::IHandler> next) {
 
 			json j;
 			j["code"]    = resp.status;
-			j["message"] = req.url.path + ": id not found or is 0";
+			j["message"] =
+			    fmt::format("{}: id not found or is 0", req.url.path());
 
 			resp.write(j.dump(4));
 			return;
 		}
 
-		req.context.set_value("id", id);
+		req.context.set_value(idCtxKey, id);
 
-		if (nxt != nullptr) {
-			nxt->handle_request(req, resp);
-		}
+		next(req, resp);
+	}
+};
+
+} // namespace compiled
+
+std::shared_ptr<iti::http::IHandler>
+logging(std::shared_ptr<iti::http::IHandler> next) {
+	return iti::http::router::adapt_middleware<compiled::logging>(
+	    std::move(next));
+}
+
+// route_metrics records hits, status classes, bytes out, request arena usage
+// and latency for the route that served each request into `metrics`.
+iti::http::router::middleware
+route_metrics(iti::http::router::RouteMetrics &metrics) {
+	return [&metrics](std::shared_ptr<iti::http::IHandler> next) {
+		auto func = [&metrics, nxt = std::move(next)](
+		                const iti::http::Request &req,
+		                iti::http::Response &resp) {
+			using iti::http::router::RoutingContext;
+			using clock_type = std::chrono::steady_clock;
+
+			// get or create routing context
+			std::shared_ptr<RoutingContext> rctx =
+			    RoutingContext::get_create_ctx_from_request(req);
+
+			auto begin = clock_type::now();
+
+			if (nxt != nullptr) {
+				nxt->handle_request(req, resp);
+			}
+
+			metrics.record(*rctx, resp.status, resp.get_body_size(),
+			               clock_type::now() - begin,
+			               req.arena.bytes_allocated());
+		};
+
+		return iti::http::IHandler::make_handler(
+		    new iti::http::BasicHandler(func));
 	};
+}
 
-	return iti::http::IHandler::make_handler(new iti::http::BasicHandler(func));
+std::shared_ptr<iti::http::IHandler>
+trim_trailing_slash(std::shared_ptr<iti::http::IHandler> next) {
+	return iti::http::router::adapt_middleware<compiled::trim_trailing_slash>(
+	    std::move(next));
+}
+
+std::shared_ptr<iti::http::IHandler>
+extract_id(std::shared_ptr<iti::http::IHandler> next) {
+	return iti::http::router::adapt_middleware<compiled::extract_id>(
+	    std::move(next));
 }
 
 } // namespace middlewares
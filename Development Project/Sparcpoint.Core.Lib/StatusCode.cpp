@@ -634,7 +634,7 @@ static const constexpr std::array<std::string_view, 512> statusCodeStrTable = {
     empty_sv,                              // 98
     empty_sv,                              // 99
     "100 Continue",                        // 100
-    "101 Switching Protocol",              // 101
+    "101 Switching Protocols",             // 101
     "102 Processing",                      // 102
     "103 Early Hints",                     // 103
     empty_sv,                              // 104
@@ -739,7 +739,7 @@ static const constexpr std::array<std::string_view, 512> statusCodeStrTable = {
     "203 Non-Authoritative Information",   // 203
     "204 No Content",                      // 204
     "205 Reset Content",                   // 205
-    "206 Parital Content",                 // 206
+    "206 Partial Content",                 // 206
     "207 Multi-Status",                    // 207
     "208 Already Reported",                // 208
     empty_sv,                              // 209
@@ -833,10 +833,10 @@ static const constexpr std::array<std::string_view, 512> statusCodeStrTable = {
     empty_sv,                              // 297
     empty_sv,                              // 298
     empty_sv,                              // 299
-    "300 Multiple Choice",                 // 300
+    "300 Multiple Choices",                // 300
     "301 Moved Permanently",               // 301
     "302 Found",                           // 302
-    "303 SeeOther",                        // 303
+    "303 See Other",                       // 303
     "304 Not Modified",                    // 304
     "305 Use Proxy",                       // 305
     empty_sv,                              // 306
@@ -937,7 +937,7 @@ static const constexpr std::array<std::string_view, 512> statusCodeStrTable = {
     "401 Unauthorized",                    // 401
     "402 Payment Required",                // 402
     "403 Forbidden",                       // 403
-    "404 NotFound",                        // 404
+    "404 Not Found",                       // 404
     "405 Method Not Allowed",              // 405
     "406 Not Acceptable",                  // 406
     "407 Proxy Authentication Required",   // 407
@@ -1047,6 +1047,19 @@ static const constexpr std::array<std::string_view, 512> statusCodeStrTable = {
     "511 Network Authentication Required", // 511
 };
 
+// reasonPhraseTable holds the reason phrase of each status code: its entry in
+// `statusCodeStrTable`, without the "NNN " prefix. As a suffix of a literal,
+// each phrase is NUL-terminated.
+static const constexpr std::array<std::string_view, 512> reasonPhraseTable =
+    [] {
+	    std::array<std::string_view, 512> table{};
+	    for (size_t i = 0; i < table.size(); i++) {
+		    auto str = statusCodeStrTable[i];
+		    table[i] = str.size() > 4 ? str.substr(4) : std::string_view();
+	    }
+	    return table;
+    }();
+
 // StatusCode
 // ----------------------------------------------------------------------------
 
@@ -1083,4 +1096,12 @@ std::string_view iti::http::StatusCode::str() const {
 	throw std::logic_error(fmt::format("unhandled status code {}", value));
 }
 
+std::string_view
+iti::http::StatusCode::reason_phrase(int rawStatusCode) noexcept {
+	if (rawStatusCode >= 0 && rawStatusCode < int(reasonPhraseTable.size())) {
+		return reasonPhraseTable[rawStatusCode];
+	}
+	return std::string_view();
+}
+
 #endif // ITI_LIB_HTTP_STATUSCODE_CPP
@@ -13,6 +13,11 @@ class StatusCode {
 	static StatusCode parse(int rawStatusCode);
 	static bool try_parse(int rawStatusCode, StatusCode &statusCode);
 
+	// reason_phrase returns the reason phrase of `rawStatusCode` ("Not
+	// Found"), or an empty view if it isn't a known status code. The phrase
+	// is NUL-terminated, so it can be handed to C APIs as is.
+	static std::string_view reason_phrase(int rawStatusCode) noexcept;
+
 	enum Value : int {
 		Status100Continue          = 100,
 		Status101SwitchingProtocol = 101,
@@ -94,6 +99,7 @@ class StatusCode {
 	}
 	constexpr Value operator()() const { return value; }
 	std::string_view str() const;
+	std::string_view reason() const { return reason_phrase(value); }
 
   private:
 	Value value;
@@ -40,12 +40,12 @@ static const constexpr std::string_view empty_sv{""};
 	 std::is_convertible_v<TPY, std::wstring> ||                               \
 	 std::is_convertible_v<TPY, std::wstring_view>)
 
-static inline bool iequals(const std::string &a, const std::string &b) {
+static inline bool iequals(std::string_view a, std::string_view b) {
 	return std::equal(a.begin(), a.end(), b.begin(), b.end(),
 	                  [](char a, char b) { return tolower(a) == tolower(b); });
 }
 
-static inline bool iequals(const std::wstring &a, const std::wstring &b) {
+static inline bool iequals(std::wstring_view a, std::wstring_view b) {
 	return std::equal(
 	    a.begin(), a.end(), b.begin(), b.end(),
 	    [](wchar_t a, wchar_t b) { return towlower(a) == towlower(b); });
@@ -0,0 +1,38 @@
+#ifndef ITI_LIB_ARENA_CPP
+#define ITI_LIB_ARENA_CPP
+
+#include "pch.h"
+
+#include "arena.h"
+
+// request arena
+// ----------------------------------------------------------------------------
+iti::RequestArena::RequestArena() {
+	buffer.emplace(block, inlineSize, &upstream);
+}
+
+void iti::RequestArena::release() {
+	// a fresh monotonic resource starts over at the beginning of the inline
+	// block; destroying the old one hands its overflow back to the heap
+	buffer.emplace(block, inlineSize, &upstream);
+	allocated          = 0;
+	upstream.allocated = 0;
+}
+
+void *iti::RequestArena::do_allocate(size_t bytes, size_t alignment) {
+	allocated += bytes;
+	return buffer->allocate(bytes, alignment);
+}
+
+void *iti::RequestArena::CountingResource::do_allocate(size_t bytes,
+                                                       size_t alignment) {
+	allocated += bytes;
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void iti::RequestArena::CountingResource::do_deallocate(void *p, size_t bytes,
+                                                        size_t alignment) {
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+#endif // ITI_LIB_ARENA_CPP
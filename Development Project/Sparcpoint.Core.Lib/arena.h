@@ -0,0 +1,81 @@
+#ifndef ITI_LIB_ARENA_H
+#define ITI_LIB_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+namespace iti {
+
+// RequestArena is a monotonic `std::pmr::memory_resource` holding everything
+// a single request allocates: URI parts, header keys and values, route
+// parameters and the routing context itself.
+//
+//	std::pmr::string s{"scratch", req.arena.resource()};
+//
+// Allocations are a pointer bump into an inline block; only what doesn't fit
+// goes to the heap. Nothing is freed one by one: `release()` drops it all at
+// once when the response has been sent. The arena is embedded in pooled
+// requests (see "pool.h"), so the inline block is reused from one request to
+// the next and steady-state traffic doesn't touch the heap at all.
+//
+// Containers allocating from the arena must be emptied (or destroyed)
+// before `release()`, as their memory is reused afterwards.
+class RequestArena : public std::pmr::memory_resource {
+  public:
+	// size of the inline block
+	static constexpr size_t inlineSize = 8 * 1024;
+
+	RequestArena();
+
+	RequestArena(const RequestArena &) = delete;
+	RequestArena &operator=(const RequestArena &) = delete;
+
+	std::pmr::memory_resource *resource() { return this; }
+
+	// bytes_allocated returns the number of bytes handed out since the last
+	// `release()`.
+	size_t bytes_allocated() const { return allocated; }
+
+	// bytes_upstream returns the number of bytes that didn't fit in the
+	// inline block and came from the heap since the last `release()`.
+	size_t bytes_upstream() const { return upstream.allocated; }
+
+	// release frees everything allocated from the arena at once.
+	void release();
+
+  protected:
+	void *do_allocate(size_t bytes, size_t alignment) override;
+
+	// memory is only reclaimed by `release()`
+	void do_deallocate(void *, size_t, size_t) override {}
+
+	bool do_is_equal(const std::pmr::memory_resource &other) const
+	    noexcept override {
+		return this == &other;
+	}
+
+  private:
+	// CountingResource forwards to the heap, counting the bytes it hands out.
+	class CountingResource : public std::pmr::memory_resource {
+	  public:
+		size_t allocated = 0;
+
+	  protected:
+		void *do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource &other) const
+		    noexcept override {
+			return this == &other;
+		}
+	};
+
+	alignas(std::max_align_t) std::byte block[inlineSize];
+	CountingResource upstream;
+	std::optional<std::pmr::monotonic_buffer_resource> buffer;
+	size_t allocated = 0;
+};
+
+} // namespace iti
+
+#endif // ITI_LIB_ARENA_H
@@ -0,0 +1,88 @@
+#ifndef ITI_LIB_BENCH_H
+#define ITI_LIB_BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Helpers of the micro-benchmarks, the `*.bench.cpp` programs next to the
+// code they measure. They aren't part of the library: each benchmark is a
+// program of its own, built and run with "run.sh".
+//
+// Where a change replaced an implementation, its benchmark keeps a copy of
+// the old code under `namespace before`, so that one run prints both.
+
+namespace iti {
+namespace bench {
+
+// keep makes the compiler believe `value` is used, so that the work
+// computing it isn't optimized away.
+template <class T> void keep(T value) {
+	static volatile T sink;
+	sink = value;
+	(void)sink;
+}
+
+// run calls `f` `iterations` times, `rounds` times over, and prints the time
+// per call of the fastest round. The first rounds warm up caches and pools.
+template <class F>
+double run(const char *name, size_t iterations, F &&f, int rounds = 5) {
+	double best = 0;
+	for (int r = 0; r < rounds; r++) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) {
+			f();
+		}
+		std::chrono::duration<double, std::nano> elapsed =
+		    std::chrono::steady_clock::now() - start;
+		double ns = elapsed.count() / double(iterations);
+		if (r == 0 || ns < best) {
+			best = ns;
+		}
+	}
+	std::printf("%-52s %10.1f ns\n", name, best);
+	return best;
+}
+
+// allocations returns the number of calls to the global operator new so far,
+// in a benchmark that defined ITI_BENCH_COUNT_ALLOCATIONS before including
+// this header (it replaces operator new to count them).
+inline size_t &allocations() {
+	static size_t count = 0;
+	return count;
+}
+
+// count_allocations prints the number of allocations per call of `f`, once
+// it is warm.
+template <class F>
+double count_allocations(const char *name, size_t iterations, F &&f) {
+	for (size_t i = 0; i < iterations; i++) {
+		f();
+	}
+	size_t start = allocations();
+	for (size_t i = 0; i < iterations; i++) {
+		f();
+	}
+	double perCall = double(allocations() - start) / double(iterations);
+	std::printf("%-52s %10.2f allocations\n", name, perCall);
+	return perCall;
+}
+
+} // namespace bench
+} // namespace iti
+
+#ifdef ITI_BENCH_COUNT_ALLOCATIONS
+void *operator new(size_t size) {
+	iti::bench::allocations()++;
+	if (void *p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+#endif
+
+#endif // ITI_LIB_BENCH_H
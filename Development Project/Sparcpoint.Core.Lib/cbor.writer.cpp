@@ -0,0 +1,169 @@
+#ifndef ITI_LIB_CBOR_WRITER_CPP
+#define ITI_LIB_CBOR_WRITER_CPP
+
+#include "pch.h"
+
+#include "cbor.writer.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using iti::cbor::Writer;
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+// major types (RFC 8949, section 3.1)
+static constexpr uint8_t majorUnsigned = 0;
+static constexpr uint8_t majorNegative = 1;
+static constexpr uint8_t majorText     = 3;
+static constexpr uint8_t majorArray    = 4;
+static constexpr uint8_t majorMap      = 5;
+
+// simple values and markers
+static constexpr uint8_t cborFalse      = 0xf4;
+static constexpr uint8_t cborTrue       = 0xf5;
+static constexpr uint8_t cborNull       = 0xf6;
+static constexpr uint8_t cborFloat16    = 0xf9;
+static constexpr uint8_t cborFloat32    = 0xfa;
+static constexpr uint8_t cborFloat64    = 0xfb;
+static constexpr uint8_t cborBreak      = 0xff;
+static constexpr uint8_t cborIndefinite = 31;
+
+// `put_be()` appends the `n` low bytes of `v` to `out`, big-endian first.
+static inline void put_be(std::string &out, uint64_t v, size_t n) {
+	for (size_t i = n; i > 0; i--) {
+		out.push_back(char((v >> (8 * (i - 1))) & 0xff));
+	}
+}
+
+// writer
+// ----------------------------------------------------------------------------
+Writer &iti::cbor::Writer::begin_object() {
+	buf.push_back(char((majorMap << 5) | cborIndefinite));
+	depth++;
+	return *this;
+}
+
+Writer &iti::cbor::Writer::end_object() {
+	if (depth == 0) {
+		throw std::logic_error("cbor::Writer: unexpected end of map");
+	}
+	buf.push_back(char(cborBreak));
+	depth--;
+	return done();
+}
+
+Writer &iti::cbor::Writer::begin_array() {
+	buf.push_back(char((majorArray << 5) | cborIndefinite));
+	depth++;
+	return *this;
+}
+
+Writer &iti::cbor::Writer::end_array() {
+	if (depth == 0) {
+		throw std::logic_error("cbor::Writer: unexpected end of array");
+	}
+	buf.push_back(char(cborBreak));
+	depth--;
+	return done();
+}
+
+Writer &iti::cbor::Writer::key(std::string_view k) {
+	head(majorText, k.size());
+	buf.append(k.data(), k.size());
+	return *this;
+}
+
+iti::encoding::Encoder &iti::cbor::Writer::write_string(std::string_view v) {
+	head(majorText, v.size());
+	buf.append(v.data(), v.size());
+	return done();
+}
+
+iti::encoding::Encoder &iti::cbor::Writer::write_bool(bool v) {
+	buf.push_back(char(v ? cborTrue : cborFalse));
+	return done();
+}
+
+iti::encoding::Encoder &iti::cbor::Writer::write_null() {
+	buf.push_back(char(cborNull));
+	return done();
+}
+
+iti::encoding::Encoder &iti::cbor::Writer::write_int(int64_t v) {
+	if (v >= 0) {
+		head(majorUnsigned, uint64_t(v));
+	} else {
+		// -1 - n, computed without overflowing on the minimum
+		head(majorNegative, ~uint64_t(v));
+	}
+	return done();
+}
+
+iti::encoding::Encoder &iti::cbor::Writer::write_uint(uint64_t v) {
+	head(majorUnsigned, v);
+	return done();
+}
+
+iti::encoding::Encoder &iti::cbor::Writer::write_double(double v) {
+	// NaN and the infinities fit in a float16
+	if (std::isnan(v)) {
+		buf.push_back(char(cborFloat16));
+		put_be(buf, 0x7e00, 2);
+		return done();
+	}
+	if (std::isinf(v)) {
+		buf.push_back(char(cborFloat16));
+		put_be(buf, v > 0 ? 0x7c00 : 0xfc00, 2);
+		return done();
+	}
+
+	// a float32 is enough if it holds the value exactly. Narrowing a double
+	// out of float's range is undefined: check it first, as nlohmann does.
+	const bool inRange = v >= double(std::numeric_limits<float>::lowest()) &&
+	                     v <= double(std::numeric_limits<float>::max());
+	const float f      = inRange ? static_cast<float>(v) : 0.0f;
+	if (inRange && double(f) == v) {
+		uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		buf.push_back(char(cborFloat32));
+		put_be(buf, bits, 4);
+	} else {
+		uint64_t bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		buf.push_back(char(cborFloat64));
+		put_be(buf, bits, 8);
+	}
+	return done();
+}
+
+void iti::cbor::Writer::flush() {
+	if (sink && !buf.empty()) {
+		sink(buf);
+		buf.clear();
+	}
+}
+
+void iti::cbor::Writer::head(uint8_t major, uint64_t arg) {
+	uint8_t type = uint8_t(major << 5);
+	if (arg < 24) {
+		buf.push_back(char(type | arg));
+	} else if (arg <= std::numeric_limits<uint8_t>::max()) {
+		buf.push_back(char(type | 24));
+		put_be(buf, arg, 1);
+	} else if (arg <= std::numeric_limits<uint16_t>::max()) {
+		buf.push_back(char(type | 25));
+		put_be(buf, arg, 2);
+	} else if (arg <= std::numeric_limits<uint32_t>::max()) {
+		buf.push_back(char(type | 26));
+		put_be(buf, arg, 4);
+	} else {
+		buf.push_back(char(type | 27));
+		put_be(buf, arg, 8);
+	}
+}
+
+#endif // ITI_LIB_CBOR_WRITER_CPP
@@ -0,0 +1,76 @@
+#ifndef ITI_LIB_CBOR_WRITER_H
+#define ITI_LIB_CBOR_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "encoding.h"
+
+namespace iti {
+namespace cbor {
+
+// Writer streams CBOR (RFC 8949) to a sink, using the smallest encoding of
+// each value, as `nlohmann::json::to_cbor` does.
+//
+// Maps and arrays are written with an indefinite length (closed by a
+// "break" byte), so nothing needs patching and the output is handed to the
+// sink in chunks of about `flushSize` bytes as it is written, and whatever
+// is left on `flush()`.
+class Writer : public iti::encoding::Encoder {
+  public:
+	using Sink = iti::encoding::Sink;
+
+	// size of the chunks handed to the sink
+	static constexpr size_t flushSize = 4 * 1024;
+
+	explicit Writer(Sink sink = nullptr) : sink(std::move(sink)) {}
+
+	Writer(const Writer &) = delete;
+	Writer &operator=(const Writer &) = delete;
+
+	iti::encoding::Format format() const override {
+		return iti::encoding::Format::cbor;
+	}
+
+	Writer &begin_object() override;
+	Writer &end_object() override;
+	Writer &begin_array() override;
+	Writer &end_array() override;
+	Writer &key(std::string_view k) override;
+
+	void flush() override;
+
+	// str returns the output of a Writer without a sink.
+	std::string_view str() const { return buf; }
+
+  protected:
+	Encoder &write_string(std::string_view v) override;
+	Encoder &write_bool(bool v) override;
+	Encoder &write_null() override;
+	Encoder &write_int(int64_t v) override;
+	Encoder &write_uint(uint64_t v) override;
+	Encoder &write_double(double v) override;
+
+  private:
+	// head writes the initial bytes of a data item: its major type and
+	// argument (RFC 8949, section 3).
+	void head(uint8_t major, uint64_t arg);
+
+	Writer &done() {
+		if (sink && buf.size() >= flushSize) {
+			flush();
+		}
+		return *this;
+	}
+
+	Sink sink;
+	std::string buf;
+	size_t depth = 0;
+};
+
+} // namespace cbor
+} // namespace iti
+
+#endif // ITI_LIB_CBOR_WRITER_H
@@ -0,0 +1,147 @@
+// cbor::Writer tests (see "test.h"): ./run.sh cbor.writer.test.cpp
+//
+// Scalars are compared byte for byte with `nlohmann::json::to_cbor`, which
+// also writes the smallest encoding of each value. Maps and arrays are not:
+// to_cbor writes their length up front, the Writer an indefinite length, so
+// documents are compared once decoded by `nlohmann::json::from_cbor`.
+
+#include "test.h"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "cbor.writer.h"
+
+using iti::cbor::Writer;
+using json = nlohmann::ordered_json;
+
+static std::string to_cbor(const json &j) {
+	auto bytes = json::to_cbor(j);
+	return std::string(bytes.begin(), bytes.end());
+}
+
+template <class T> static bool same_as_nlohmann(T v) {
+	Writer w;
+	w.value(v);
+	return w.str() == to_cbor(json(v));
+}
+
+static void scalars() {
+	for (int64_t v : {0LL, 23LL, 24LL, 255LL, 256LL, 65535LL, 65536LL,
+	                  4294967295LL, 4294967296LL, -1LL, -24LL, -25LL, -256LL,
+	                  -257LL, -65536LL, -65537LL, -4294967296LL,
+	                  -4294967297LL}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<int64_t>::min()));
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<uint64_t>::max()));
+
+	// float32 when it holds the value exactly, float64 otherwise
+	for (double v : {0.0, 0.5, -3.25, 1e10, 0.1, 9.99, 1e300, -1e-300}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+	// out of float's range, which can't be narrowed to check, and NaN and
+	// the infinities, which are float16
+	for (double v : {double(std::numeric_limits<float>::max()),
+	                 double(std::numeric_limits<float>::lowest()), 1e39,
+	                 -1e39, std::numeric_limits<double>::max(),
+	                 std::numeric_limits<double>::infinity(),
+	                 -std::numeric_limits<double>::infinity(),
+	                 std::numeric_limits<double>::quiet_NaN()}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+
+	for (size_t n : {0, 23, 24, 255, 256, 65535, 65536}) {
+		ITI_CHECK(same_as_nlohmann(std::string(n, 'x')));
+	}
+	ITI_CHECK(same_as_nlohmann(true));
+	ITI_CHECK(same_as_nlohmann(false));
+	ITI_CHECK(same_as_nlohmann(nullptr));
+}
+
+// containers: indefinite-length maps and arrays, closed by a break byte
+static void containers() {
+	Writer w;
+	w.begin_object().key("a").begin_array().value(1).value(2);
+	w.end_array().end_object();
+	ITI_CHECK(w.str() == std::string("\xbf\x61\x61\x9f\x01\x02\xff\xff", 8));
+}
+
+// documents: nested maps and arrays, as a listing of products is
+static void documents() {
+	Writer w;
+	json j = json::array();
+	w.begin_array();
+	for (int p = 0; p < 20; p++) {
+		json product = {{"id", p},
+		                {"name", "Product " + std::to_string(p)},
+		                {"price", p * 1.25},
+		                {"active", p % 2 == 0},
+		                {"description", nullptr}};
+		w.begin_object();
+		w.key("id").value(p);
+		w.key("name").value("Product " + std::to_string(p));
+		w.key("price").value(p * 1.25);
+		w.key("active").value(p % 2 == 0);
+		w.key("description").value(nullptr);
+
+		json categories = json::array();
+		w.key("categories").begin_array();
+		for (int c = 0; c < p; c++) {
+			w.begin_object().key("id").value(c).end_object();
+			categories.push_back({{"id", c}});
+		}
+		w.end_array();
+		product["categories"] = categories;
+
+		w.key("attributes").begin_object().end_object();
+		product["attributes"] = json::object();
+
+		w.end_object();
+		j.push_back(product);
+	}
+	w.end_array();
+	ITI_CHECK(json::from_cbor(w.str()) == j);
+}
+
+// sink: the output is handed over in chunks of about `flushSize` bytes as it
+// is written, and what is left on flush
+static void sink() {
+	std::string out;
+	size_t chunks = 0;
+	Writer w([&](std::string_view chunk) {
+		out.append(chunk.data(), chunk.size());
+		chunks++;
+	});
+
+	json j = json::array();
+	w.begin_array();
+	for (size_t i = 0; i < 1000; i++) {
+		w.value("value " + std::to_string(i));
+		j.push_back("value " + std::to_string(i));
+	}
+	ITI_CHECK(chunks >= 2);
+	w.end_array();
+	w.flush();
+	ITI_CHECK(json::from_cbor(out) == j);
+}
+
+static void errors() {
+	Writer w;
+	ITI_CHECK_THROWS(w.end_object(), std::logic_error);
+	ITI_CHECK_THROWS(w.end_array(), std::logic_error);
+}
+
+int main() {
+	scalars();
+	containers();
+	documents();
+	sink();
+	errors();
+	return iti::test::report("cbor.writer");
+}
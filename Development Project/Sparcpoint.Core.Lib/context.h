@@ -1,38 +1,204 @@
 #ifndef ITI_LIB_CONTEXT_H
 #define ITI_LIB_CONTEXT_H
 
-#include <any>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
 #include <stdexcept>
-#include <string>
 #include <string_view>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
 
 namespace iti {
+
+class Context;
+
+// ContextKey is a typed key into a `Context`.
+//
+// Keys are declared once, as long-lived constants, and each one is assigned a
+// fixed slot in every `Context` when it is constructed:
+//
+//	inline const iti::ContextKey<long long> idCtxKey{"id"};
+//
+//	req.context.set_value(idCtxKey, id);
+//	req.context.try_get_value(idCtxKey, id);
+//
+// Lookups are then an array index: no hashing, no allocation and no
+// exceptions.
+template <typename T> class ContextKey {
+  public:
+	explicit ContextKey(std::string_view keyName = std::string_view());
+
+	ContextKey(const ContextKey &) = delete;
+	ContextKey &operator=(const ContextKey &) = delete;
+
+	size_t slot() const { return index; }
+	std::string_view name() const { return keyName; }
+
+  private:
+	size_t index;
+	std::string_view keyName;
+};
+
+// Context is a temporary, typed datastore used to move data through the
+// request pipeline. Values live inline in fixed slots.
 class Context {
   public:
+	// maximum number of keys a program can declare
+	static constexpr size_t maxSlots = 16;
+
+	// maximum size of a value stored in the context
+	static constexpr size_t slotSize = 32;
+
+	Context() = default;
+	Context(const Context &other) { copy_from(other); }
+	Context(Context &&other) noexcept { move_from(other); }
+	~Context() { clear(); }
+
+	Context &operator=(const Context &other) {
+		if (this != &other) {
+			clear();
+			copy_from(other);
+		}
+		return *this;
+	}
+
+	Context &operator=(Context &&other) noexcept {
+		if (this != &other) {
+			clear();
+			move_from(other);
+		}
+		return *this;
+	}
+
+	// get returns a pointer to the value stored for `key`, or nullptr.
+	template <typename T> const T *get(const ContextKey<T> &key) const {
+		const Slot &s = slots[key.slot()];
+		if (s.ops != &ops_for<T>) {
+			return nullptr;
+		}
+		return std::launder(reinterpret_cast<const T *>(&s.storage));
+	}
+
+	template <typename T> T *get(const ContextKey<T> &key) {
+		Slot &s = slots[key.slot()];
+		if (s.ops != &ops_for<T>) {
+			return nullptr;
+		}
+		return std::launder(reinterpret_cast<T *>(&s.storage));
+	}
+
 	template <typename T>
-	bool try_get_value(const std::string_view key, T &data) const {
-		try {
-			data = std::any_cast<T>(ctxData.at(std::string(key)));
-		} catch (const std::out_of_range &) {
-			// not found in map
-			return false;
-		} catch (const std::bad_any_cast &) {
-			// bad cast
+	bool try_get_value(const ContextKey<T> &key, T &data) const {
+		const T *v = get(key);
+		if (v == nullptr) {
 			return false;
 		}
+		data = *v;
 		return true;
 	}
 
 	template <typename T>
-	void set_value(const std::string_view key, const T &data) {
-		ctxData[std::string(key)] = std::any(data);
+	void set_value(const ContextKey<T> &key, const T &data) {
+		static_assert(sizeof(T) <= slotSize,
+		              "iti::Context: value is too large for a context slot");
+		static_assert(alignof(T) <= alignof(std::max_align_t),
+		              "iti::Context: value is over-aligned");
+
+		if (T *v = get(key); v != nullptr) {
+			*v = data;
+			return;
+		}
+
+		Slot &s = slots[key.slot()];
+		reset(s);
+		new (&s.storage) T(data);
+		s.ops = &ops_for<T>;
+	}
+
+	// erase removes the value stored for `key`, if any.
+	template <typename T> void erase(const ContextKey<T> &key) {
+		reset(slots[key.slot()]);
+	}
+
+	// clear removes all the values.
+	void clear() {
+		for (auto &s : slots) {
+			reset(s);
+		}
+	}
+
+	// register_slot hands out the slot of a new `ContextKey`.
+	static size_t register_slot() {
+		static std::atomic<size_t> nextSlot{0};
+		size_t idx = nextSlot.fetch_add(1);
+		if (idx >= maxSlots) {
+			throw std::length_error(
+			    "iti::Context: too many ContextKeys, raise maxSlots");
+		}
+		return idx;
 	}
 
   private:
-	std::unordered_map<std::string, std::any> ctxData;
+	struct SlotOps {
+		void (*copy)(void *dst, const void *src);
+		void (*move)(void *dst, void *src);
+		void (*destroy)(void *);
+	};
+
+	template <typename T>
+	static constexpr SlotOps ops_for = {
+	    [](void *dst, const void *src) {
+		    new (dst) T(*static_cast<const T *>(src));
+	    },
+	    [](void *dst, void *src) {
+		    new (dst) T(std::move(*static_cast<T *>(src)));
+		    static_cast<T *>(src)->~T();
+	    },
+	    [](void *v) { static_cast<T *>(v)->~T(); },
+	};
+
+	struct Slot {
+		std::aligned_storage_t<slotSize, alignof(std::max_align_t)> storage;
+		const SlotOps *ops = nullptr;
+	};
+
+	static void reset(Slot &s) {
+		if (s.ops != nullptr) {
+			s.ops->destroy(&s.storage);
+			s.ops = nullptr;
+		}
+	}
+
+	void copy_from(const Context &other) {
+		for (size_t i = 0; i < maxSlots; i++) {
+			const Slot &src = other.slots[i];
+			if (src.ops != nullptr) {
+				src.ops->copy(&slots[i].storage, &src.storage);
+				slots[i].ops = src.ops;
+			}
+		}
+	}
+
+	void move_from(Context &other) {
+		for (size_t i = 0; i < maxSlots; i++) {
+			Slot &src = other.slots[i];
+			if (src.ops != nullptr) {
+				src.ops->move(&slots[i].storage, &src.storage);
+				slots[i].ops = src.ops;
+				src.ops      = nullptr;
+			}
+		}
+	}
+
+	std::array<Slot, maxSlots> slots{};
 };
 
+template <typename T>
+ContextKey<T>::ContextKey(std::string_view keyName)
+    : index(Context::register_slot()), keyName(keyName) {}
+
 } // namespace iti
 
 #endif // ITI_LIB_CONTEXT_H
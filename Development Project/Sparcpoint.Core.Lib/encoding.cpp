@@ -0,0 +1,220 @@
+#ifndef ITI_LIB_ENCODING_CPP
+#define ITI_LIB_ENCODING_CPP
+
+#include "pch.h"
+
+#include "encoding.h"
+
+#include <array>
+
+#include "StrUtils.h"
+#include "cbor.writer.h"
+#include "http.h"
+#include "json.writer.h"
+#include "msgpack.writer.h"
+
+using iti::encoding::Format;
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+static constexpr size_t formatCount = 3;
+
+struct MediaType {
+	Format format;
+	std::string_view type;
+};
+
+// the media types served, the first one of each format being its canonical
+// name
+static constexpr std::array<MediaType, 4> mediaTypes = {{
+    {Format::json, "application/json"},
+    {Format::msgpack, "application/msgpack"},
+    {Format::msgpack, "application/x-msgpack"},
+    {Format::cbor, "application/cbor"},
+}};
+
+// Preference is how much a client wants a format: the q-value (in
+// thousandths) and specificity of the most specific range matching it, and
+// where that range is in the Accept header.
+struct Preference {
+	int q        = -1;
+	int spec     = -1;
+	size_t index = 0;
+};
+
+static std::string_view trim(std::string_view s) {
+	while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+		s.remove_prefix(1);
+	}
+	while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+		s.remove_suffix(1);
+	}
+	return s;
+}
+
+// `parse_qvalue()` parses a qvalue ("0.8") into thousandths, or returns -1.
+static int parse_qvalue(std::string_view s) {
+	if (s.empty() || (s[0] != '0' && s[0] != '1')) {
+		return -1;
+	}
+
+	int q = (s[0] - '0') * 1000;
+	if (s.size() > 1) {
+		if (s[1] != '.' || s.size() > 5) {
+			return -1;
+		}
+		int scale = 100;
+		for (size_t i = 2; i < s.size(); i++, scale /= 10) {
+			if (s[i] < '0' || s[i] > '9') {
+				return -1;
+			}
+			q += (s[i] - '0') * scale;
+		}
+	}
+	return q > 1000 ? -1 : q;
+}
+
+// `scan_accept()` records, for each format, the range of `accept` that
+// matches it most specifically. `index` numbers the ranges across fields.
+static void scan_accept(std::string_view accept,
+                        std::array<Preference, formatCount> &prefs,
+                        size_t &index) {
+	size_t pos = 0;
+	while (pos < accept.size()) {
+		size_t comma = accept.find(',', pos);
+		if (comma == std::string_view::npos) {
+			comma = accept.size();
+		}
+
+		auto range = accept.substr(pos, comma - pos);
+		pos        = comma + 1;
+
+		// media-range *( ";" parameter ), the weight being the "q" one
+		size_t semi = range.find(';');
+		auto media  = trim(range.substr(0, semi));
+		if (media.empty()) {
+			continue;
+		}
+
+		int q = 1000;
+		while (semi != std::string_view::npos) {
+			size_t next = range.find(';', semi + 1);
+			auto param  = trim(range.substr(semi + 1, next - semi - 1));
+			if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+			    param[1] == '=') {
+				q = parse_qvalue(param.substr(2));
+			}
+			semi = next;
+		}
+		if (q < 0) {
+			continue;
+		}
+
+		for (const auto &m : mediaTypes) {
+			int spec = -1;
+			if (iti::strutils::iequals(media, m.type)) {
+				spec = 2;
+			} else if (iti::strutils::iequals(media, "application/*")) {
+				spec = 1;
+			} else if (media == "*/*") {
+				spec = 0;
+			}
+
+			auto &pref = prefs[size_t(m.format)];
+			if (spec > pref.spec) {
+				pref = Preference{q, spec, index};
+			}
+		}
+
+		index++;
+	}
+}
+
+// `prefers()` reports whether `a` beats `b`: a higher q-value, then a more
+// specific range, then a range listed first.
+static bool prefers(const Preference &a, const Preference &b) {
+	if (a.q != b.q) {
+		return a.q > b.q;
+	}
+	if (a.spec != b.spec) {
+		return a.spec > b.spec;
+	}
+	return a.index < b.index;
+}
+
+// `choose()` picks the preferred format, if any is acceptable.
+static bool choose(const std::array<Preference, formatCount> &prefs,
+                   Format &format) {
+	const Preference *best = nullptr;
+	for (size_t i = 0; i < prefs.size(); i++) {
+		if (prefs[i].q <= 0) {
+			continue;
+		}
+		if (best == nullptr || prefers(prefs[i], *best)) {
+			best   = &prefs[i];
+			format = Format(i);
+		}
+	}
+	return best != nullptr;
+}
+
+// encoding
+// ----------------------------------------------------------------------------
+std::string_view iti::encoding::content_type(Format format) {
+	for (const auto &m : mediaTypes) {
+		if (m.format == format) {
+			return m.type;
+		}
+	}
+	return mediaTypes[0].type;
+}
+
+bool iti::encoding::negotiate(std::string_view accept, Format &format) {
+	if (trim(accept).empty()) {
+		format = Format::json;
+		return true;
+	}
+
+	std::array<Preference, formatCount> prefs{};
+	size_t index = 0;
+	scan_accept(accept, prefs, index);
+	return choose(prefs, format);
+}
+
+bool iti::encoding::negotiate(const iti::http::Header &header,
+                              Format &format) {
+	std::array<Preference, formatCount> prefs{};
+	size_t index = 0;
+	bool any     = false;
+	for (auto it = header.cbegin(); it != header.cend(); it++) {
+		if (it->id() == iti::http::HeaderName::Accept &&
+		    !trim(it->value()).empty()) {
+			scan_accept(it->value(), prefs, index);
+			any = true;
+		}
+	}
+
+	if (!any) {
+		format = Format::json;
+		return true;
+	}
+	return choose(prefs, format);
+}
+
+std::unique_ptr<iti::encoding::Encoder>
+iti::encoding::make_encoder(Format format, Sink sink, bool pretty) {
+	switch (format) {
+	case Format::msgpack:
+		return std::make_unique<iti::msgpack::Writer>(std::move(sink));
+	case Format::cbor:
+		return std::make_unique<iti::cbor::Writer>(std::move(sink));
+	case Format::json:
+	default:
+		return std::make_unique<iti::json::Writer>(
+		    std::move(sink),
+		    pretty ? iti::json::Style::pretty : iti::json::Style::compact);
+	}
+}
+
+#endif // ITI_LIB_ENCODING_CPP
@@ -0,0 +1,111 @@
+#ifndef ITI_LIB_ENCODING_H
+#define ITI_LIB_ENCODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace iti {
+
+namespace http {
+class Header;
+}
+
+namespace encoding {
+
+// Format is a serialization format responses can be encoded in.
+enum class Format {
+	json,
+	msgpack,
+	cbor,
+};
+
+// content_type returns the media type of `format`, e.g. "application/cbor".
+std::string_view content_type(Format format);
+
+// negotiate picks the format a client prefers, given the value of its Accept
+// header (RFC 7231, section 5.3.2): the supported media type with the
+// highest q-value, the most specific range breaking ties, then the one
+// listed first. An empty Accept header means JSON.
+//
+// It returns false if the client accepts none of the formats.
+bool negotiate(std::string_view accept, Format &format);
+
+// negotiate is `negotiate()` over all the Accept fields of `header`.
+bool negotiate(const iti::http::Header &header, Format &format);
+
+// Sink receives the output of an Encoder, in chunks.
+using Sink = std::function<void(std::string_view)>;
+
+// Encoder writes a document made of objects, arrays and scalars to a sink,
+// in whatever format it implements. Code producing a response only talks to
+// an Encoder, and serves any format the client negotiated:
+//
+//	auto enc = iti::encoding::make_encoder(format, sink);
+//	enc->begin_object();
+//	enc->key("id").value(42);
+//	enc->key("name").value("Fake Product");
+//	enc->end_object();
+//	enc->flush();
+//
+// Keys and strings must be UTF-8.
+class Encoder {
+  public:
+	virtual ~Encoder() = default;
+
+	virtual Format format() const = 0;
+
+	virtual Encoder &begin_object() = 0;
+	virtual Encoder &end_object()   = 0;
+	virtual Encoder &begin_array()  = 0;
+	virtual Encoder &end_array()    = 0;
+
+	// key writes the key of the next member of the current object.
+	virtual Encoder &key(std::string_view k) = 0;
+
+	Encoder &value(std::string_view v) { return write_string(v); }
+	Encoder &value(const char *v) { return write_string(v); }
+	Encoder &value(const std::string &v) { return write_string(v); }
+	Encoder &value(bool v) { return write_bool(v); }
+	Encoder &value(std::nullptr_t) { return write_null(); }
+
+	template <class T,
+	          std::enable_if_t<std::is_arithmetic_v<T> &&
+	                               !std::is_same_v<T, bool> &&
+	                               !std::is_same_v<T, char>,
+	                           int> = 0>
+	Encoder &value(T v) {
+		if constexpr (std::is_floating_point_v<T>) {
+			return write_double(double(v));
+		} else if constexpr (std::is_signed_v<T>) {
+			return write_int(int64_t(v));
+		} else {
+			return write_uint(uint64_t(v));
+		}
+	}
+
+	// flush hands what is buffered to the sink.
+	virtual void flush() = 0;
+
+  protected:
+	virtual Encoder &write_string(std::string_view v) = 0;
+	virtual Encoder &write_bool(bool v)               = 0;
+	virtual Encoder &write_null()                     = 0;
+	virtual Encoder &write_int(int64_t v)             = 0;
+	virtual Encoder &write_uint(uint64_t v)           = 0;
+	virtual Encoder &write_double(double v)           = 0;
+};
+
+// make_encoder returns an encoder writing `format` to `sink`. `pretty` only
+// applies to JSON.
+std::unique_ptr<Encoder> make_encoder(Format format, Sink sink,
+                                      bool pretty = false);
+
+} // namespace encoding
+} // namespace iti
+
+#endif // ITI_LIB_ENCODING_H
@@ -0,0 +1,159 @@
+#ifndef ITI_LIB_EPOCH_CPP
+#define ITI_LIB_EPOCH_CPP
+
+#include "pch.h"
+
+#include "epoch.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+static constexpr uint64_t idleEpoch = std::numeric_limits<uint64_t>::max();
+
+// Participant is the per-thread record a reader publishes its epoch in.
+// Records are never freed; a thread that exits gives its record back so the
+// next new thread can reuse it, which bounds the list to the peak number of
+// concurrent readers.
+struct Participant {
+	std::atomic<uint64_t> epoch{idleEpoch};
+	std::atomic<bool> inUse{true};
+	Participant *next = nullptr;
+};
+
+struct Retired {
+	void *ptr;
+	iti::epoch::deleterFunc deleter;
+	uint64_t epoch;
+};
+
+static std::atomic<uint64_t> globalEpoch{1};
+static std::atomic<Participant *> participants{nullptr};
+
+static std::mutex &retired_mutex() {
+	static std::mutex mtx;
+	return mtx;
+}
+
+static std::vector<Retired> &retired_list() {
+	static std::vector<Retired> list;
+	return list;
+}
+
+static Participant *acquire_participant() {
+	// reuse a record left behind by an exited thread
+	for (auto p = participants.load(std::memory_order_acquire); p != nullptr;
+	     p      = p->next) {
+		bool expected = false;
+		if (!p->inUse.load(std::memory_order_relaxed) &&
+		    p->inUse.compare_exchange_strong(expected, true)) {
+			return p;
+		}
+	}
+
+	auto p  = new Participant();
+	p->next = participants.load(std::memory_order_relaxed);
+	while (!participants.compare_exchange_weak(p->next, p)) {
+	}
+	return p;
+}
+
+// ThreadState binds a participant record to the calling thread for the
+// lifetime of the thread.
+struct ThreadState {
+	Participant *participant = acquire_participant();
+	size_t depth             = 0;
+
+	~ThreadState() {
+		participant->epoch.store(idleEpoch);
+		participant->inUse.store(false, std::memory_order_release);
+	}
+};
+
+static ThreadState &thread_state() {
+	thread_local ThreadState state;
+	return state;
+}
+
+// min_active_epoch returns the oldest epoch any reader is currently in.
+static uint64_t min_active_epoch() {
+	uint64_t min = idleEpoch;
+	for (auto p = participants.load(); p != nullptr; p = p->next) {
+		uint64_t e = p->epoch.load();
+		if (e < min) {
+			min = e;
+		}
+	}
+	return min;
+}
+
+// collect_locked frees every retired object whose epoch is older than any
+// active reader. `retired_mutex()` must be held.
+static void collect_locked() {
+	auto &list = retired_list();
+	if (list.empty()) {
+		return;
+	}
+
+	uint64_t minActive = min_active_epoch();
+
+	auto it = std::partition(list.begin(), list.end(), [=](const Retired &r) {
+		return r.epoch > minActive;
+	});
+
+	std::vector<Retired> reclaimable(it, list.end());
+	list.erase(it, list.end());
+
+	for (const auto &r : reclaimable) {
+		r.deleter(r.ptr);
+	}
+}
+
+// Guard
+// ----------------------------------------------------------------------------
+iti::epoch::Guard::Guard() {
+	auto &state = thread_state();
+	if (state.depth++ == 0) {
+		state.participant->epoch.store(globalEpoch.load());
+	}
+}
+
+iti::epoch::Guard::~Guard() {
+	auto &state = thread_state();
+	if (--state.depth == 0) {
+		state.participant->epoch.store(idleEpoch, std::memory_order_release);
+	}
+}
+
+// reclamation
+// ----------------------------------------------------------------------------
+void iti::epoch::retire(void *ptr, deleterFunc deleter) {
+	if (ptr == nullptr || deleter == nullptr) {
+		return;
+	}
+
+	std::scoped_lock<std::mutex> l(retired_mutex());
+
+	// Every reader that entered before this point may still hold `ptr`, and
+	// all of them recorded an epoch lower than the one we tag it with.
+	uint64_t epoch = globalEpoch.fetch_add(1) + 1;
+	retired_list().push_back(Retired{ptr, deleter, epoch});
+
+	collect_locked();
+}
+
+void iti::epoch::collect() {
+	std::scoped_lock<std::mutex> l(retired_mutex());
+	collect_locked();
+}
+
+size_t iti::epoch::pending() {
+	std::scoped_lock<std::mutex> l(retired_mutex());
+	return retired_list().size();
+}
+
+#endif // ITI_LIB_EPOCH_CPP
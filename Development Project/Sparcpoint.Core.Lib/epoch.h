@@ -0,0 +1,61 @@
+#ifndef ITI_LIB_EPOCH_H
+#define ITI_LIB_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace iti {
+namespace epoch {
+
+// Epoch based reclamation (EBR).
+//
+// Readers wrap every access to a shared, atomically published object in a
+// `Guard`. Writers unpublish an object (usually with an atomic exchange) and
+// hand it to `retire()`, which frees it only once every reader that could
+// still be holding it has left its critical section.
+//
+// The read side is lock-free: entering a guard is a thread-local lookup plus
+// one store. Writers serialize on an internal mutex, which is fine for the
+// rare "publish a new version" use case this is built for.
+//
+//	iti::epoch::Guard g;
+//	auto v = published.load(); // safe to use `v` until `g` goes out of scope
+//
+class Guard {
+  public:
+	Guard();
+	~Guard();
+
+	Guard(const Guard &) = delete;
+	Guard &operator=(const Guard &) = delete;
+};
+
+using deleterFunc = void (*)(void *);
+
+// `retire()` schedules `ptr` to be destroyed with `deleter` as soon as no
+// reader can observe it anymore. The caller must have already unpublished
+// `ptr` so that new readers can't load it.
+void retire(void *ptr, deleterFunc deleter);
+
+template <typename T> void retire(T *ptr) {
+	if (ptr == nullptr) {
+		return;
+	}
+
+	retire(static_cast<void *>(ptr),
+	       [](void *p) { delete static_cast<T *>(p); });
+}
+
+// `collect()` destroys every retired object that is no longer reachable by
+// any reader. `retire()` calls it already, but it is useful to call when
+// shutting down or after a burst of publications.
+void collect();
+
+// `pending()` returns the number of retired objects waiting on readers.
+size_t pending();
+
+} // namespace epoch
+} // namespace iti
+
+#endif // ITI_LIB_EPOCH_H
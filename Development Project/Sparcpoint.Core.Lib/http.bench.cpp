@@ -0,0 +1,167 @@
+// Header micro-benchmarks (see "bench.h"): ./run.sh http.bench.cpp
+
+#define ITI_BENCH_COUNT_ALLOCATIONS
+#include "bench.h"
+
+#include <cctype>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+#include "http.h"
+
+using iti::http::Header;
+using iti::http::HeaderName;
+using iti::http::Request;
+
+namespace before {
+
+// Header as it was before the flat list of fields: a map of canonical keys,
+// with a miss throwing from at().
+class Header {
+  public:
+	static std::string gen_canonical_key(const std::string &key) {
+		bool upper       = true;
+		std::string cKey = key;
+		for (auto &c : cKey) {
+			if (upper && 'a' <= c && c <= 'z') {
+				c = char(std::toupper(c));
+			} else if (!upper && 'A' <= c && c <= 'Z') {
+				c = char(std::tolower(c));
+			}
+			upper = c == '-';
+		}
+		return cKey;
+	}
+
+	void add(const std::string &key, const std::string &value) {
+		headerMap[gen_canonical_key(key)].push_back(value);
+	}
+
+	std::string get(const std::string &key) const {
+		try {
+			auto &v = headerMap.at(gen_canonical_key(key));
+			if (!v.empty()) {
+				return std::string(v[0]);
+			}
+		} catch (const std::out_of_range &) {
+			return std::string();
+		}
+		return std::string();
+	}
+
+	void clear() { headerMap.clear(); }
+
+  private:
+	std::unordered_map<std::string, std::vector<std::string>> headerMap;
+};
+
+// ArenaHeader is the Header the flat list of fields replaced: a map of
+// canonical keys to copies of the values, allocated from the request arena.
+class ArenaHeader {
+  public:
+	using Values = std::pmr::vector<std::pmr::string>;
+
+	explicit ArenaHeader(std::pmr::memory_resource *mr) : headerMap(mr) {}
+
+	void add(const std::string &key, const std::string &value) {
+		headerMap[lookup_key(key)].emplace_back(value);
+	}
+
+	std::string get(const std::string &key) const {
+		auto it = headerMap.find(lookup_key(key));
+		if (it == headerMap.end() || it->second.empty()) {
+			return std::string();
+		}
+		return std::string(it->second[0]);
+	}
+
+	// reset drops everything, as the arena is about to be released
+	void reset() { headerMap = decltype(headerMap)(headerMap.get_allocator()); }
+
+  private:
+	static const std::pmr::string &lookup_key(const std::string &key) {
+		thread_local std::pmr::string cKey;
+		cKey.assign(key.data(), key.size());
+		bool upper = true;
+		for (auto &c : cKey) {
+			if (upper && 'a' <= c && c <= 'z') {
+				c = char(std::toupper(c));
+			} else if (!upper && 'A' <= c && c <= 'Z') {
+				c = char(std::tolower(c));
+			}
+			upper = c == '-';
+		}
+		return cKey;
+	}
+
+	std::pmr::unordered_map<std::pmr::string, Values> headerMap;
+};
+
+} // namespace before
+
+// a typical request header, as libevent hands it over
+static const char *const requestKeys[] = {
+    "Host",            "User-Agent", "Accept",       "Accept-Encoding",
+    "Accept-Language", "Connection", "X-Request-Id", "Cookie"};
+static const char *const requestValues[] = {
+    "localhost:8080", "curl/8.4.0", "*/*",     "gzip, deflate",
+    "en-us",          "keep-alive", "abc-123", "a=b; c=d"};
+
+// missing headers: a lookup of a header the request doesn't have
+static void missing_headers() {
+	before::Header oldHeader;
+	oldHeader.add("Content-Type", "application/json");
+	iti::bench::run("Header::get of a missing header, before", 200000, [&] {
+		iti::bench::keep(oldHeader.get("X-Missing").size());
+	});
+
+	Header header;
+	header.add("Content-Type", "application/json");
+	iti::bench::run("Header::get of a missing header, after", 200000,
+	                [&] { iti::bench::keep(header.get("X-Missing").size()); });
+	iti::bench::run("Header::get_view of a missing header", 200000, [&] {
+		iti::bench::keep(header.get_view("X-Missing").size());
+	});
+}
+
+// request headers: filling the 8 fields of a request, two lookups (one of a
+// missing field), then the reset after the response
+static void request_headers() {
+	iti::RequestArena arena;
+	before::ArenaHeader oldHeader(arena.resource());
+	auto oldFill = [&] {
+		for (size_t i = 0; i < 8; i++) {
+			oldHeader.add(requestKeys[i], requestValues[i]);
+		}
+		iti::bench::keep(oldHeader.get("host").size());
+		iti::bench::keep(oldHeader.get("Content-Type").size());
+		oldHeader.reset();
+		arena.release();
+	};
+	iti::bench::run("request header, fill + 2 lookups + reset, before",
+	                200000, oldFill);
+	iti::bench::count_allocations("request header, before", 200000, oldFill);
+
+	Request req;
+	auto fill = [&] {
+		for (size_t i = 0; i < 8; i++) {
+			req.header.add_view(requestKeys[i], requestValues[i]);
+		}
+		iti::bench::keep(req.header.get_view("host").size());
+		iti::bench::keep(req.header.get_view(HeaderName::ContentType).size());
+		req.reset();
+	};
+	iti::bench::run("request header, fill + 2 lookups + reset, after", 200000,
+	                fill);
+	iti::bench::count_allocations("request header, after", 200000, fill);
+}
+
+int main() {
+	missing_headers();
+	request_headers();
+	return 0;
+}
@@ -213,26 +213,151 @@ bool iti::http::Method::try_parse(const std::string &rawMethod,
 	return method != Method::unknown;
 }
 
+// header names
+// ----------------------------------------------------------------------------
+using iti::http::HeaderName;
+
+static constexpr std::array<std::string_view, size_t(HeaderName::count)>
+    headerNames = {
+        "",
+        "Accept",
+        "Accept-Charset",
+        "Accept-Encoding",
+        "Accept-Language",
+        "Allow",
+        "Authorization",
+        "Cache-Control",
+        "Connection",
+        "Content-Encoding",
+        "Content-Length",
+        "Content-Type",
+        "Cookie",
+        "Date",
+        "Etag",
+        "Expect",
+        "Host",
+        "If-Match",
+        "If-Modified-Since",
+        "If-None-Match",
+        "Last-Modified",
+        "Location",
+        "Origin",
+        "Range",
+        "Referer",
+        "Set-Cookie",
+        "Transfer-Encoding",
+        "Upgrade",
+        "User-Agent",
+        "Vary",
+        "X-Forwarded-For",
+        "X-Request-Id",
+};
+
+static constexpr char ascii_lower(char c) {
+	return ('A' <= c && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+// `ascii_iequals()` compares header names, which are ASCII, ignoring case.
+static constexpr bool ascii_iequals(std::string_view a, std::string_view b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (ascii_lower(a[i]) != ascii_lower(b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// case-insensitive FNV-1a
+static constexpr uint32_t header_name_hash(std::string_view name,
+                                           uint32_t seed) {
+	uint32_t h = 2166136261u ^ seed;
+	for (char c : name) {
+		h ^= uint8_t(ascii_lower(c));
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// HeaderNameTable maps the hash of a well-known name to its `HeaderName`,
+// without collisions.
+struct HeaderNameTable {
+	static constexpr size_t size = 128; // power of 2
+
+	bool found    = false;
+	uint32_t seed = 0;
+	std::array<uint8_t, size> slots{};
+};
+
+static constexpr HeaderNameTable build_header_name_table() {
+	HeaderNameTable t;
+	for (uint32_t seed = 0; seed < 4096; seed++) {
+		t.seed      = seed;
+		bool unique = true;
+		for (auto &s : t.slots) {
+			s = 0;
+		}
+
+		for (size_t i = 1; i < headerNames.size() && unique; i++) {
+			auto &slot = t.slots[header_name_hash(headerNames[i], seed) &
+			                     (HeaderNameTable::size - 1)];
+			unique     = slot == 0;
+			slot       = uint8_t(i);
+		}
+
+		if (unique) {
+			t.found = true;
+			return t;
+		}
+	}
+	return t;
+}
+
+static constexpr HeaderNameTable headerNameTable = build_header_name_table();
+static_assert(headerNameTable.found,
+              "no perfect hash for the well-known header names");
+
+HeaderName iti::http::lookup_header_name(std::string_view name) {
+	uint8_t id = headerNameTable.slots[header_name_hash(name,
+	                                                    headerNameTable.seed) &
+	                                   (HeaderNameTable::size - 1)];
+	if (id != 0 && ascii_iequals(headerNames[id], name)) {
+		return HeaderName(id);
+	}
+	return HeaderName::unknown;
+}
+
+std::string_view iti::http::header_name_str(HeaderName name) {
+	return headerNames[size_t(name) < headerNames.size() ? size_t(name) : 0];
+}
+
 // Header
 // ----------------------------------------------------------------------------
-std::string iti::http::Header::gen_canonical_key(const std::string &key) {
+
+// `canonicalize()` writes the canonical format of `key` to `out`, see
+// `Header::gen_canonical_key()`.
+template <class String>
+static void canonicalize(std::string_view key, String &out) {
+	out.assign(key.data(), key.size());
+
 	// check if it looks like a header key.
-	// if not, return original key.
+	// if not, keep the original key.
 	for (const auto &c : key) {
 		if (valid_header_field_char(c)) {
 			continue;
 		}
 
 		// Don't canonicalize.
-		return key;
+		return;
 	}
 
-	bool upper       = true;
-	std::string cKey = key;
-	const auto len   = cKey.size();
+	bool upper     = true;
+	const auto len = out.size();
 
 	for (size_t i = 0; i < len; i++) {
-		char c = cKey[i];
+		char c = out[i];
 		// Canonicalize: first letter upper case
 		// and upper case after each dash.
 		// (Host, User-Agent, If-Modified-Since).
@@ -242,46 +367,161 @@ std::string iti::http::Header::gen_canonical_key(const std::string &key) {
 		} else if (!upper && 'A' <= c && c <= 'Z') {
 			c = std::tolower(c);
 		}
-		cKey[i] = c;
-		upper   = c == '-'; // need to uppercase if we have a separator
+		out[i] = c;
+		upper  = c == '-'; // need to uppercase if we have a separator
 	}
+}
+
+// `field_matches()` reports whether `f` is the header `id`, or `key` if it
+// isn't a well-known one.
+static inline bool field_matches(const iti::http::Header::Field &f,
+                                 HeaderName id, std::string_view key) {
+	if (id != HeaderName::unknown) {
+		return f.id() == id;
+	}
+	return f.id() == HeaderName::unknown && ascii_iequals(f.name(), key);
+}
 
+bool iti::http::Header::Field::same_name(const Field &other) const {
+	return field_matches(*this, other.nameId, other.name());
+}
+
+std::string iti::http::Header::gen_canonical_key(const std::string &key) {
+	std::string cKey;
+	canonicalize(key, cKey);
 	return cKey;
 }
 
-void iti::http::Header::add(const std::string &key, const std::string &value) {
-	headerMap[gen_canonical_key(key)].push_back(value);
+iti::http::Header::Field &iti::http::Header::next_field(std::string_view key) {
+	if (count == fields.size()) {
+		fields.emplace_back(fields.get_allocator().resource());
+	}
+
+	Field &f   = fields[count++];
+	f.nameId   = lookup_header_name(key);
+	f.ownsName = false;
+	f.nameView = std::string_view();
+	f.ownedName.clear();
+	f.ownsValue = false;
+	f.valueView = std::string_view();
+	f.ownedValue.clear();
+	return f;
+}
+
+void iti::http::Header::erase_from(size_t first, HeaderName id,
+                                   std::string_view key) {
+	// compact the remaining fields, moving the erased ones to the spares
+	size_t out = first;
+	for (size_t i = first; i < count; i++) {
+		if (field_matches(fields[i], id, key)) {
+			continue;
+		}
+		if (out != i) {
+			std::swap(fields[out], fields[i]);
+		}
+		out++;
+	}
+	count = out;
+}
+
+void iti::http::Header::add(std::string_view key, std::string_view value) {
+	Field &f = next_field(key);
+	if (f.nameId == HeaderName::unknown) {
+		canonicalize(key, f.ownedName);
+		f.ownsName = true;
+	}
+	f.ownedValue.assign(value.data(), value.size());
+	f.ownsValue = true;
+}
+
+void iti::http::Header::add_view(std::string_view key,
+                                 std::string_view value) {
+	Field &f    = next_field(key);
+	f.nameView  = key;
+	f.valueView = value;
+}
+
+void iti::http::Header::del(std::string_view key) {
+	erase_from(0, lookup_header_name(key), key);
+}
+
+void iti::http::Header::set(std::string_view key, std::string_view value) {
+	HeaderName id = lookup_header_name(key);
+
+	for (size_t i = 0; i < count; i++) {
+		Field &f = fields[i];
+		if (!field_matches(f, id, key)) {
+			continue;
+		}
+
+		// copy on write
+		f.ownedValue.assign(value.data(), value.size());
+		f.ownsValue = true;
+		erase_from(i + 1, id, key);
+		return;
+	}
+
+	add(key, value);
 }
 
-void iti::http::Header::del(const std::string &key) {
-	headerMap.erase(gen_canonical_key(key));
+void iti::http::Header::reset() {
+	count = 0;
+
+	// memory that doesn't come from the heap is about to be reclaimed (see
+	// "arena.h"), and don't let a client grow the retained fields without
+	// bound
+	if (fields.get_allocator().resource() != std::pmr::new_delete_resource()) {
+		fields = decltype(fields)(fields.get_allocator());
+	} else if (fields.size() > maxRetainedFields) {
+		fields.erase(fields.begin() + maxRetainedFields, fields.end());
+	}
 }
 
-void iti::http::Header::set(const std::string &key, const std::string &value) {
-	headerMap[gen_canonical_key(key)] = std::vector<std::string>{value};
+const iti::http::Header::Field *
+iti::http::Header::find(std::string_view key) const {
+	HeaderName id = lookup_header_name(key);
+	for (size_t i = 0; i < count; i++) {
+		if (field_matches(fields[i], id, key)) {
+			return &fields[i];
+		}
+	}
+	return nullptr;
 }
 
-std::string iti::http::Header::get(const std::string &key) const {
-	try {
-		auto &v = headerMap.at(gen_canonical_key(key));
-		if (!v.empty()) {
-			return std::string(v[0]);
+const iti::http::Header::Field *iti::http::Header::find(HeaderName id) const {
+	for (size_t i = 0; i < count; i++) {
+		if (fields[i].id() == id) {
+			return &fields[i];
 		}
-	} catch (std::out_of_range) {
-		return std::string();
 	}
-	return std::string();
+	return nullptr;
+}
+
+std::string_view iti::http::Header::get_view(std::string_view key) const {
+	auto f = find(key);
+	return f != nullptr ? f->value() : std::string_view();
+}
+
+std::string_view iti::http::Header::get_view(HeaderName id) const {
+	auto f = find(id);
+	return f != nullptr ? f->value() : std::string_view();
+}
+
+std::string iti::http::Header::get(std::string_view key) const {
+	return std::string(get_view(key));
 }
 
 std::vector<std::string>
-iti::http::Header::get_all_values(const std::string &key) const {
-	try {
-		auto &v = headerMap.at(gen_canonical_key(key));
-		return std::vector<std::string>(v);
-	} catch (std::out_of_range) {
-		return std::vector<std::string>();
+iti::http::Header::get_all_values(std::string_view key) const {
+	std::vector<std::string> values;
+
+	HeaderName id = lookup_header_name(key);
+	for (size_t i = 0; i < count; i++) {
+		if (field_matches(fields[i], id, key)) {
+			values.emplace_back(fields[i].value());
+		}
 	}
-	return std::vector<std::string>();
+	return values;
 }
 
 #endif // ITI_LIB_HTTP_CPP
@@ -1,14 +1,17 @@
 #ifndef ITI_LIB_HTTP_H
 #define ITI_LIB_HTTP_H
 
+#include <cstdint>
 #include <fmt/format.h>
 #include <functional>
+#include <memory_resource>
+#include <string>
 #include <string_view>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "StatusCode.h"
+#include "arena.h"
 #include "context.h"
 #include "uri.h"
 
@@ -115,10 +118,103 @@ template <> struct hash<iti::http::Method> {
 namespace iti {
 namespace http {
 
+// HeaderName identifies the well-known header names. They are recognized with
+// a perfect hash (see `lookup_header_name()`), so looking them up never
+// compares strings.
+enum class HeaderName : uint8_t {
+	unknown = 0,
+	Accept,
+	AcceptCharset,
+	AcceptEncoding,
+	AcceptLanguage,
+	Allow,
+	Authorization,
+	CacheControl,
+	Connection,
+	ContentEncoding,
+	ContentLength,
+	ContentType,
+	Cookie,
+	Date,
+	ETag,
+	Expect,
+	Host,
+	IfMatch,
+	IfModifiedSince,
+	IfNoneMatch,
+	LastModified,
+	Location,
+	Origin,
+	Range,
+	Referer,
+	SetCookie,
+	TransferEncoding,
+	Upgrade,
+	UserAgent,
+	Vary,
+	XForwardedFor,
+	XRequestId,
+	count
+};
+
+// lookup_header_name returns the well-known header `name` is, ignoring case,
+// or `HeaderName::unknown`.
+HeaderName lookup_header_name(std::string_view name);
+
+// header_name_str returns the canonical name of a well-known header, e.g.
+// "Content-Type".
+std::string_view header_name_str(HeaderName name);
+
 // A Header represents the key-value pairs in an HTTP header.
-// The keys should be in canonical form, as returned by canonical_key().
+//
+// Fields are kept in a flat list, in the order they were added, and are
+// compared case-insensitively without allocating. A field added with
+// `add_view()` is a pair of views into the buffer it was received in, so
+// headers a handler never reads cost nothing; values are only copied when a
+// field is added or modified with `add()` or `set()`.
+//
+// Copies are allocated from the header's memory resource: a request header
+// lives in the request arena (see "arena.h"), a response header on the heap.
 class Header {
   public:
+	// Field is a single header line.
+	class Field {
+	  public:
+		explicit Field(std::pmr::memory_resource *mr)
+		    : ownedName(mr), ownedValue(mr) {}
+
+		HeaderName id() const { return nameId; }
+
+		std::string_view name() const {
+			if (nameId != HeaderName::unknown) {
+				return header_name_str(nameId);
+			}
+			return ownsName ? std::string_view(ownedName) : nameView;
+		}
+
+		std::string_view value() const {
+			return ownsValue ? std::string_view(ownedValue) : valueView;
+		}
+
+		// same_name reports whether `other` has the same name, ignoring case.
+		bool same_name(const Field &other) const;
+
+	  private:
+		friend class Header;
+
+		HeaderName nameId = HeaderName::unknown;
+		bool ownsName     = false;
+		bool ownsValue    = false;
+		std::string_view nameView;
+		std::string_view valueView;
+		std::pmr::string ownedName;
+		std::pmr::string ownedValue;
+	};
+
+	explicit Header(
+	    std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+	    : fields(mr) {}
+
 	// `canonical_key()` returns the canonical format of the header key.
 	// The canonicalization converts the first letter and any letter following a
 	// hyphen to upper case; the rest are converted to lowercase.
@@ -129,43 +225,85 @@ class Header {
 	// without modifications.
 	static std::string gen_canonical_key(const std::string &key);
 
-	// `add()` adds the key, value pair to the header. It appends to any
-	// existing values associated with key.
+	// `add()` adds a copy of the key, value pair to the header. It appends to
+	// any existing values associated with key.
 	// The key is case insensitive; it is canonicalized by canonical_key().
-	void add(const std::string &key, const std::string &value);
+	void add(std::string_view key, std::string_view value);
+
+	// `add_view()` adds the key, value pair to the header without copying
+	// it: both must outlive the header, e.g. the buffer the request was
+	// received in.
+	void add_view(std::string_view key, std::string_view value);
 
 	// `del()`  deletes the values associated with key.
-	// The key is case insensitive; it is canonicalized by canonical_key().
-	void del(const std::string &key);
+	// The key is case insensitive.
+	void del(std::string_view key);
 
 	// Set sets the header entries associated with key to the single element
 	// value. It replaces any existing values associated with key.
 	// The key is case insensitive; it is canonicalized by canonical_key().
-	void set(const std::string &key, const std::string &value);
+	void set(std::string_view key, std::string_view value);
 
 	// `get()` gets the first value associated with the given key. If there are
 	// no values associated with the key, Get returns an empty string.
-	// The key is case insensitive; it is canonicalized by canonical_key().
-	std::string get(const std::string &key) const;
+	// The key is case insensitive.
+	std::string get(std::string_view key) const;
+
+	// `get_view()` is `get()` without the copy. The view is valid until the
+	// header is modified.
+	std::string_view get_view(std::string_view key) const;
+	std::string_view get_view(HeaderName id) const;
 
 	// `get_all_values()` returns all values associated with the given key.
-	// The key is case insensitive; it is canonicalized by canonical_key().
-	std::vector<std::string> get_all_values(const std::string &key) const;
+	// The key is case insensitive.
+	std::vector<std::string> get_all_values(std::string_view key) const;
 
-	auto cbegin() { return headerMap.cbegin(); }
-	auto cend() { return headerMap.cend(); }
+	// `find()` returns the first field associated with the given key, or
+	// nullptr if there are none.
+	// The key is case insensitive.
+	const Field *find(std::string_view key) const;
+	const Field *find(HeaderName id) const;
+
+	// `reset()` removes all the fields. Heap allocated fields are kept for
+	// reuse, with the capacity of their copies; anything else is freed.
+	void reset();
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	const Field *cbegin() const { return fields.data(); }
+	const Field *cend() const { return fields.data() + count; }
 
   private:
-	std::unordered_map<std::string, std::vector<std::string>> headerMap;
+	// maximum number of fields `reset()` keeps
+	static constexpr size_t maxRetainedFields = 64;
+
+	// next_field returns a blank field at the end of the list, reusing a
+	// spare one if possible.
+	Field &next_field(std::string_view key);
+
+	// erase_from removes the fields matching `id`/`key` starting at `first`.
+	void erase_from(size_t first, HeaderName id, std::string_view key);
+
+	// fields[0, count) are the header; the rest are spares
+	std::pmr::vector<Field> fields;
+	size_t count = 0;
 };
 
 class Request {
   public:
+	// arena holds the request-scoped allocations: the URL, the header and
+	// the routing context all allocate from it. It is released in one shot
+	// by `reset()`, once the response has been sent.
+	//
+	// Handlers may use it for their own scratch memory (`arena.resource()`).
+	mutable iti::RequestArena arena;
+
 	// method specifies the HTTP method (GET, POST, PUT, etc.).
 	Method method;
 
 	// url is parsed from the URI supplied
-	iti::http::Uri url;
+	iti::http::Uri url{arena.resource()};
 
 	// header contains the request header fields either
 	// received by the server or to be sent by the
@@ -181,16 +319,17 @@ class Request {
 	//
 	// then
 	//
-	//	header["Accept-Encoding"] == {"gzip, deflate"}
-	//	header["Accept-Language"] == {"en-us"}
-	//	header["Foo"] == {"Bar", "two"}
+	//	header.get_all_values("Accept-Encoding") == {"gzip, deflate"}
+	//	header.get_all_values("Accept-Language") == {"en-us"}
+	//	header.get_all_values("Foo") == {"Bar", "two"}
 	//
 	//
 	// HTTP defines that header names are case-insensitive.
-	// The request parser implements this by using Header::gen_canonical_key(),
-	// making the first character and any characters following a hyphen
-	// uppercase and the rest lowercase.
-	Header header;
+	// Header implements this by comparing names case-insensitively. A
+	// received field named with a well-known name (see `HeaderName`) reads
+	// back with its canonical spelling, e.g. "Accept-Encoding"; any other
+	// keeps the spelling the client sent it with, e.g. "fOO".
+	Header header{arena.resource()};
 
 	// body contains the HTTP Request Body's data (if a body way sent)
 	//
@@ -206,6 +345,24 @@ class Request {
 	// context is a temporary datastore that can be used
 	// to move data through the request pipeline.
 	mutable iti::Context context;
+
+	Request() = default;
+
+	Request(const Request &) = delete;
+	Request &operator=(const Request &) = delete;
+
+	// reset puts the request back in its initial state, so it can be reused
+	// (see "pool.h"), and releases its arena.
+	void reset() {
+		// everything allocated from the arena goes first
+		context.clear();
+		url    = Uri(arena.resource());
+		header = Header(arena.resource());
+		arena.release();
+
+		method = Method::unknown;
+		body.clear();
+	}
 };
 
 class Response {
@@ -220,7 +377,7 @@ class Response {
 	// delimiters.  (RFC 7230, section 3.2.2 requires that multiple headers
 	// be semantically equivalent to a comma-delimited sequence.)
 	//
-	// Keys in the map are canonicalized (see Header::gen_canonical_key()).
+	// Keys are canonicalized (see Header::gen_canonical_key()).
 	Header header;
 
 	// context is a temporary datastore that can be used to move data through
@@ -228,8 +385,31 @@ class Response {
 	// It is not directly used when sending the response to the client.
 	iti::Context context;
 
-	// write sends the response to the client with the supplied body content
+	// omitBody is set when the body will not be sent to the client, as for
+	// HEAD requests. Handlers may then skip building it; `write()` drops it.
+	// A response whose body was skipped has no Content-Length.
+	bool omitBody = false;
+
+	// write sends the response to the client with the supplied body content,
+	// following whatever was appended before
 	virtual void write(const std::string &body = "") = 0;
+
+	// append adds `chunk` to the body without sending the response yet, so
+	// that a body can be streamed in pieces (see "json.writer.h"). A final
+	// `write()` sends it.
+	virtual void append(std::string_view chunk) = 0;
+
+	// reset puts the response back in its initial state, keeping the
+	// capacity of its members, so it can be reused (see "pool.h").
+	virtual void reset() {
+		status = iti::http::StatusCode::Status200OK;
+		header.reset();
+		context.clear();
+		omitBody = false;
+	}
+
+	// get_body_size returns the number of body bytes written so far.
+	virtual size_t get_body_size() const { return 0; }
 };
 
 class IHandler {
@@ -0,0 +1,105 @@
+// json::Reader micro-benchmarks (see "bench.h"): ./run.sh json.reader.bench.cpp
+//
+// Reading a product body (the ProductInput of Interview.Web) into a struct,
+// with nlohmann::json::parse then field extraction, and with a Reader.
+
+#include "bench.h"
+
+#include <cstdlib>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "json.reader.h"
+
+using nlohmann::json;
+
+namespace {
+
+struct Product {
+	std::string name;
+	std::string details;
+	std::vector<std::string> categories;
+	std::vector<std::string> metadata;
+};
+
+bool read_json(iti::json::Reader &r, Product &p) {
+	using iti::json::field;
+	return iti::json::read_fields(
+	    r, p, field("name", &Product::name),
+	    field("general-details", &Product::details),
+	    field("categories", &Product::categories),
+	    field("metadata", &Product::metadata));
+}
+
+json make_product(int i) {
+	return json{
+	    {"name", "Product number " + std::to_string(i)},
+	    {"general-details",
+	     "A fairly long description of the product, with \"quotes\" and "
+	     "unicode \xc3\xa9\xc3\xa8 in it, to look like real data."},
+	    {"categories", {"tools", "garden", "outdoor"}},
+	    {"metadata",
+	     {"color=green", "weight=1.5kg", "sku=ABC-" + std::to_string(i)}}};
+}
+
+// from_nlohmann fills `p` from a parsed document, as the routes did.
+void from_nlohmann(const json &j, Product &p) {
+	p.name       = j.at("name").get<std::string>();
+	p.details    = j.at("general-details").get<std::string>();
+	p.categories = j.at("categories").get<std::vector<std::string>>();
+	p.metadata   = j.at("metadata").get<std::vector<std::string>>();
+}
+
+} // namespace
+
+int main() {
+	const std::string one = make_product(1).dump();
+	json products         = json::array();
+	for (int i = 0; i < 1000; i++) {
+		products.push_back(make_product(i));
+	}
+	const std::string batch = products.dump();
+	std::printf("single product %zu bytes, array of 1000 %zu bytes\n",
+	            one.size(), batch.size());
+
+	iti::bench::run("single product, nlohmann", 100000, [&] {
+		Product p;
+		from_nlohmann(json::parse(one), p);
+		iti::bench::keep(p.name.size());
+	});
+
+	// the routes give the Reader the request arena
+	char mem[16 * 1024];
+	iti::bench::run("single product, Reader", 100000, [&] {
+		std::pmr::monotonic_buffer_resource mr(mem, sizeof(mem));
+		iti::json::Reader r(&mr);
+		Product p;
+		if (!(r.parse(one) && read_json(r, p) && r.end())) {
+			std::abort();
+		}
+		iti::bench::keep(p.name.size());
+	});
+
+	iti::bench::run("1000-product array, nlohmann", 100, [&] {
+		std::vector<Product> v;
+		for (auto &e : json::parse(batch)) {
+			v.emplace_back();
+			from_nlohmann(e, v.back());
+		}
+		iti::bench::keep(v.size());
+	});
+
+	iti::bench::run("1000-product array, Reader", 100, [&] {
+		std::pmr::monotonic_buffer_resource mr;
+		iti::json::Reader r(&mr);
+		std::vector<Product> v;
+		if (!(r.parse(batch) && iti::json::read_value(r, v) && r.end())) {
+			std::abort();
+		}
+		iti::bench::keep(v.size());
+	});
+	return 0;
+}
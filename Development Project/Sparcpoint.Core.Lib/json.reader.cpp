@@ -0,0 +1,866 @@
+#ifndef ITI_LIB_JSON_READER_CPP
+#define ITI_LIB_JSON_READER_CPP
+
+#include "pch.h"
+
+#include "json.reader.h"
+
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ITI_JSON_SSE2 1
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using iti::json::ReadError;
+using iti::json::Reader;
+using iti::json::ValueType;
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+static inline unsigned first_set_bit(uint64_t mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward64(&idx, mask);
+	return idx;
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
+
+// BlockMasks classifies the 64 bytes of a block, one bit per byte.
+struct BlockMasks {
+	uint64_t quote      = 0;
+	uint64_t backslash  = 0;
+	uint64_t op         = 0; // { } [ ] : ,
+	uint64_t whitespace = 0;
+	uint64_t control    = 0; // below 0x20
+	uint64_t nonAscii   = 0; // 0x80 and above
+};
+
+#ifdef ITI_JSON_SSE2
+static inline uint64_t movemask(__m128i m, unsigned shift) {
+	return uint64_t(unsigned(_mm_movemask_epi8(m))) << shift;
+}
+
+static BlockMasks classify(const char *block) {
+	const __m128i quote      = _mm_set1_epi8('"');
+	const __m128i backslash  = _mm_set1_epi8('\\');
+	const __m128i openBrace  = _mm_set1_epi8('{');
+	const __m128i closeBrace = _mm_set1_epi8('}');
+	const __m128i lower      = _mm_set1_epi8(0x20);
+	const __m128i colon      = _mm_set1_epi8(':');
+	const __m128i comma      = _mm_set1_epi8(',');
+	const __m128i space      = _mm_set1_epi8(' ');
+	const __m128i tab        = _mm_set1_epi8('\t');
+	const __m128i lf         = _mm_set1_epi8('\n');
+	const __m128i cr         = _mm_set1_epi8('\r');
+	const __m128i control    = _mm_set1_epi8(0x1f);
+
+	BlockMasks m;
+	for (unsigned i = 0; i < 64; i += 16) {
+		__m128i c =
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+
+		// '[' and ']' are '{' and '}' without the 0x20 bit
+		__m128i folded = _mm_or_si128(c, lower);
+		__m128i op     = _mm_or_si128(
+		    _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace),
+		                 _mm_cmpeq_epi8(folded, closeBrace)),
+		    _mm_or_si128(_mm_cmpeq_epi8(c, colon), _mm_cmpeq_epi8(c, comma)));
+		__m128i ws = _mm_or_si128(
+		    _mm_or_si128(_mm_cmpeq_epi8(c, space), _mm_cmpeq_epi8(c, tab)),
+		    _mm_or_si128(_mm_cmpeq_epi8(c, lf), _mm_cmpeq_epi8(c, cr)));
+
+		m.quote |= movemask(_mm_cmpeq_epi8(c, quote), i);
+		m.backslash |= movemask(_mm_cmpeq_epi8(c, backslash), i);
+		m.op |= movemask(op, i);
+		m.whitespace |= movemask(ws, i);
+		m.control |= movemask(
+		    _mm_cmpeq_epi8(_mm_max_epu8(c, control), control), i);
+		m.nonAscii |= movemask(c, i);
+	}
+	return m;
+}
+#else
+static BlockMasks classify(const char *block) {
+	BlockMasks m;
+	for (unsigned i = 0; i < 64; i++) {
+		auto c       = static_cast<unsigned char>(block[i]);
+		uint64_t bit = uint64_t(1) << i;
+		switch (c) {
+		case '"':
+			m.quote |= bit;
+			break;
+		case '\\':
+			m.backslash |= bit;
+			break;
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ':':
+		case ',':
+			m.op |= bit;
+			break;
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+			m.whitespace |= bit;
+			break;
+		}
+		if (c < 0x20) {
+			m.control |= bit;
+		}
+		if (c >= 0x80) {
+			m.nonAscii |= bit;
+		}
+	}
+	return m;
+}
+#endif
+
+// `find_escaped()` returns the characters of a block escaped by a backslash.
+// `carry` tells whether the first one is, and is set to whether the first
+// one of the next block is. Backslashes are rare in practice: they are
+// walked one by one.
+static uint64_t find_escaped(uint64_t backslash, uint64_t &carry) {
+	uint64_t escaped = carry;
+	carry            = 0;
+
+	while (backslash != 0) {
+		unsigned i = first_set_bit(backslash);
+		backslash &= backslash - 1;
+
+		// an escaped backslash escapes nothing
+		if ((escaped >> i) & 1) {
+			continue;
+		}
+		if (i == 63) {
+			carry = 1;
+		} else {
+			escaped |= uint64_t(1) << (i + 1);
+		}
+	}
+	return escaped;
+}
+
+// `prefix_xor()` sets each bit to the xor of itself and all the bits below
+// it: from the quotes of a block, the bytes inside strings (opening quotes
+// included, closing quotes excluded).
+static inline uint64_t prefix_xor(uint64_t x) {
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+// `is_number()` reports whether `s` is a JSON number, and if it has a
+// fraction or an exponent.
+static bool is_number(std::string_view s, bool &isInteger) {
+	auto digit = [&](size_t i) {
+		return i < s.size() && s[i] >= '0' && s[i] <= '9';
+	};
+
+	size_t i = 0;
+	if (i < s.size() && s[i] == '-') {
+		i++;
+	}
+	if (i < s.size() && s[i] == '0') {
+		i++;
+	} else if (digit(i)) {
+		while (digit(i)) {
+			i++;
+		}
+	} else {
+		return false;
+	}
+
+	isInteger = true;
+	if (i < s.size() && s[i] == '.') {
+		isInteger = false;
+		if (!digit(++i)) {
+			return false;
+		}
+		while (digit(i)) {
+			i++;
+		}
+	}
+	if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+		isInteger = false;
+		i++;
+		if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
+			i++;
+		}
+		if (!digit(i)) {
+			return false;
+		}
+		while (digit(i)) {
+			i++;
+		}
+	}
+	return i == s.size();
+}
+
+static inline int hex_value(char c) {
+	if ('0' <= c && c <= '9') {
+		return c - '0';
+	}
+	if ('a' <= c && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if ('A' <= c && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+// `read_hex4()` reads the 4 hex digits of a "\uXXXX" escape at `s[i]`.
+static long read_hex4(std::string_view s, size_t i) {
+	if (i + 4 > s.size()) {
+		return -1;
+	}
+	long cp = 0;
+	for (size_t k = i; k < i + 4; k++) {
+		int h = hex_value(s[k]);
+		if (h < 0) {
+			return -1;
+		}
+		cp = (cp << 4) | h;
+	}
+	return cp;
+}
+
+static void append_utf8(std::pmr::string &out, unsigned long cp) {
+	if (cp < 0x80) {
+		out.push_back(char(cp));
+	} else if (cp < 0x800) {
+		out.push_back(char(0xc0 | (cp >> 6)));
+		out.push_back(char(0x80 | (cp & 0x3f)));
+	} else if (cp < 0x10000) {
+		out.push_back(char(0xe0 | (cp >> 12)));
+		out.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+		out.push_back(char(0x80 | (cp & 0x3f)));
+	} else {
+		out.push_back(char(0xf0 | (cp >> 18)));
+		out.push_back(char(0x80 | ((cp >> 12) & 0x3f)));
+		out.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+		out.push_back(char(0x80 | (cp & 0x3f)));
+	}
+}
+
+// `valid_utf8()` reports whether `s` is well-formed UTF-8: no stray
+// continuation byte, truncated sequence, overlong form, surrogate, nor code
+// point past U+10FFFF. ASCII is skipped 16 bytes at a time.
+static bool valid_utf8(std::string_view s) {
+	size_t i = 0;
+	while (i < s.size()) {
+		if (i + 16 <= s.size()) {
+#ifdef ITI_JSON_SSE2
+			const __m128i c = _mm_loadu_si128(
+			    reinterpret_cast<const __m128i *>(s.data() + i));
+			const bool ascii = _mm_movemask_epi8(c) == 0;
+#else
+			uint64_t words[2];
+			std::memcpy(words, s.data() + i, sizeof(words));
+			const bool ascii =
+			    ((words[0] | words[1]) & 0x8080808080808080ull) == 0;
+#endif
+			if (ascii) {
+				i += 16;
+				continue;
+			}
+		}
+
+		auto c = static_cast<unsigned char>(s[i]);
+		if (c < 0x80) {
+			i++;
+			continue;
+		}
+
+		// the continuation bytes, and the range of the first one
+		size_t n;
+		unsigned char lo = 0x80, hi = 0xbf;
+		if (c >= 0xc2 && c <= 0xdf) {
+			n = 1;
+		} else if (c >= 0xe0 && c <= 0xef) {
+			n  = 2;
+			lo = c == 0xe0 ? 0xa0 : lo; // overlong
+			hi = c == 0xed ? 0x9f : hi; // surrogates
+		} else if (c >= 0xf0 && c <= 0xf4) {
+			n  = 3;
+			lo = c == 0xf0 ? 0x90 : lo; // overlong
+			hi = c == 0xf4 ? 0x8f : hi; // past U+10FFFF
+		} else {
+			return false;
+		}
+		if (s.size() - i <= n) {
+			return false;
+		}
+		auto c1 = static_cast<unsigned char>(s[i + 1]);
+		if (c1 < lo || c1 > hi) {
+			return false;
+		}
+		for (size_t k = 2; k <= n; k++) {
+			if ((static_cast<unsigned char>(s[i + k]) & 0xc0) != 0x80) {
+				return false;
+			}
+		}
+		i += n + 1;
+	}
+	return true;
+}
+
+// `unescape()` appends the content of a string to `out`, decoding its
+// escapes. It returns false on a malformed one.
+static bool unescape(std::string_view s, std::pmr::string &out) {
+	size_t i = 0;
+	while (i < s.size()) {
+		size_t esc = s.find('\\', i);
+		if (esc == std::string_view::npos) {
+			out.append(s.data() + i, s.size() - i);
+			break;
+		}
+		out.append(s.data() + i, esc - i);
+		if (esc + 1 >= s.size()) {
+			return false;
+		}
+
+		i = esc + 2;
+		switch (s[esc + 1]) {
+		case '"':
+		case '\\':
+		case '/':
+			out.push_back(s[esc + 1]);
+			break;
+		case 'b':
+			out.push_back('\b');
+			break;
+		case 'f':
+			out.push_back('\f');
+			break;
+		case 'n':
+			out.push_back('\n');
+			break;
+		case 'r':
+			out.push_back('\r');
+			break;
+		case 't':
+			out.push_back('\t');
+			break;
+		case 'u': {
+			long cp = read_hex4(s, i);
+			i += 4;
+			if (cp >= 0xdc00 && cp <= 0xdfff) {
+				return false; // a low surrogate on its own
+			}
+			if (cp >= 0xd800 && cp <= 0xdbff) {
+				// a high surrogate must be followed by a low one
+				long low = i + 1 < s.size() && s[i] == '\\' && s[i + 1] == 'u'
+				               ? read_hex4(s, i + 2)
+				               : -1;
+				if (low < 0xdc00 || low > 0xdfff) {
+					return false;
+				}
+				cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+				i += 6;
+			}
+			if (cp < 0) {
+				return false;
+			}
+			append_utf8(out, static_cast<unsigned long>(cp));
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+// reader
+// ----------------------------------------------------------------------------
+std::string_view iti::json::read_error_str(ReadError e) {
+	switch (e) {
+	case ReadError::none:
+		return "no error";
+	case ReadError::empty:
+		return "empty document";
+	case ReadError::unclosed_string:
+		return "unclosed string";
+	case ReadError::unexpected_token:
+		return "unexpected token";
+	case ReadError::unexpected_end:
+		return "unexpected end of input";
+	case ReadError::wrong_type:
+		return "wrong type";
+	case ReadError::out_of_range:
+		return "number out of range";
+	case ReadError::invalid_string:
+		return "invalid string";
+	case ReadError::invalid_literal:
+		return "invalid literal";
+	case ReadError::too_deep:
+		return "too deeply nested";
+	case ReadError::trailing_content:
+		return "trailing content";
+	case ReadError::too_large:
+		return "document too large";
+	}
+	return "unknown error";
+}
+
+bool iti::json::Reader::parse(std::string_view input) {
+	json = input;
+	pos  = 0;
+	indices.clear();
+	scopes.clear();
+	err       = ReadError::none;
+	errOffset = 0;
+	nonAscii  = false;
+
+	if (json.size() >= std::numeric_limits<uint32_t>::max()) {
+		return fail(ReadError::too_large, 0);
+	}
+
+	// about one structural character every 4 bytes in typical documents
+	indices.reserve(json.size() / 4 + 2);
+
+	uint64_t inStringCarry = 0; // all ones while inside a string
+	uint64_t escapedCarry  = 0;
+	uint64_t scalarCarry   = 0; // the last byte was part of a scalar
+
+	for (size_t base = 0; base < json.size(); base += 64) {
+		const char *block = json.data() + base;
+
+		// the last block is padded with spaces
+		char tail[64];
+		if (json.size() - base < 64) {
+			std::memset(tail, ' ', sizeof(tail));
+			std::memcpy(tail, block, json.size() - base);
+			block = tail;
+		}
+
+		BlockMasks m      = classify(block);
+		uint64_t escaped  = find_escaped(m.backslash, escapedCarry);
+		uint64_t quotes   = m.quote & ~escaped;
+		uint64_t inString = prefix_xor(quotes) ^ inStringCarry;
+		inStringCarry     = uint64_t(0) - (inString >> 63);
+
+		// raw control characters aren't allowed in strings
+		if (uint64_t bad = m.control & inString; bad != 0) {
+			return fail(ReadError::invalid_string, base + first_set_bit(bad));
+		}
+		nonAscii = nonAscii || (m.nonAscii & inString) != 0;
+
+		// every quote, the operators outside of strings, and the first byte
+		// of each other value (numbers, true, false, null)
+		uint64_t op          = m.op & ~inString;
+		uint64_t scalar      = ~(m.op | m.whitespace | m.quote | inString);
+		uint64_t scalarStart = scalar & ~((scalar << 1) | scalarCarry);
+		scalarCarry          = scalar >> 63;
+
+		uint64_t structurals = op | quotes | scalarStart;
+		while (structurals != 0) {
+			indices.push_back(uint32_t(base + first_set_bit(structurals)));
+			structurals &= structurals - 1;
+		}
+	}
+
+	if (inStringCarry != 0) {
+		return fail(ReadError::unclosed_string, json.size());
+	}
+
+	indices.push_back(uint32_t(json.size()));
+	if (indices.size() == 1) {
+		return fail(ReadError::empty, 0);
+	}
+	return true;
+}
+
+bool iti::json::Reader::end() {
+	if (!ok()) {
+		return false;
+	}
+	if (!scopes.empty()) {
+		return fail(ReadError::unexpected_end);
+	}
+	if (pos + 1 != indices.size()) {
+		return fail(ReadError::trailing_content);
+	}
+	return true;
+}
+
+iti::json::ValueType iti::json::Reader::type() const {
+	switch (token()) {
+	case '{':
+		return ValueType::object;
+	case '[':
+		return ValueType::array;
+	case '"':
+		return ValueType::string;
+	case 't':
+	case 'f':
+		return ValueType::boolean;
+	case 'n':
+		return ValueType::null;
+	case '-':
+	case '0':
+	case '1':
+	case '2':
+	case '3':
+	case '4':
+	case '5':
+	case '6':
+	case '7':
+	case '8':
+	case '9':
+		return ValueType::number;
+	default:
+		return ValueType::none;
+	}
+}
+
+bool iti::json::Reader::begin_object() {
+	if (!ok()) {
+		return false;
+	}
+	if (token() != '{') {
+		return fail(token() == '\0' ? ReadError::unexpected_end
+		                            : ReadError::wrong_type);
+	}
+	if (scopes.size() >= maxDepth) {
+		return fail(ReadError::too_deep);
+	}
+
+	pos++;
+	scopes.push_back(Scope{true, true});
+	return true;
+}
+
+bool iti::json::Reader::next_key(std::string_view &key) {
+	if (!ok()) {
+		return false;
+	}
+	if (scopes.empty() || !scopes.back().isObject) {
+		return fail(ReadError::unexpected_token);
+	}
+
+	auto &scope = scopes.back();
+	if (token() == '}') {
+		pos++;
+		scopes.pop_back();
+		return false;
+	}
+	if (!scope.first && !expect(',')) {
+		return false;
+	}
+	scope.first = false;
+
+	if (token() != '"') {
+		return fail(token() == '\0' ? ReadError::unexpected_end
+		                            : ReadError::unexpected_token);
+	}
+	return read_string(key, keyScratch) && expect(':');
+}
+
+bool iti::json::Reader::begin_array() {
+	if (!ok()) {
+		return false;
+	}
+	if (token() != '[') {
+		return fail(token() == '\0' ? ReadError::unexpected_end
+		                            : ReadError::wrong_type);
+	}
+	if (scopes.size() >= maxDepth) {
+		return fail(ReadError::too_deep);
+	}
+
+	pos++;
+	scopes.push_back(Scope{false, true});
+	return true;
+}
+
+bool iti::json::Reader::next_element() {
+	if (!ok()) {
+		return false;
+	}
+	if (scopes.empty() || scopes.back().isObject) {
+		return fail(ReadError::unexpected_token);
+	}
+
+	auto &scope = scopes.back();
+	if (token() == ']') {
+		pos++;
+		scopes.pop_back();
+		return false;
+	}
+	if (!scope.first && !expect(',')) {
+		return false;
+	}
+	scope.first = false;
+
+	// no trailing comma
+	if (token() == ']') {
+		return fail(ReadError::unexpected_token);
+	}
+	return true;
+}
+
+bool iti::json::Reader::read(std::string_view &v) {
+	return read_string(v, valueScratch);
+}
+
+bool iti::json::Reader::read(std::string &v) {
+	std::string_view sv;
+	if (!read_string(sv, valueScratch)) {
+		return false;
+	}
+	v.assign(sv.data(), sv.size());
+	return true;
+}
+
+bool iti::json::Reader::read(bool &v) {
+	if (!ok()) {
+		return false;
+	}
+
+	char t = token();
+	if (t != 't' && t != 'f') {
+		return fail(t == '\0' ? ReadError::unexpected_end
+		                      : ReadError::wrong_type);
+	}
+
+	auto s = scalar();
+	if (s != "true" && s != "false") {
+		return fail(ReadError::invalid_literal);
+	}
+	v = t == 't';
+	pos++;
+	return true;
+}
+
+bool iti::json::Reader::read(double &v) {
+	if (!ok()) {
+		return false;
+	}
+
+	char t = token();
+	if (t != '-' && (t < '0' || t > '9')) {
+		return fail(t == '\0' ? ReadError::unexpected_end
+		                      : ReadError::wrong_type);
+	}
+
+	auto s = scalar();
+	bool isInteger;
+	if (!is_number(s, isInteger)) {
+		return fail(ReadError::invalid_literal);
+	}
+
+	auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+	if (res.ec != std::errc()) {
+		return fail(ReadError::out_of_range);
+	}
+	pos++;
+	return true;
+}
+
+bool iti::json::Reader::read_int64(int64_t &v) {
+	if (!ok()) {
+		return false;
+	}
+
+	char t = token();
+	if (t != '-' && (t < '0' || t > '9')) {
+		return fail(t == '\0' ? ReadError::unexpected_end
+		                      : ReadError::wrong_type);
+	}
+
+	auto s = scalar();
+	bool isInteger;
+	if (!is_number(s, isInteger)) {
+		return fail(ReadError::invalid_literal);
+	}
+	if (!isInteger) {
+		return fail(ReadError::wrong_type);
+	}
+
+	auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+	if (res.ec != std::errc()) {
+		return fail(ReadError::out_of_range);
+	}
+	pos++;
+	return true;
+}
+
+bool iti::json::Reader::read_uint64(uint64_t &v) {
+	if (!ok()) {
+		return false;
+	}
+	if (token() == '-') {
+		// a negative integer, or not even a number
+		int64_t i;
+		return read_int64(i) && fail(ReadError::out_of_range);
+	}
+
+	char t = token();
+	if (t < '0' || t > '9') {
+		return fail(t == '\0' ? ReadError::unexpected_end
+		                      : ReadError::wrong_type);
+	}
+
+	auto s = scalar();
+	bool isInteger;
+	if (!is_number(s, isInteger)) {
+		return fail(ReadError::invalid_literal);
+	}
+	if (!isInteger) {
+		return fail(ReadError::wrong_type);
+	}
+
+	auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+	if (res.ec != std::errc()) {
+		return fail(ReadError::out_of_range);
+	}
+	pos++;
+	return true;
+}
+
+bool iti::json::Reader::read_null() {
+	if (!ok()) {
+		return false;
+	}
+	if (token() != 'n') {
+		return fail(token() == '\0' ? ReadError::unexpected_end
+		                            : ReadError::wrong_type);
+	}
+	if (scalar() != "null") {
+		return fail(ReadError::invalid_literal);
+	}
+	pos++;
+	return true;
+}
+
+bool iti::json::Reader::skip() {
+	if (!ok()) {
+		return false;
+	}
+
+	switch (token()) {
+	case '\0':
+		return fail(ReadError::unexpected_end);
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+		return fail(ReadError::unexpected_token);
+	case '"':
+		pos += 2; // the opening and closing quotes
+		return true;
+	case '{':
+	case '[': {
+		// strings are two quotes in the index: only brackets count
+		size_t depth = 0;
+		do {
+			switch (token()) {
+			case '\0':
+				return fail(ReadError::unexpected_end);
+			case '{':
+			case '[':
+				depth++;
+				break;
+			case '}':
+			case ']':
+				depth--;
+				break;
+			}
+			pos++;
+		} while (depth > 0);
+		return true;
+	}
+	default:
+		// a number or a literal, from its first character only
+		if (type() == ValueType::none) {
+			return fail(ReadError::invalid_literal);
+		}
+		pos++;
+		return true;
+	}
+}
+
+std::string_view iti::json::Reader::scalar() const {
+	size_t start = indices[pos];
+	size_t end   = indices[pos + 1];
+	while (end > start && (json[end - 1] == ' ' || json[end - 1] == '\t' ||
+	                       json[end - 1] == '\n' || json[end - 1] == '\r')) {
+		end--;
+	}
+	return json.substr(start, end - start);
+}
+
+bool iti::json::Reader::read_string(std::string_view &v,
+                                    std::pmr::string &scratch) {
+	if (!ok()) {
+		return false;
+	}
+	if (token() != '"') {
+		return fail(token() == '\0' ? ReadError::unexpected_end
+		                            : ReadError::wrong_type);
+	}
+
+	// quotes come in pairs in the index
+	size_t open  = indices[pos];
+	size_t close = indices[pos + 1];
+	auto raw     = json.substr(open + 1, close - open - 1);
+
+	// escapes only ever decode to valid UTF-8, and most documents are
+	// ASCII, which `parse()` noted
+	if (nonAscii && !valid_utf8(raw)) {
+		return fail(ReadError::invalid_string, open);
+	}
+	if (raw.find('\\') == std::string_view::npos) {
+		v = raw;
+	} else {
+		scratch.clear();
+		if (!unescape(raw, scratch)) {
+			return fail(ReadError::invalid_string);
+		}
+		v = scratch;
+	}
+
+	pos += 2;
+	return true;
+}
+
+bool iti::json::Reader::expect(char c) {
+	if (token() != c) {
+		return fail(token() == '\0' ? ReadError::unexpected_end
+		                            : ReadError::unexpected_token);
+	}
+	pos++;
+	return true;
+}
+
+bool iti::json::Reader::fail(ReadError e) {
+	return fail(e, pos < indices.size() ? indices[pos] : json.size());
+}
+
+bool iti::json::Reader::fail(ReadError e, size_t offset) {
+	if (err == ReadError::none) {
+		err       = e;
+		errOffset = offset;
+	}
+	return false;
+}
+
+#endif // ITI_LIB_JSON_READER_CPP
@@ -0,0 +1,299 @@
+#ifndef ITI_LIB_JSON_READER_H
+#define ITI_LIB_JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace iti {
+namespace json {
+
+// ReadError tells why a Reader stopped.
+enum class ReadError {
+	none,
+	empty,            // no value at all
+	unclosed_string,  // a string runs to the end of the input
+	unexpected_token, // e.g. a missing ',' or ':'
+	unexpected_end,   // the input ends in the middle of a value
+	wrong_type,       // the value isn't of the type asked for
+	out_of_range,     // the number doesn't fit the type asked for
+	invalid_string,   // a bad escape, a raw control character, bad UTF-8
+	invalid_literal,  // a malformed number, or not true/false/null
+	too_deep,         // more than `Reader::maxDepth` nested values
+	trailing_content, // something follows the root value
+	too_large,        // inputs are limited to 4GB
+};
+
+// read_error_str describes `e`, e.g. "unexpected token".
+std::string_view read_error_str(ReadError e);
+
+// ValueType is the type of a JSON value, as seen by `Reader::type()`.
+enum class ValueType {
+	none, // the end of the input, or not a value
+	object,
+	array,
+	string,
+	number,
+	boolean,
+	null,
+};
+
+// Reader parses JSON on demand: the values are decoded as they are read,
+// straight into the variables they are bound to, with no document in
+// between.
+//
+//	iti::json::Reader r;
+//	std::string name;
+//	long long price = 0;
+//	bool ok = r.parse(req.body) && r.read_object([&](std::string_view key) {
+//		if (key == "name") {
+//			return r.read(name);
+//		}
+//		if (key == "price") {
+//			return r.read(price);
+//		}
+//		return r.skip();
+//	}) && r.end();
+//
+// `parse()` first indexes the structural characters of the input (braces,
+// brackets, colons, commas, quotes and the start of the other values), 64
+// bytes at a time with SSE2, as simdjson does; the reader then walks that
+// index forward only. Values that are skipped aren't decoded nor validated.
+//
+// Strings that are read must be UTF-8, as RFC 8259 requires: invalid UTF-8
+// (overlong forms, surrogates, code points past U+10FFFF) and "\u" escapes
+// of unpaired surrogates are `ReadError::invalid_string`.
+//
+// Every call returns false once something went wrong, see `error()`.
+class Reader {
+  public:
+	// maximum nesting of objects and arrays
+	static constexpr size_t maxDepth = 256;
+
+	explicit Reader(
+	    std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+	    : indices(mr), scopes(mr), keyScratch(mr), valueScratch(mr) {}
+
+	// parse indexes `json`, which must outlive the reader, and positions the
+	// reader on its root value.
+	bool parse(std::string_view json);
+
+	// end checks that the whole root value was read and nothing follows it.
+	bool end();
+
+	ReadError error() const { return err; }
+
+	// error_offset returns the offset in the input of the error.
+	size_t error_offset() const { return errOffset; }
+
+	// type peeks at the type of the next value, from its first character:
+	// the value itself is only checked when it is read.
+	ValueType type() const;
+
+	// begin_object reads the '{' of an object; `next_key()` then reads each
+	// key, each followed by a value to read (or skip), and returns false
+	// once past the '}'.
+	bool begin_object();
+	bool next_key(std::string_view &key);
+
+	// begin_array reads the '[' of an array; `next_element()` returns true
+	// before each value to read (or skip), and false once past the ']'.
+	bool begin_array();
+	bool next_element();
+
+	// read_object calls `onMember(key)` for each member of an object.
+	// `onMember` must read or skip the value, and return false to stop.
+	template <class F> bool read_object(F &&onMember) {
+		if (!begin_object()) {
+			return false;
+		}
+		std::string_view key;
+		while (next_key(key)) {
+			if (!onMember(key)) {
+				return false;
+			}
+		}
+		return ok();
+	}
+
+	// read_array calls `onElement()` for each element of an array.
+	template <class F> bool read_array(F &&onElement) {
+		if (!begin_array()) {
+			return false;
+		}
+		while (next_element()) {
+			if (!onElement()) {
+				return false;
+			}
+		}
+		return ok();
+	}
+
+	// read reads a string. The view is into the input, or into a buffer of
+	// the reader when the string has escapes; it is then valid until the
+	// next string is read.
+	bool read(std::string_view &v);
+	bool read(std::string &v);
+	bool read(bool &v);
+	bool read(double &v);
+
+	// read reads an integer, failing if it doesn't fit in `T`.
+	template <class T, std::enable_if_t<std::is_integral_v<T> &&
+	                                        !std::is_same_v<T, bool>,
+	                                    int> = 0>
+	bool read(T &v) {
+		if constexpr (std::is_signed_v<T>) {
+			int64_t i;
+			if (!read_int64(i)) {
+				return false;
+			}
+			if (i < int64_t(std::numeric_limits<T>::min()) ||
+			    i > int64_t(std::numeric_limits<T>::max())) {
+				return fail(ReadError::out_of_range);
+			}
+			v = T(i);
+		} else {
+			uint64_t u;
+			if (!read_uint64(u)) {
+				return false;
+			}
+			if (u > uint64_t(std::numeric_limits<T>::max())) {
+				return fail(ReadError::out_of_range);
+			}
+			v = T(u);
+		}
+		return true;
+	}
+
+	// read_null reads a null.
+	bool read_null();
+
+	// skip skips the next value, whatever it is. It isn't validated beyond
+	// its first character and, for objects and arrays, its brackets.
+	bool skip();
+
+	bool ok() const { return err == ReadError::none; }
+
+  private:
+	// Scope is an open object or array.
+	struct Scope {
+		bool isObject;
+		bool first; // no member/element read yet
+	};
+
+	// token returns the character at the next structural index, or '\0' at
+	// the end of the input.
+	char token() const {
+		return pos + 1 < indices.size() ? json[indices[pos]] : '\0';
+	}
+
+	// scalar returns the text of the number or literal at the next index.
+	std::string_view scalar() const;
+
+	bool read_int64(int64_t &v);
+	bool read_uint64(uint64_t &v);
+
+	// read_string reads a string into `v`, unescaping it into `scratch` if
+	// needed.
+	bool read_string(std::string_view &v, std::pmr::string &scratch);
+
+	bool expect(char c);
+	bool fail(ReadError e);
+	bool fail(ReadError e, size_t offset);
+
+	std::string_view json;
+
+	// offsets of the structural characters, followed by `json.size()`
+	std::pmr::vector<uint32_t> indices;
+	size_t pos = 0;
+	// a string holds a byte past 0x7f: strings are checked for UTF-8
+	bool nonAscii = false;
+
+	std::pmr::vector<Scope> scopes;
+	std::pmr::string keyScratch;
+	std::pmr::string valueScratch;
+
+	ReadError err    = ReadError::none;
+	size_t errOffset = 0;
+};
+
+// Field binds a JSON member to a data member of `T` (see `read_fields()`).
+template <class T, class M> struct Field {
+	std::string_view name;
+	M T::*member;
+};
+
+template <class T, class M>
+constexpr Field<T, M> field(std::string_view name, M T::*member) {
+	return Field<T, M>{name, member};
+}
+
+// read_fields reads an object into `obj`, the value of each member being
+// read into the data member bound to its key; unknown members are skipped.
+//
+//	struct Item {
+//		std::string name;
+//		std::vector<std::string> tags;
+//	};
+//
+//	Item item;
+//	iti::json::read_fields(r, item, iti::json::field("name", &Item::name),
+//	                       iti::json::field("tags", &Item::tags));
+//
+// A data member can be of any type `Reader::read()` takes, or a type with a
+// `bool read_json(iti::json::Reader &, T &)` function found by ADL.
+template <class T, class... Fields>
+bool read_fields(Reader &r, T &obj, const Fields &... fields);
+
+// read_value reads a value into `v`: with `Reader::read()`, the
+// `read_json()` function of its type, or element by element for a
+// `std::vector`.
+template <class T> bool read_value(Reader &r, T &v);
+
+namespace detail {
+template <class T, class = void> struct has_reader_read : std::false_type {};
+template <class T>
+struct has_reader_read<T, std::void_t<decltype(std::declval<Reader &>().read(
+                              std::declval<T &>()))>> : std::true_type {};
+
+template <class T> struct is_vector : std::false_type {};
+template <class T, class A>
+struct is_vector<std::vector<T, A>> : std::true_type {};
+} // namespace detail
+
+template <class T> bool read_value(Reader &r, T &v) {
+	if constexpr (detail::is_vector<T>::value) {
+		v.clear();
+		return r.read_array([&] {
+			v.emplace_back();
+			return read_value(r, v.back());
+		});
+	} else if constexpr (detail::has_reader_read<T>::value) {
+		return r.read(v);
+	} else {
+		return read_json(r, v);
+	}
+}
+
+template <class T, class... Fields>
+bool read_fields(Reader &r, T &obj, const Fields &... fields) {
+	return r.read_object([&](std::string_view key) {
+		bool matched = false;
+		bool ok      = true;
+		((!matched && key == fields.name
+		      ? (matched = true, ok = read_value(r, obj.*(fields.member)))
+		      : false),
+		 ...);
+		return matched ? ok : r.skip();
+	});
+}
+
+} // namespace json
+} // namespace iti
+
+#endif // ITI_LIB_JSON_READER_H
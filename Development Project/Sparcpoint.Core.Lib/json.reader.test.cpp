@@ -0,0 +1,450 @@
+// json::Reader tests (see "test.h"): ./run.sh json.reader.test.cpp
+//
+// Documents are read into a `nlohmann::json` value by walking them with a
+// Reader, and compared with what `nlohmann::json::parse` makes of them; a
+// document one rejects, the other must reject too.
+
+#include "test.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "json.reader.h"
+
+using iti::json::ReadError;
+using iti::json::Reader;
+using iti::json::ValueType;
+using nlohmann::json;
+
+namespace {
+
+// to_json reads the next value of `r` into `out`, whatever it is.
+bool to_json(Reader &r, json &out) {
+	switch (r.type()) {
+	case ValueType::object:
+		out = json::object();
+		return r.read_object([&](std::string_view key) {
+			return to_json(r, out[std::string(key)]);
+		});
+	case ValueType::array:
+		out = json::array();
+		return r.read_array([&] {
+			out.push_back(nullptr);
+			return to_json(r, out.back());
+		});
+	case ValueType::string: {
+		std::string s;
+		return r.read(s) && (out = s, true);
+	}
+	case ValueType::number: {
+		double d;
+		return r.read(d) && (out = d, true);
+	}
+	case ValueType::boolean: {
+		bool b;
+		return r.read(b) && (out = b, true);
+	}
+	case ValueType::null:
+		out = nullptr;
+		return r.read_null();
+	default:
+		return r.skip(); // fails, with the error of what is there
+	}
+}
+
+// read_document reads all of `text`, or returns the error that stopped it.
+ReadError read_document(std::string_view text, json &out) {
+	Reader r;
+	if (r.parse(text) && to_json(r, out) && r.end()) {
+		return ReadError::none;
+	}
+	return r.error();
+}
+
+// same_as_nlohmann reads `text` both ways: both must reject it, or both
+// accept it with the same value (numbers compare as doubles).
+bool same_as_nlohmann(std::string_view text) {
+	json ours;
+	const bool accepted = read_document(text, ours) == ReadError::none;
+	if (!json::accept(text)) {
+		return !accepted;
+	}
+	return accepted && ours == json::parse(text);
+}
+
+ReadError error_of(std::string_view text) {
+	json out;
+	return read_document(text, out);
+}
+
+// random_value makes a document of nested objects and arrays, with strings
+// that need escaping, non-ASCII text and numbers of every form.
+json random_value(std::mt19937 &rng, int depth) {
+	auto pick = [&](int n) { return int(rng() % unsigned(n)); };
+	static const char *const pieces[] = {
+	    "a",  "key", " ",  "\"",       "\\",       "/",       "\n", "\t",
+	    "\x01", "{",  "[]", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80",
+	    ":",  ",",
+	};
+
+	switch (depth > 4 ? 3 + pick(5) : pick(8)) {
+	case 0:
+	case 1: {
+		json o = json::object();
+		for (int n = pick(6); n > 0; n--) {
+			o[random_value(rng, 99).dump()] = random_value(rng, depth + 1);
+		}
+		return o;
+	}
+	case 2: {
+		json a = json::array();
+		for (int n = pick(6); n > 0; n--) {
+			a.push_back(random_value(rng, depth + 1));
+		}
+		return a;
+	}
+	case 3: {
+		std::string s;
+		for (int n = pick(80); n > 0; n--) {
+			s += pieces[pick(int(std::size(pieces)))];
+		}
+		return s;
+	}
+	case 4: {
+		// 64 random bits, shifted to get all magnitudes
+		const uint64_t bits = (uint64_t(rng()) << 32 | rng()) >> pick(64);
+		return pick(2) == 0 ? int64_t(bits) : -int64_t(bits >> 1);
+	}
+	case 5:
+		return std::ldexp(double(rng()) - double(rng()), pick(200) - 100);
+	case 6:
+		return pick(2) == 0;
+	default:
+		return nullptr;
+	}
+}
+
+// corpus: random documents, compact and indented, read as nlohmann reads
+// them
+void corpus() {
+	std::mt19937 rng(12345);
+	for (int i = 0; i < 2000; i++) {
+		json j = random_value(rng, 0);
+		for (int indent : {-1, 0, 3}) {
+			const std::string text = j.dump(indent);
+			json ours;
+			if (!ITI_CHECK(read_document(text, ours) == ReadError::none &&
+			               ours == j)) {
+				std::printf("  %s\n", text.c_str());
+				return;
+			}
+		}
+	}
+}
+
+void escapes() {
+	json out;
+	ITI_CHECK(read_document(R"("\"\\\/\b\f\n\r\t")", out) == ReadError::none &&
+	          out == "\"\\/\b\f\n\r\t");
+	ITI_CHECK(read_document(R"("\u0041\u00e9\u20AC\u0000")", out) ==
+	              ReadError::none &&
+	          out == std::string("A\xc3\xa9\xe2\x82\xac\0", 7));
+
+	// a surrogate pair is one code point; a half of one is an error
+	ITI_CHECK(read_document(R"("\ud83d\ude00")", out) == ReadError::none &&
+	          out == "\xf0\x9f\x98\x80");
+	ITI_CHECK(read_document(R"("\uDBFF\uDFFF")", out) == ReadError::none &&
+	          out == "\xf4\x8f\xbf\xbf");
+	for (const char *bad : {R"("\ud83d")", R"("\ude00")", R"("\ud83dx")",
+	                        R"("\ud83dA")", R"("\ude00\ud83d")",
+	                        R"("\ud83d\ud83d")", R"("\u12")", R"("\u12g4")",
+	                        R"("\x")", R"("\U0041")", R"("\)"}) {
+		ITI_CHECK(error_of(bad) == ReadError::invalid_string ||
+		          error_of(bad) == ReadError::unclosed_string);
+		ITI_CHECK(same_as_nlohmann(bad));
+	}
+
+	// backslashes and quotes across the 64-byte blocks of the index
+	for (size_t at = 55; at < 75; at++) {
+		for (const char *esc : {"\\\"", "\\\\", "\\\\\\\"", "\\n"}) {
+			std::string text = "[\"" + std::string(at, 'x') + esc + "\", 1]";
+			ITI_CHECK(same_as_nlohmann(text));
+		}
+	}
+
+	// a raw control character, inside a string only
+	ITI_CHECK(error_of("\"a\nb\"") == ReadError::invalid_string);
+	ITI_CHECK(error_of("[1,\n2]") == ReadError::none);
+}
+
+// utf8: strings are UTF-8, whether the bytes are raw or escaped
+void utf8() {
+	for (const char *good : {"\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80",
+	                         "\xed\x9f\xbf", "\xee\x80\x80", "\xef\xbf\xbf",
+	                         "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf"}) {
+		const std::string text = "\"" + std::string(good) + "\"";
+		ITI_CHECK(error_of(text) == ReadError::none);
+		ITI_CHECK(same_as_nlohmann(text));
+	}
+	for (const char *bad : {
+	         "\x80",             // a stray continuation byte
+	         "\xc3",             // truncated
+	         "\xe2\x82",         // truncated
+	         "\xc0\xaf",         // overlong '/'
+	         "\xc1\xbf",         // overlong
+	         "\xe0\x9f\xbf",     // overlong
+	         "\xf0\x8f\xbf\xbf", // overlong
+	         "\xed\xa0\x80",     // a surrogate
+	         "\xed\xbf\xbf",     // a surrogate
+	         "\xf4\x90\x80\x80", // past U+10FFFF
+	         "\xf5\x80\x80\x80", // past U+10FFFF
+	         "\xff",
+	         "\xc3\x28", // not a continuation byte
+	     }) {
+		// in the ASCII fast path and out of it, in keys and values
+		for (const std::string &text :
+		     {"\"" + std::string(bad) + "\"",
+		      "\"abcdefghijklmnop" + std::string(bad) + "qrstuvwxyz\"",
+		      "{\"" + std::string(bad) + "\": 1}"}) {
+			ITI_CHECK(error_of(text) == ReadError::invalid_string);
+			ITI_CHECK(same_as_nlohmann(text));
+		}
+	}
+}
+
+// malformed: what nlohmann rejects is rejected, and why
+void malformed() {
+	struct {
+		const char *text;
+		ReadError want;
+	} cases[] = {
+	    {"", ReadError::empty},
+	    {"  \n", ReadError::empty},
+	    {"[1,]", ReadError::unexpected_token},
+	    {"[,1]", ReadError::unexpected_token},
+	    {"[1 2]", ReadError::unexpected_token},
+	    {"{\"a\" 1}", ReadError::unexpected_token},
+	    {"{\"a\":1,}", ReadError::unexpected_token},
+	    {"{a:1}", ReadError::unexpected_token},
+	    {"{\"a\":1]", ReadError::unexpected_token},
+	    {"[1}", ReadError::unexpected_token},
+	    {"01", ReadError::invalid_literal},
+	    {"-", ReadError::invalid_literal},
+	    {"1.", ReadError::invalid_literal},
+	    {".5", ReadError::invalid_literal},
+	    {"+1", ReadError::invalid_literal},
+	    {"1e", ReadError::invalid_literal},
+	    {"1e+", ReadError::invalid_literal},
+	    {"0x10", ReadError::invalid_literal},
+	    {"tru", ReadError::invalid_literal},
+	    {"nul", ReadError::invalid_literal},
+	    {"True", ReadError::invalid_literal},
+	    {"nulll", ReadError::invalid_literal},
+	    {"\"abc", ReadError::unclosed_string},
+	    {"[\"a\\\"]", ReadError::unclosed_string},
+	    {"1 2", ReadError::trailing_content},
+	    {"{} {}", ReadError::trailing_content},
+	    {"[1]]", ReadError::trailing_content},
+	};
+	for (const auto &c : cases) {
+		const ReadError got = error_of(c.text);
+		if (!ITI_CHECK(got == c.want)) {
+			std::printf("  %s: got \"%s\"\n", c.text,
+			            std::string(iti::json::read_error_str(got)).c_str());
+		}
+		ITI_CHECK(same_as_nlohmann(c.text));
+	}
+
+	// truncated: every proper prefix of a document is an error, and most of
+	// them an unexpected end
+	const std::string doc = json::parse(R"({"name": "Hammer \"big\"",
+	    "categories": ["tools", "garden"], "price": -12.5e-1,
+	    "n": [true, false, null, {"x": []}]})")
+	                            .dump(1);
+	for (size_t n = 0; n < doc.size(); n++) {
+		const std::string text = doc.substr(0, n);
+		ITI_CHECK(error_of(text) != ReadError::none);
+		ITI_CHECK(same_as_nlohmann(text));
+	}
+
+	// the offset of the error is that of the token at fault
+	Reader r;
+	ITI_CHECK(r.parse("[1, 2 3]") && !r.read_array([&] {
+		int v;
+		return r.read(v);
+	}));
+	ITI_CHECK(r.error() == ReadError::unexpected_token &&
+	          r.error_offset() == 6);
+}
+
+// depth: objects and arrays nest `Reader::maxDepth` deep at most
+void depth() {
+	for (size_t d : {Reader::maxDepth, Reader::maxDepth + 1}) {
+		const std::string arrays =
+		    std::string(d, '[') + "1" + std::string(d, ']');
+		ITI_CHECK(error_of(arrays) == (d <= Reader::maxDepth
+		                                   ? ReadError::none
+		                                   : ReadError::too_deep));
+
+		std::string objects;
+		for (size_t i = 0; i < d; i++) {
+			objects += "{\"a\":";
+		}
+		objects += "1" + std::string(d, '}');
+		ITI_CHECK(error_of(objects) == (d <= Reader::maxDepth
+		                                    ? ReadError::none
+		                                    : ReadError::too_deep));
+	}
+}
+
+// integers: read into the type asked for, or out_of_range
+void integers() {
+	auto read = [](std::string_view text, auto &v) {
+		Reader r;
+		r.parse(text);
+		r.read(v);
+		return r.error();
+	};
+
+	int8_t i8;
+	ITI_CHECK(read("127", i8) == ReadError::none && i8 == 127);
+	ITI_CHECK(read("-128", i8) == ReadError::none && i8 == -128);
+	ITI_CHECK(read("128", i8) == ReadError::out_of_range);
+	ITI_CHECK(read("-129", i8) == ReadError::out_of_range);
+
+	uint8_t u8;
+	ITI_CHECK(read("255", u8) == ReadError::none && u8 == 255);
+	ITI_CHECK(read("256", u8) == ReadError::out_of_range);
+	ITI_CHECK(read("-1", u8) == ReadError::out_of_range);
+	ITI_CHECK(read("-0", u8) == ReadError::out_of_range);
+
+	int64_t i64;
+	ITI_CHECK(read("-9223372036854775808", i64) == ReadError::none &&
+	          i64 == INT64_MIN);
+	ITI_CHECK(read("9223372036854775807", i64) == ReadError::none &&
+	          i64 == INT64_MAX);
+	ITI_CHECK(read("9223372036854775808", i64) == ReadError::out_of_range);
+	ITI_CHECK(read("-9223372036854775809", i64) == ReadError::out_of_range);
+
+	uint64_t u64;
+	ITI_CHECK(read("18446744073709551615", u64) == ReadError::none &&
+	          u64 == UINT64_MAX);
+	ITI_CHECK(read("18446744073709551616", u64) == ReadError::out_of_range);
+	ITI_CHECK(read("99999999999999999999999", u64) ==
+	          ReadError::out_of_range);
+
+	// a fraction or an exponent isn't an integer, even when it's whole
+	ITI_CHECK(read("1.0", i64) == ReadError::wrong_type);
+	ITI_CHECK(read("1e2", u64) == ReadError::wrong_type);
+	ITI_CHECK(read("\"1\"", i64) == ReadError::wrong_type);
+	ITI_CHECK(read("01", i64) == ReadError::invalid_literal);
+	ITI_CHECK(read("", i64) == ReadError::empty);
+
+	double d;
+	ITI_CHECK(read("1e308", d) == ReadError::none && d == 1e308);
+	ITI_CHECK(read("-0.0", d) == ReadError::none && d == 0.0);
+	ITI_CHECK(read("1e400", d) == ReadError::out_of_range);
+	ITI_CHECK(read("true", d) == ReadError::wrong_type);
+}
+
+// skip: values are skipped whole, whatever they hold
+void skip() {
+	Reader r;
+	const char text[] = R"({"a": {"b": [1, "]}", {"c": "{["}]}, "s": "x]",
+	    "n": -1.5e3, "t": true, "z": null, "e": [], "o": {}, "last": 7})";
+	ITI_CHECK(r.parse(text));
+	int last = 0;
+	int skipped = 0;
+	ITI_CHECK(r.read_object([&](std::string_view key) {
+		if (key == "last") {
+			return r.read(last);
+		}
+		skipped++;
+		return r.skip();
+	}) && r.end());
+	ITI_CHECK(last == 7 && skipped == 7);
+
+	// a truncated value can't be skipped
+	ITI_CHECK(r.parse("[[1, [2]") && r.begin_array() && r.next_element());
+	ITI_CHECK(!r.skip() && r.error() == ReadError::unexpected_end);
+
+	// nor something that isn't a value
+	ITI_CHECK(r.parse("[1, ]") && r.begin_array() && r.next_element() &&
+	          r.skip() && !r.next_element());
+}
+
+struct Dimensions {
+	int width  = 0;
+	int height = 0;
+};
+
+bool read_json(Reader &r, Dimensions &d) {
+	using iti::json::field;
+	return iti::json::read_fields(r, d, field("width", &Dimensions::width),
+	                              field("height", &Dimensions::height));
+}
+
+struct Item {
+	std::string name;
+	uint64_t id = 0;
+	bool active = false;
+	double price = 0;
+	std::vector<std::string> tags;
+	std::vector<Dimensions> sizes;
+};
+
+bool read_item(Reader &r, Item &item) {
+	using iti::json::field;
+	return iti::json::read_fields(
+	    r, item, field("name", &Item::name), field("id", &Item::id),
+	    field("active", &Item::active), field("price", &Item::price),
+	    field("tags", &Item::tags), field("sizes", &Item::sizes));
+}
+
+// fields: members are read into the data members bound to their keys,
+// unknown ones are skipped, and a value of the wrong type fails
+void fields() {
+	Reader r;
+	Item item;
+	ITI_CHECK(r.parse(R"({"unknown": {"name": "no"}, "name": "Hammer",
+	    "id": 42, "active": true, "price": 9.5, "tags": ["a", "b\n"],
+	    "sizes": [{"width": 1, "height": 2}, {"height": 4, "depth": 9}]})"));
+	ITI_CHECK(read_item(r, item) && r.end());
+	ITI_CHECK(item.name == "Hammer" && item.id == 42 && item.active &&
+	          item.price == 9.5);
+	ITI_CHECK(item.tags == (std::vector<std::string>{"a", "b\n"}));
+	ITI_CHECK(item.sizes.size() == 2 && item.sizes[0].width == 1 &&
+	          item.sizes[0].height == 2 && item.sizes[1].width == 0 &&
+	          item.sizes[1].height == 4);
+
+	// the members that are missing keep their values
+	Item partial;
+	partial.id = 7;
+	ITI_CHECK(r.parse(R"({"name": "x"})") && read_item(r, partial) &&
+	          r.end() && partial.id == 7);
+
+	for (const char *bad :
+	     {R"({"id": -1})", R"({"id": "42"})", R"({"tags": "a"})",
+	      R"({"tags": [1]})", R"({"sizes": [{"width": 1.5}]})", R"([])"}) {
+		Item i;
+		ITI_CHECK(r.parse(bad) && !read_item(r, i));
+	}
+}
+
+} // namespace
+
+int main() {
+	corpus();
+	escapes();
+	utf8();
+	malformed();
+	depth();
+	integers();
+	skip();
+	fields();
+	return iti::test::report("json.reader");
+}
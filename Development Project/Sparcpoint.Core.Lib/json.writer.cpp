@@ -0,0 +1,254 @@
+#ifndef ITI_LIB_JSON_WRITER_CPP
+#define ITI_LIB_JSON_WRITER_CPP
+
+#include "pch.h"
+
+#include "json.writer.h"
+
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ITI_JSON_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+using iti::json::Writer;
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+#ifdef ITI_JSON_SSE2
+static inline unsigned first_set_bit(unsigned mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return idx;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// `next_escape()` returns the index of the first character of `s` at or
+// after `i` that must be escaped in a JSON string ('"', '\\' and the control
+// characters), or `s.size()`.
+static size_t next_escape(std::string_view s, size_t i) {
+#ifdef ITI_JSON_SSE2
+	const __m128i quote     = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control   = _mm_set1_epi8(0x1f);
+
+	for (; i + 16 <= s.size(); i += 16) {
+		__m128i chunk =
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(s.data() + i));
+
+		// unsigned c <= 0x1f is max(c, 0x1f) == 0x1f
+		__m128i special = _mm_or_si128(
+		    _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+		                 _mm_cmpeq_epi8(chunk, backslash)),
+		    _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+
+		unsigned mask = unsigned(_mm_movemask_epi8(special));
+		if (mask != 0) {
+			return i + first_set_bit(mask);
+		}
+	}
+#endif
+
+	for (; i < s.size(); i++) {
+		auto c = static_cast<unsigned char>(s[i]);
+		if (c == '"' || c == '\\' || c < 0x20) {
+			return i;
+		}
+	}
+	return s.size();
+}
+
+// writer
+// ----------------------------------------------------------------------------
+Writer &iti::json::Writer::begin_object() { return open('{', true); }
+Writer &iti::json::Writer::end_object() { return close('}', true); }
+Writer &iti::json::Writer::begin_array() { return open('[', false); }
+Writer &iti::json::Writer::end_array() { return close(']', false); }
+
+Writer &iti::json::Writer::key(std::string_view k) {
+	if (scopes.empty() || !scopes.back().isObject || afterKey) {
+		throw std::logic_error("json::Writer: key outside of an object");
+	}
+
+	separate();
+	append_string(k);
+	buf += style == Style::pretty ? ": " : ":";
+	afterKey = true;
+	return *this;
+}
+
+iti::encoding::Encoder &
+iti::json::Writer::write_string(std::string_view v) {
+	separate();
+	append_string(v);
+	return done();
+}
+
+iti::encoding::Encoder &iti::json::Writer::write_bool(bool v) {
+	separate();
+	buf += v ? "true" : "false";
+	return done();
+}
+
+iti::encoding::Encoder &iti::json::Writer::write_null() {
+	separate();
+	buf += "null";
+	return done();
+}
+
+iti::encoding::Encoder &iti::json::Writer::write_int(int64_t v) {
+	separate();
+	fmt::format_to(std::back_inserter(buf), "{}", v);
+	return done();
+}
+
+iti::encoding::Encoder &iti::json::Writer::write_uint(uint64_t v) {
+	separate();
+	fmt::format_to(std::back_inserter(buf), "{}", v);
+	return done();
+}
+
+iti::encoding::Encoder &iti::json::Writer::write_double(double v) {
+	if (!std::isfinite(v)) {
+		return write_null();
+	}
+
+	separate();
+	const size_t start = buf.size();
+	fmt::format_to(std::back_inserter(buf), "{}", v);
+	// a double stays one when read back: 10.0, not 10 (as nlohmann does)
+	if (buf.find_first_of(".e", start) == std::string::npos) {
+		buf += ".0";
+	}
+	return done();
+}
+
+Writer &iti::json::Writer::raw(std::string_view json) {
+	separate();
+	if (json.empty()) {
+		buf += "null";
+	} else {
+		buf.append(json.data(), json.size());
+	}
+	return done();
+}
+
+void iti::json::Writer::flush() {
+	if (sink && !buf.empty()) {
+		sink(buf);
+		buf.clear();
+	}
+}
+
+void iti::json::Writer::separate() {
+	if (afterKey) {
+		afterKey = false;
+		return;
+	}
+
+	if (scopes.empty()) {
+		return;
+	}
+
+	auto &scope = scopes.back();
+	if (!scope.empty) {
+		buf.push_back(',');
+	}
+	scope.empty = false;
+
+	if (style == Style::pretty) {
+		new_line();
+	}
+}
+
+Writer &iti::json::Writer::open(char c, bool isObject) {
+	separate();
+	buf.push_back(c);
+	scopes.push_back(Scope{isObject, true});
+	return *this;
+}
+
+Writer &iti::json::Writer::close(char c, bool isObject) {
+	if (scopes.empty() || scopes.back().isObject != isObject || afterKey) {
+		throw std::logic_error(
+		    fmt::format("json::Writer: unexpected '{}'", c));
+	}
+
+	bool empty = scopes.back().empty;
+	scopes.pop_back();
+	if (style == Style::pretty && !empty) {
+		new_line();
+	}
+	buf.push_back(c);
+	return done();
+}
+
+void iti::json::Writer::new_line() {
+	buf.push_back('\n');
+	buf.append(scopes.size() * 4, ' ');
+}
+
+void iti::json::Writer::append_string(std::string_view s) {
+	static constexpr char hex[] = "0123456789abcdef";
+
+	buf.push_back('"');
+
+	size_t i = 0;
+	while (i < s.size()) {
+		size_t esc = next_escape(s, i);
+		buf.append(s.data() + i, esc - i);
+		if (esc == s.size()) {
+			break;
+		}
+
+		auto c = static_cast<unsigned char>(s[esc]);
+		switch (c) {
+		case '"':
+			buf += "\\\"";
+			break;
+		case '\\':
+			buf += "\\\\";
+			break;
+		case '\b':
+			buf += "\\b";
+			break;
+		case '\f':
+			buf += "\\f";
+			break;
+		case '\n':
+			buf += "\\n";
+			break;
+		case '\r':
+			buf += "\\r";
+			break;
+		case '\t':
+			buf += "\\t";
+			break;
+		default:
+			buf += "\\u00";
+			buf.push_back(hex[c >> 4]);
+			buf.push_back(hex[c & 0xf]);
+			break;
+		}
+
+		i = esc + 1;
+	}
+
+	buf.push_back('"');
+}
+
+#endif // ITI_LIB_JSON_WRITER_CPP
@@ -0,0 +1,117 @@
+#ifndef ITI_LIB_JSON_WRITER_H
+#define ITI_LIB_JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "encoding.h"
+
+namespace iti {
+namespace json {
+
+// Style selects the layout of the output of a Writer.
+enum class Style {
+	compact, // no whitespace at all
+	pretty,  // one member per line, indented by 4 spaces
+};
+
+// Writer streams JSON text to a sink, without building a document first.
+//
+//	iti::json::Writer w([&resp](std::string_view chunk) {
+//		resp.append(chunk);
+//	});
+//	w.begin_object();
+//	w.key("id").value(42);
+//	w.key("name").value("Fake Product");
+//	w.end_object();
+//	w.flush();
+//
+// The output is buffered and handed to the sink in chunks of about
+// `flushSize` bytes, and whatever is left on `flush()`. A Writer without a
+// sink keeps everything, see `str()`.
+//
+// Strings must be UTF-8; they are escaped as they are copied, skipping the
+// runs that need no escaping 16 bytes at a time. Doubles are written in the
+// shortest form that reads back the same, always with a fraction or an
+// exponent ("10.0"); non-finite ones, which JSON can't represent, as null.
+// The output is the same as `nlohmann::json::dump()`'s.
+class Writer : public iti::encoding::Encoder {
+  public:
+	using Sink = iti::encoding::Sink;
+
+	// size of the chunks handed to the sink
+	static constexpr size_t flushSize = 4 * 1024;
+
+	explicit Writer(Style style = Style::compact) : style(style) {}
+	explicit Writer(Sink sink, Style style = Style::compact)
+	    : sink(std::move(sink)), style(style) {}
+
+	Writer(const Writer &) = delete;
+	Writer &operator=(const Writer &) = delete;
+
+	iti::encoding::Format format() const override {
+		return iti::encoding::Format::json;
+	}
+
+	Writer &begin_object() override;
+	Writer &end_object() override;
+	Writer &begin_array() override;
+	Writer &end_array() override;
+	Writer &key(std::string_view k) override;
+
+	// raw writes `json`, a serialized JSON value, as it is (and null if it
+	// is empty). It isn't checked nor re-indented.
+	Writer &raw(std::string_view json);
+
+	void flush() override;
+
+	// str returns the output of a Writer without a sink.
+	std::string_view str() const { return buf; }
+
+	// depth returns the number of objects and arrays still open.
+	size_t depth() const { return scopes.size(); }
+
+  protected:
+	Encoder &write_string(std::string_view v) override;
+	Encoder &write_bool(bool v) override;
+	Encoder &write_null() override;
+	Encoder &write_int(int64_t v) override;
+	Encoder &write_uint(uint64_t v) override;
+	Encoder &write_double(double v) override;
+
+  private:
+	struct Scope {
+		bool isObject;
+		bool empty;
+	};
+
+	// separate writes what comes before a value or a key: a comma, and a
+	// new line in pretty mode. A value following its key needs neither.
+	void separate();
+
+	Writer &open(char c, bool isObject);
+	Writer &close(char c, bool isObject);
+	void new_line();
+	void append_string(std::string_view s);
+
+	Writer &done() {
+		if (sink && buf.size() >= flushSize) {
+			flush();
+		}
+		return *this;
+	}
+
+	Sink sink;
+	Style style;
+	std::string buf;
+	std::vector<Scope> scopes;
+	bool afterKey = false;
+};
+
+} // namespace json
+} // namespace iti
+
+#endif // ITI_LIB_JSON_WRITER_H
@@ -0,0 +1,197 @@
+// json::Writer tests (see "test.h"): ./run.sh json.writer.test.cpp
+//
+// The output is compared byte for byte with `nlohmann::json::dump`, which
+// escapes the same characters, in the same way, and writes the same
+// shortest form of each double.
+
+#include "test.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "json.hpp"
+
+#include "json.writer.h"
+
+using iti::json::Style;
+using iti::json::Writer;
+using json = nlohmann::ordered_json;
+
+template <class T> static bool same_as_nlohmann(T v) {
+	Writer w;
+	w.value(v);
+	return w.str() == json(v).dump();
+}
+
+static void scalars() {
+	for (int64_t v : {0LL, 1LL, -1LL, 9LL, 10LL, 4294967296LL}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<int64_t>::min()));
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<int64_t>::max()));
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<uint64_t>::max()));
+
+	for (double v : {0.0, -0.0, 0.5, -3.25, 0.1, 1.0 / 3, 1e10, 1e21, 1e300,
+	                 -1e-300, 5e-324, std::numeric_limits<double>::max()}) {
+		ITI_CHECK(same_as_nlohmann(v));
+		// and it reads back as the same double
+		Writer w;
+		w.value(v);
+		ITI_CHECK(json::parse(w.str()).get<double>() == v);
+	}
+	ITI_CHECK(same_as_nlohmann(true));
+	ITI_CHECK(same_as_nlohmann(false));
+	ITI_CHECK(same_as_nlohmann(nullptr));
+}
+
+// non-finite doubles have no JSON form: they are null, as with nlohmann
+static void non_finite() {
+	for (double v : {std::numeric_limits<double>::infinity(),
+	                 -std::numeric_limits<double>::infinity(),
+	                 std::numeric_limits<double>::quiet_NaN()}) {
+		Writer w;
+		w.begin_array().value(v).value(1).end_array();
+		ITI_CHECK(w.str() == "[null,1]");
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+}
+
+// strings: quotes, backslashes and every control character are escaped,
+// the rest (UTF-8 included) is copied, whether the escape falls in the
+// 16-byte runs or in the tail
+static void strings() {
+	for (int c = 0; c < 0x80; c++) {
+		ITI_CHECK(same_as_nlohmann(std::string(1, char(c))));
+	}
+	std::string controls;
+	for (int c = 0; c < 0x20; c++) {
+		controls.push_back(char(c));
+	}
+	ITI_CHECK(same_as_nlohmann(controls));
+	ITI_CHECK(same_as_nlohmann(std::string("\x7f/\xc3\xa9\xe2\x82\xac\xf0"
+	                                       "\x9f\x98\x80")));
+
+	const std::string specials = "\"\\\n\t\x01\x1f";
+	for (size_t pos = 0; pos < 40; pos++) {
+		for (char c : specials) {
+			std::string s(40, 'a');
+			s[pos] = c;
+			ITI_CHECK(same_as_nlohmann(s));
+		}
+	}
+	ITI_CHECK(same_as_nlohmann(std::string(1000, '"')));
+	ITI_CHECK(same_as_nlohmann(std::string()));
+
+	// keys are escaped as values are
+	Writer w;
+	w.begin_object().key("a\"b\n").value(1).end_object();
+	json j;
+	j["a\"b\n"] = 1;
+	ITI_CHECK(w.str() == j.dump());
+}
+
+// document builds the same document with `w` and as a json.
+static json document(Writer &w) {
+	json j = json::object();
+	w.begin_object();
+	w.key("id").value(42);
+	j["id"] = 42;
+	w.key("name").value("Fake \"Product\"");
+	j["name"] = "Fake \"Product\"";
+	w.key("price").value(9.99);
+	j["price"] = 9.99;
+	w.key("empty object").begin_object().end_object();
+	j["empty object"] = json::object();
+	w.key("empty array").begin_array().end_array();
+	j["empty array"] = json::array();
+	w.key("categories").begin_array();
+	j["categories"] = json::array();
+	for (int i = 0; i < 3; i++) {
+		w.begin_object().key("id").value(i).key("tags").begin_array();
+		w.value("t").value(nullptr).end_array().end_object();
+		j["categories"].push_back({{"id", i}, {"tags", {"t", nullptr}}});
+	}
+	w.end_array();
+	w.end_object();
+	return j;
+}
+
+static void nesting() {
+	Writer compact;
+	json j = document(compact);
+	ITI_CHECK(compact.str() == j.dump());
+	ITI_CHECK(compact.depth() == 0);
+
+	// pretty is nlohmann's dump(4)
+	Writer pretty(Style::pretty);
+	document(pretty);
+	ITI_CHECK(pretty.str() == j.dump(4));
+
+	constexpr int depth = 500;
+	Writer deep;
+	json d = 1;
+	for (int i = 0; i < depth; i++) {
+		deep.begin_array();
+	}
+	deep.value(1);
+	for (int i = 0; i < depth; i++) {
+		deep.end_array();
+		d = json::array({d});
+	}
+	ITI_CHECK(deep.str() == d.dump());
+
+	// raw values are copied, and an empty one is null
+	Writer raw;
+	raw.begin_array().raw("{\"a\":[1,2]}").raw("").end_array();
+	ITI_CHECK(raw.str() == "[{\"a\":[1,2]},null]");
+}
+
+// sink: the output is handed over in chunks of about `flushSize` bytes as it
+// is written, and what is left on flush
+static void sink() {
+	std::string out;
+	size_t chunks = 0;
+	Writer w([&](std::string_view chunk) {
+		out.append(chunk.data(), chunk.size());
+		chunks++;
+	});
+
+	json j = json::array();
+	w.begin_array();
+	for (int i = 0; i < 1000; i++) {
+		w.value("value " + std::to_string(i));
+		j.push_back("value " + std::to_string(i));
+	}
+	ITI_CHECK(chunks >= 2);
+	w.end_array();
+	w.flush();
+	ITI_CHECK(out == j.dump());
+}
+
+static void errors() {
+	Writer w;
+	ITI_CHECK_THROWS(w.end_object(), std::logic_error);
+	ITI_CHECK_THROWS(w.key("a"), std::logic_error);
+	w.begin_array();
+	ITI_CHECK_THROWS(w.end_object(), std::logic_error);
+	ITI_CHECK_THROWS(w.key("a"), std::logic_error);
+	w.end_array();
+
+	Writer k;
+	k.begin_object().key("a");
+	ITI_CHECK_THROWS(k.key("b"), std::logic_error);
+	ITI_CHECK_THROWS(k.end_object(), std::logic_error);
+}
+
+int main() {
+	scalars();
+	non_finite();
+	strings();
+	nesting();
+	sink();
+	errors();
+	return iti::test::report("json.writer");
+}
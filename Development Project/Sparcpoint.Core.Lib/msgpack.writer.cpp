@@ -0,0 +1,229 @@
+#ifndef ITI_LIB_MSGPACK_WRITER_CPP
+#define ITI_LIB_MSGPACK_WRITER_CPP
+
+#include "pch.h"
+
+#include "msgpack.writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+using iti::msgpack::Writer;
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+// `put_be()` appends the `n` low bytes of `v` to `out`, big-endian first.
+static inline void put_be(std::string &out, uint64_t v, size_t n) {
+	for (size_t i = n; i > 0; i--) {
+		out.push_back(char((v >> (8 * (i - 1))) & 0xff));
+	}
+}
+
+// `put_head()` appends a type byte followed by a big-endian argument.
+static inline void put_head(std::string &out, uint8_t type, uint64_t v,
+                            size_t n) {
+	out.push_back(char(type));
+	put_be(out, v, n);
+}
+
+// writer
+// ----------------------------------------------------------------------------
+Writer &iti::msgpack::Writer::begin_object() { return open(true); }
+Writer &iti::msgpack::Writer::end_object() { return close(true); }
+Writer &iti::msgpack::Writer::begin_array() { return open(false); }
+Writer &iti::msgpack::Writer::end_array() { return close(false); }
+
+Writer &iti::msgpack::Writer::key(std::string_view k) {
+	if (scopes.empty() || !scopes.back().isObject) {
+		throw std::logic_error("msgpack::Writer: key outside of a map");
+	}
+
+	scopes.back().count++;
+	append_string(k);
+	return *this;
+}
+
+iti::encoding::Encoder &
+iti::msgpack::Writer::write_string(std::string_view v) {
+	element();
+	append_string(v);
+	return done();
+}
+
+iti::encoding::Encoder &iti::msgpack::Writer::write_bool(bool v) {
+	element();
+	buf.push_back(char(v ? 0xc3 : 0xc2));
+	return done();
+}
+
+iti::encoding::Encoder &iti::msgpack::Writer::write_null() {
+	element();
+	buf.push_back(char(0xc0));
+	return done();
+}
+
+iti::encoding::Encoder &iti::msgpack::Writer::write_int(int64_t v) {
+	if (v >= 0) {
+		return write_uint(uint64_t(v));
+	}
+
+	element();
+	if (v >= -32) {
+		buf.push_back(char(v)); // negative fixint, 0xe0 - 0xff
+	} else if (v >= std::numeric_limits<int8_t>::min()) {
+		put_head(buf, 0xd0, uint64_t(v), 1);
+	} else if (v >= std::numeric_limits<int16_t>::min()) {
+		put_head(buf, 0xd1, uint64_t(v), 2);
+	} else if (v >= std::numeric_limits<int32_t>::min()) {
+		put_head(buf, 0xd2, uint64_t(v), 4);
+	} else {
+		put_head(buf, 0xd3, uint64_t(v), 8);
+	}
+	return done();
+}
+
+iti::encoding::Encoder &iti::msgpack::Writer::write_uint(uint64_t v) {
+	element();
+	if (v <= 0x7f) {
+		buf.push_back(char(v)); // positive fixint
+	} else if (v <= std::numeric_limits<uint8_t>::max()) {
+		put_head(buf, 0xcc, v, 1);
+	} else if (v <= std::numeric_limits<uint16_t>::max()) {
+		put_head(buf, 0xcd, v, 2);
+	} else if (v <= std::numeric_limits<uint32_t>::max()) {
+		put_head(buf, 0xce, v, 4);
+	} else {
+		put_head(buf, 0xcf, v, 8);
+	}
+	return done();
+}
+
+iti::encoding::Encoder &iti::msgpack::Writer::write_double(double v) {
+	element();
+
+	// a float32 is enough if it holds the value exactly. Narrowing a double
+	// out of float's range is undefined: check it first, as nlohmann does.
+	const bool inRange = v >= double(std::numeric_limits<float>::lowest()) &&
+	                     v <= double(std::numeric_limits<float>::max());
+	const float f      = inRange ? static_cast<float>(v) : 0.0f;
+	if (inRange && double(f) == v) {
+		uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		put_head(buf, 0xca, bits, 4);
+	} else {
+		uint64_t bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		put_head(buf, 0xcb, bits, 8);
+	}
+	return done();
+}
+
+void iti::msgpack::Writer::flush() {
+	// the headers of open maps and arrays are still to be patched
+	if (sink && !buf.empty() && scopes.empty()) {
+		sink(buf);
+		buf.clear();
+	}
+}
+
+void iti::msgpack::Writer::element() {
+	if (!scopes.empty() && !scopes.back().isObject) {
+		scopes.back().count++;
+	}
+}
+
+Writer &iti::msgpack::Writer::open(bool isObject) {
+	element();
+
+	// the header is only known on close: it gets a slot of the largest size
+	scopes.push_back(Scope{buf.size(), 0, isObject});
+	buf.append(maxHeadSize, '\0');
+	return *this;
+}
+
+Writer &iti::msgpack::Writer::close(bool isObject) {
+	if (scopes.empty() || scopes.back().isObject != isObject) {
+		throw std::logic_error(
+		    fmt::format("msgpack::Writer: unexpected end of {}",
+		                isObject ? "map" : "array"));
+	}
+
+	Scope scope = scopes.back();
+	scopes.pop_back();
+
+	// the header goes at the end of its slot, the bytes before it are a gap
+	char *slot = &buf[scope.offset];
+	size_t size;
+	if (scope.count <= 15) {
+		size = 1;
+		slot[maxHeadSize - 1] = char((isObject ? 0x80 : 0x90) | scope.count);
+	} else if (scope.count <= std::numeric_limits<uint16_t>::max()) {
+		size = 3;
+		slot[2] = char(isObject ? 0xde : 0xdc);
+		slot[3] = char(scope.count >> 8);
+		slot[4] = char(scope.count);
+	} else {
+		size = 5;
+		slot[0] = char(isObject ? 0xdf : 0xdd);
+		slot[1] = char(scope.count >> 24);
+		slot[2] = char(scope.count >> 16);
+		slot[3] = char(scope.count >> 8);
+		slot[4] = char(scope.count);
+	}
+	if (size < maxHeadSize) {
+		gaps.push_back(Gap{scope.offset, maxHeadSize - size});
+	}
+
+	if (scopes.empty()) {
+		compact();
+	}
+	return done();
+}
+
+void iti::msgpack::Writer::compact() {
+	if (gaps.empty()) {
+		return;
+	}
+
+	// gaps are recorded as maps and arrays close, the inner ones first
+	std::sort(gaps.begin(), gaps.end(), [](const Gap &a, const Gap &b) {
+		return a.offset < b.offset;
+	});
+
+	size_t out = gaps.front().offset;
+	for (size_t i = 0; i < gaps.size(); i++) {
+		size_t from = gaps[i].offset + gaps[i].size;
+		size_t to = i + 1 < gaps.size() ? gaps[i + 1].offset : buf.size();
+		std::memmove(&buf[out], &buf[from], to - from);
+		out += to - from;
+	}
+	buf.resize(out);
+	gaps.clear();
+}
+
+void iti::msgpack::Writer::append_string(std::string_view s) {
+	if (s.size() <= 31) {
+		buf.push_back(char(0xa0 | s.size())); // fixstr
+	} else if (s.size() <= std::numeric_limits<uint8_t>::max()) {
+		put_head(buf, 0xd9, s.size(), 1);
+	} else if (s.size() <= std::numeric_limits<uint16_t>::max()) {
+		put_head(buf, 0xda, s.size(), 2);
+	} else {
+		put_head(buf, 0xdb, s.size(), 4);
+	}
+	buf.append(s.data(), s.size());
+}
+
+Writer &iti::msgpack::Writer::done() {
+	if (scopes.empty()) {
+		flush();
+	}
+	return *this;
+}
+
+#endif // ITI_LIB_MSGPACK_WRITER_CPP
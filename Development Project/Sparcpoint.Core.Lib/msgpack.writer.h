@@ -0,0 +1,94 @@
+#ifndef ITI_LIB_MSGPACK_WRITER_H
+#define ITI_LIB_MSGPACK_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "encoding.h"
+
+namespace iti {
+namespace msgpack {
+
+// Writer streams MessagePack (https://msgpack.org) to a sink, always using
+// the smallest representation of each value, as `nlohmann::json::to_msgpack`
+// does.
+//
+// MessagePack maps and arrays start with their number of elements, which is
+// only known once they are closed. Each one gets room for the largest
+// header, filled in on close; the unused bytes are squeezed out in a single
+// pass when the outermost one is closed, and the output is handed to the
+// sink then, and on `flush()`.
+class Writer : public iti::encoding::Encoder {
+  public:
+	using Sink = iti::encoding::Sink;
+
+	explicit Writer(Sink sink = nullptr) : sink(std::move(sink)) {}
+
+	Writer(const Writer &) = delete;
+	Writer &operator=(const Writer &) = delete;
+
+	iti::encoding::Format format() const override {
+		return iti::encoding::Format::msgpack;
+	}
+
+	Writer &begin_object() override;
+	Writer &end_object() override;
+	Writer &begin_array() override;
+	Writer &end_array() override;
+	Writer &key(std::string_view k) override;
+
+	void flush() override;
+
+	// str returns the output of a Writer without a sink.
+	std::string_view str() const { return buf; }
+
+  protected:
+	Encoder &write_string(std::string_view v) override;
+	Encoder &write_bool(bool v) override;
+	Encoder &write_null() override;
+	Encoder &write_int(int64_t v) override;
+	Encoder &write_uint(uint64_t v) override;
+	Encoder &write_double(double v) override;
+
+  private:
+	// Scope is an open map or array: where its header goes, and how many
+	// elements (key/value pairs for a map) it has so far.
+	struct Scope {
+		size_t offset;
+		uint32_t count;
+		bool isObject;
+	};
+
+	// Gap is the unused part of the room left for a header.
+	struct Gap {
+		size_t offset;
+		size_t size;
+	};
+
+	// room left for the header of a map or array: a type byte and a 32-bit
+	// count
+	static constexpr size_t maxHeadSize = 5;
+
+	// element counts one more element of the enclosing array.
+	void element();
+
+	Writer &open(bool isObject);
+	Writer &close(bool isObject);
+	// compact removes the gaps, once the outermost map or array is closed.
+	void compact();
+	void append_string(std::string_view s);
+	Writer &done();
+
+	Sink sink;
+	std::string buf;
+	std::vector<Scope> scopes;
+	std::vector<Gap> gaps;
+};
+
+} // namespace msgpack
+} // namespace iti
+
+#endif // ITI_LIB_MSGPACK_WRITER_H
@@ -0,0 +1,174 @@
+// msgpack::Writer tests (see "test.h"): ./run.sh msgpack.writer.test.cpp
+//
+// The output is compared byte for byte with `nlohmann::json::to_msgpack`,
+// which also writes the smallest representation of each value, including
+// doubles narrowed to float32 when that is exact.
+
+#include "test.h"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "msgpack.writer.h"
+
+using iti::msgpack::Writer;
+using json = nlohmann::ordered_json;
+
+static std::string to_msgpack(const json &j) {
+	auto bytes = json::to_msgpack(j);
+	return std::string(bytes.begin(), bytes.end());
+}
+
+template <class T> static bool same_as_nlohmann(T v) {
+	Writer w;
+	w.value(v);
+	return w.str() == to_msgpack(json(v));
+}
+
+static void scalars() {
+	for (int64_t v : {0LL, 1LL, 127LL, 128LL, 255LL, 256LL, 65535LL, 65536LL,
+	                  4294967295LL, 4294967296LL, -1LL, -32LL, -33LL, -128LL,
+	                  -129LL, -32768LL, -32769LL, -2147483648LL,
+	                  -2147483649LL}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<int64_t>::min()));
+	ITI_CHECK(same_as_nlohmann(std::numeric_limits<uint64_t>::max()));
+
+	// float32 when it holds the value exactly, float64 otherwise
+	for (double v : {0.0, 0.5, -3.25, 1e10, 0.1, 9.99, 1e300, -1e-300}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+	// out of float's range, which can't be narrowed to check, and NaN
+	for (double v : {double(std::numeric_limits<float>::max()),
+	                 double(std::numeric_limits<float>::lowest()), 1e39,
+	                 -1e39, std::numeric_limits<double>::max(),
+	                 std::numeric_limits<double>::infinity(),
+	                 -std::numeric_limits<double>::infinity(),
+	                 std::numeric_limits<double>::quiet_NaN()}) {
+		ITI_CHECK(same_as_nlohmann(v));
+	}
+	{
+		Writer w;
+		w.value(0.5);
+		ITI_CHECK(w.str().size() == 5 && uint8_t(w.str()[0]) == 0xca);
+	}
+
+	for (size_t n : {0, 31, 32, 255, 256, 65535, 65536}) {
+		ITI_CHECK(same_as_nlohmann(std::string(n, 'x')));
+	}
+	ITI_CHECK(same_as_nlohmann(true));
+	ITI_CHECK(same_as_nlohmann(false));
+	ITI_CHECK(same_as_nlohmann(nullptr));
+}
+
+// containers: the header sizes, each side of the fixmap/fixarray, 16-bit and
+// 32-bit limits
+static void containers() {
+	for (size_t n : {0, 15, 16, 65535, 65536}) {
+		Writer arr;
+		json jarr = json::array();
+		arr.begin_array();
+		for (size_t i = 0; i < n; i++) {
+			arr.value(i % 200);
+			jarr.push_back(i % 200);
+		}
+		arr.end_array();
+		ITI_CHECK(arr.str() == to_msgpack(jarr));
+
+		Writer obj;
+		json jobj = json::object();
+		obj.begin_object();
+		for (size_t i = 0; i < n; i++) {
+			auto k = std::to_string(i);
+			obj.key(k).value(i);
+			jobj[k] = i;
+		}
+		obj.end_object();
+		ITI_CHECK(obj.str() == to_msgpack(jobj));
+	}
+}
+
+// documents: nested maps and arrays of every header size, as a listing of
+// products is
+static void documents() {
+	Writer w;
+	json j = json::array();
+	w.begin_array();
+	for (int p = 0; p < 20; p++) {
+		json product = {{"id", p},
+		                {"name", "Product " + std::to_string(p)},
+		                {"price", p * 1.25},
+		                {"active", p % 2 == 0},
+		                {"description", nullptr}};
+		w.begin_object();
+		w.key("id").value(p);
+		w.key("name").value("Product " + std::to_string(p));
+		w.key("price").value(p * 1.25);
+		w.key("active").value(p % 2 == 0);
+		w.key("description").value(nullptr);
+
+		json categories = json::array();
+		w.key("categories").begin_array();
+		for (int c = 0; c < p; c++) {
+			w.begin_object().key("id").value(c).end_object();
+			categories.push_back({{"id", c}});
+		}
+		w.end_array();
+		product["categories"] = categories;
+
+		json empty = json::object();
+		w.key("attributes").begin_object().end_object();
+		product["attributes"] = empty;
+
+		w.end_object();
+		j.push_back(product);
+	}
+	w.end_array();
+	ITI_CHECK(w.str() == to_msgpack(j));
+	ITI_CHECK(json::from_msgpack(w.str()) == j);
+}
+
+// sink: the output is handed over once the outermost container is closed,
+// and top-level values one after another
+static void sink() {
+	std::vector<std::string> chunks;
+	Writer w([&](std::string_view chunk) { chunks.emplace_back(chunk); });
+
+	w.begin_object().key("a").begin_array().value(1).value(2);
+	w.end_array();
+	ITI_CHECK(chunks.empty());
+	w.flush();
+	ITI_CHECK(chunks.empty());
+	w.end_object();
+	ITI_CHECK(chunks.size() == 1 &&
+	          chunks[0] == to_msgpack(json{{"a", {1, 2}}}));
+
+	w.value(7);
+	ITI_CHECK(chunks.size() == 2 && chunks[1] == to_msgpack(json(7)));
+	w.begin_array().end_array();
+	ITI_CHECK(chunks.size() == 3 && chunks[2] == to_msgpack(json::array()));
+}
+
+static void errors() {
+	Writer w;
+	ITI_CHECK_THROWS(w.key("a"), std::logic_error);
+	ITI_CHECK_THROWS(w.end_object(), std::logic_error);
+	w.begin_array();
+	ITI_CHECK_THROWS(w.key("a"), std::logic_error);
+	ITI_CHECK_THROWS(w.end_object(), std::logic_error);
+}
+
+int main() {
+	scalars();
+	containers();
+	documents();
+	sink();
+	errors();
+	return iti::test::report("msgpack.writer");
+}
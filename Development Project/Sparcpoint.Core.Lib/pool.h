@@ -0,0 +1,123 @@
+#ifndef ITI_LIB_POOL_H
+#define ITI_LIB_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace iti {
+
+// ObjectPool recycles objects of type `T`, so that steady-state traffic
+// reuses request scaffolding (and the string and vector capacity it grew)
+// instead of going back to the heap for every request.
+//
+//	auto req = iti::ObjectPool<Request>::acquire();
+//	...
+//	iti::ObjectPool<Request>::release(std::move(req));
+//
+// `T` must be default constructible and have a `void reset()` member that
+// puts it back in its initial state, keeping its capacity.
+//
+// Objects are handed out as `shared_ptr`s and the pool keeps the pointer
+// itself, control block included, so a recycled object costs no allocation
+// at all. Each thread has a small cache it can use without locking; the
+// overflow, and the cache of a thread that exits, go to a shared depot.
+template <class T> class ObjectPool {
+  public:
+	// maximum number of objects cached per thread
+	static constexpr size_t localCapacity = 32;
+
+	// maximum number of objects kept in the shared depot
+	static constexpr size_t sharedCapacity = 1024;
+
+	// acquire returns a recycled object, or a new one if none is cached.
+	static std::shared_ptr<T> acquire() {
+		auto &cache = local();
+		if (!cache.items.empty()) {
+			auto obj = std::move(cache.items.back());
+			cache.items.pop_back();
+			return obj;
+		}
+
+		// refill half of the local cache from the depot in one go
+		auto &d = depot();
+		{
+			std::scoped_lock<std::mutex> l(d.mtx);
+			size_t n = std::min(d.items.size(), localCapacity / 2);
+			for (size_t i = 0; i < n; i++) {
+				cache.items.emplace_back(std::move(d.items.back()));
+				d.items.pop_back();
+			}
+		}
+
+		if (!cache.items.empty()) {
+			auto obj = std::move(cache.items.back());
+			cache.items.pop_back();
+			return obj;
+		}
+
+		return std::make_shared<T>();
+	}
+
+	// release resets `obj` and keeps it for reuse. Objects still referenced
+	// elsewhere are left alone.
+	static void release(std::shared_ptr<T> &&obj) {
+		if (obj == nullptr || obj.use_count() != 1) {
+			return;
+		}
+
+		obj->reset();
+
+		auto &cache = local();
+		if (cache.items.size() < localCapacity) {
+			cache.items.emplace_back(std::move(obj));
+			return;
+		}
+
+		// the local cache is full: hand half of it to the depot
+		cache.flush(localCapacity / 2);
+		cache.items.emplace_back(std::move(obj));
+	}
+
+  private:
+	struct Depot {
+		std::mutex mtx;
+		std::vector<std::shared_ptr<T>> items;
+	};
+
+	struct LocalCache {
+		std::vector<std::shared_ptr<T>> items;
+
+		LocalCache() { items.reserve(localCapacity); }
+		~LocalCache() { flush(items.size()); }
+
+		// flush moves `n` objects to the depot, dropping what doesn't fit.
+		void flush(size_t n) {
+			auto &d = depot();
+			std::scoped_lock<std::mutex> l(d.mtx);
+			for (size_t i = 0; i < n && !items.empty(); i++) {
+				if (d.items.size() < sharedCapacity) {
+					d.items.emplace_back(std::move(items.back()));
+				}
+				items.pop_back();
+			}
+		}
+	};
+
+	static Depot &depot() {
+		static Depot d;
+		return d;
+	}
+
+	static LocalCache &local() {
+		thread_local LocalCache cache;
+		return cache;
+	}
+};
+
+} // namespace iti
+
+#endif // ITI_LIB_POOL_H
@@ -7,8 +7,8 @@
 
 // route params
 // ----------------------------------------------------------------------------
-void iti::http::router::RouteParams::add(const std::string &key,
-                                         const std::string &value) {
+void iti::http::router::RouteParams::add(std::string_view key,
+                                         std::string_view value) {
 	keys.emplace_back(key);
 	values.emplace_back(value);
 }
@@ -16,12 +16,13 @@ void iti::http::router::RouteParams::add(const std::string &key,
 bool iti::http::router::RouteParams::try_get(const std::string &key,
                                              std::string &value) {
 
-	auto result = std::find(keys.begin(), keys.end(), key);
-	if (result != keys.end()) {
-		size_t idx = result - keys.begin();
-		if (idx < values.size()) {
-			value = values[idx];
-			return true;
+	for (size_t idx = 0; idx < keys.size(); idx++) {
+		if (std::string_view(keys[idx]) == key) {
+			if (idx < values.size()) {
+				value.assign(values[idx].data(), values[idx].size());
+				return true;
+			}
+			break;
 		}
 	}
 
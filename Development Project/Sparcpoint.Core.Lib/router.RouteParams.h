@@ -1,7 +1,9 @@
 #ifndef ITI_LIB_HTTP_ROUTER_ROUTEPARAMS_H
 #define ITI_LIB_HTTP_ROUTER_ROUTEPARAMS_H
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace iti {
@@ -9,12 +11,18 @@ namespace http {
 namespace router {
 
 // RouteParams is a structure to track URL routing parameters efficiently.
+// Keys and values are allocated from `mr`, normally the request arena (see
+// "arena.h").
 class RouteParams {
   public:
-	std::vector<std::string> keys;
-	std::vector<std::string> values;
+	explicit RouteParams(
+	    std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+	    : keys(mr), values(mr) {}
 
-	void add(const std::string &key, const std::string &value);
+	std::pmr::vector<std::pmr::string> keys;
+	std::pmr::vector<std::pmr::string> values;
+
+	void add(std::string_view key, std::string_view value);
 	bool try_get(const std::string &key, std::string &value);
 	std::string get(const std::string &key);
 };
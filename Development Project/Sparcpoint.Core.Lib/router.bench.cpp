@@ -0,0 +1,167 @@
+// Routing micro-benchmarks (see "bench.h"): ./run.sh router.bench.cpp
+
+#define ITI_BENCH_COUNT_ALLOCATIONS
+#include "bench.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "http.h"
+#include "router.mux.h"
+#include "router.static.h"
+#include "router.tree.h"
+
+using iti::http::Method;
+using iti::http::Request;
+using iti::http::Response;
+using iti::http::Uri;
+using iti::http::router::Endpoint;
+using iti::http::router::Endpoints;
+using iti::http::router::Mux;
+using iti::http::router::static_route;
+using iti::http::router::static_router;
+
+namespace {
+
+// NullResponse drops what is written to it.
+class NullResponse : public Response {
+  public:
+	void write(const std::string & /*body*/ = "") override {}
+	void append(std::string_view /*chunk*/) override {}
+};
+
+void no_op(const Request & /*req*/, Response & /*resp*/) {}
+
+static constexpr char productsPattern[] = "/api/v1/products";
+static constexpr char productPattern[]  = "/api/v1/products/{id:u64}";
+
+// the product routes of Interview.Web, as a compile-time table
+using StaticApi = static_router<
+    static_route<Method::GET, productsPattern, no_op>,
+    static_route<Method::POST, productsPattern, no_op>,
+    static_route<Method::GET, productPattern, no_op>,
+    static_route<Method::DEL, productPattern, no_op>>;
+
+// route routes a GET of `path` through `router`.
+void route(iti::http::IHandler &router, Request &req, Response &resp,
+           const char *path) {
+	req.method = Method::GET;
+	Uri::parse(path, req.url);
+	router.handle_request(req, resp);
+	iti::bench::keep(resp.status);
+	req.reset();
+	resp.reset();
+}
+
+} // namespace
+
+namespace before {
+
+// Endpoints as it was before the fixed array: a miss threw from at().
+class Endpoints {
+  public:
+	std::unordered_map<Method, std::shared_ptr<Endpoint>> collection;
+
+	std::shared_ptr<Endpoint> operator[](const Method method) const {
+		std::shared_ptr<Endpoint> ep = nullptr;
+
+		try {
+			ep = collection.at(method);
+		} catch (const std::out_of_range &) {
+		}
+
+		return ep;
+	}
+};
+
+} // namespace before
+
+// unmatched methods: a POST to a route that only has a GET
+static void unmatched_methods() {
+	before::Endpoints oldEndpoints;
+	oldEndpoints.collection[Method::GET] = std::make_shared<Endpoint>();
+	iti::bench::run("Endpoints lookup of a missing method, before", 200000,
+	                [&] {
+		                iti::bench::keep(oldEndpoints[Method::POST].get());
+	                });
+
+	Endpoints endpoints;
+	endpoints.collection[Endpoints::slot_of(Method::GET)] =
+	    std::make_shared<Endpoint>();
+	iti::bench::run("Endpoints lookup of a missing method, after", 200000,
+	                [&] {
+		                iti::bench::keep(endpoints[Method::POST].get());
+	                });
+
+	auto mux = std::make_shared<Mux>();
+	mux->get("/x", no_op);
+	Request req;
+	NullResponse resp;
+	iti::bench::run("Mux, POST to a GET-only route (405)", 200000, [&] {
+		req.method = Method::POST;
+		Uri::parse("/x", req.url);
+		mux->handle_request(req, resp);
+		iti::bench::keep(resp.status);
+		req.reset();
+		resp.reset();
+	});
+}
+
+// static routes: the same API through a Mux and a StaticRouter
+static void static_routes() {
+	auto mux = std::make_shared<Mux>();
+	mux->get("/api/v1/products", no_op);
+	mux->post("/api/v1/products", no_op);
+	mux->get("/api/v1/products/{id}", no_op);
+	mux->del("/api/v1/products/{id}", no_op);
+	StaticApi api;
+
+	Request req;
+	NullResponse resp;
+	iti::bench::run("GET /api/v1/products, Mux", 200000,
+	                [&] { route(*mux, req, resp, "/api/v1/products"); });
+	iti::bench::run("GET /api/v1/products, StaticRouter", 200000,
+	                [&] { route(api, req, resp, "/api/v1/products"); });
+	iti::bench::run("GET /api/v1/products/42, Mux", 200000,
+	                [&] { route(*mux, req, resp, "/api/v1/products/42"); });
+	iti::bench::run("GET /api/v1/products/42, StaticRouter", 200000,
+	                [&] { route(api, req, resp, "/api/v1/products/42"); });
+}
+
+// request memory: what a request allocates, from its arena and from the
+// heap, through a mounted sub-router as in Interview.Web
+static void request_memory() {
+	auto products = std::make_shared<Mux>();
+	products->get("/{id}", no_op);
+	auto mux = std::make_shared<Mux>();
+	mux->mount("/api/v1/products", products);
+
+	Request req;
+	NullResponse resp;
+	size_t arenaBytes = 0, upstreamBytes = 0;
+	iti::bench::count_allocations(
+	    "GET /api/v1/products/42, heap allocations", 100000, [&] {
+		    req.method = Method::GET;
+		    Uri::parse("/api/v1/products/42", req.url);
+		    req.header.add_view("Host", "localhost:8080");
+		    req.header.add_view("Accept", "application/json");
+		    mux->handle_request(req, resp);
+		    arenaBytes    = req.arena.bytes_allocated();
+		    upstreamBytes = req.arena.bytes_upstream();
+		    req.reset();
+		    resp.reset();
+	    });
+	std::printf("%-52s %10zu bytes\n", "GET /api/v1/products/42, arena",
+	            arenaBytes);
+	std::printf("%-52s %10zu bytes\n",
+	            "GET /api/v1/products/42, arena overflow", upstreamBytes);
+}
+
+int main() {
+	unmatched_methods();
+	static_routes();
+	request_memory();
+	return 0;
+}
@@ -6,8 +6,8 @@
 #include "router.context.h"
 
 #include <algorithm>
-#include <numeric>
 
+#include "StrUtils.h"
 #include "router.h"
 
 using iti::http::Method;
@@ -15,6 +15,15 @@ using iti::http::router::RouteParams;
 
 // routing context
 // ----------------------------------------------------------------------------
+const iti::ContextKey<std::shared_ptr<iti::http::router::RoutingContext>>
+    iti::http::router::RoutingContext::routeCtxKey{
+        "iti::http::router::RoutingContext"};
+
+iti::http::router::RoutingContext::RoutingContext(
+    std::pmr::memory_resource *mr)
+    : routePath(mr), urlParams(mr), routePatterns(mr), routeParams(mr),
+      routePattern(mr) {}
+
 void iti::http::router::RoutingContext::reset() {
 	routes = nullptr;
 	routePath.clear();
@@ -27,6 +36,8 @@ void iti::http::router::RoutingContext::reset() {
 	routeParams.keys.clear();
 	routeParams.values.clear();
 	methodNotAllowed = false;
+	allowedMethods   = nullptr;
+	parentCtx        = nullptr;
 }
 
 std::string
@@ -36,10 +47,10 @@ iti::http::router::RoutingContext::get_url_param(const std::string &key) {
 	}
 
 	for (auto it = urlParams.keys.rbegin(); it != urlParams.keys.rend(); it++) {
-		if (*it == key) {
+		if (std::string_view(*it) == key) {
 			size_t idx = std::distance(urlParams.keys.begin(), it.base()) - 1;
 			if (idx < urlParams.values.size()) {
-				return urlParams.values[idx];
+				return std::string(urlParams.values[idx]);
 			}
 		}
 	}
@@ -53,13 +64,10 @@ std::string iti::http::router::RoutingContext::join_route_patterns() const {
 		return std::string();
 	}
 
-	std::string pattern = *routePatterns.begin();
-
-	pattern = std::accumulate(
-	    ++routePatterns.begin(),
-	    routePatterns.end(), // the range 2nd to after-last
-	    pattern,             // and start accumulating with the first item
-	    [](const std::string &a, const std::string &b) { return a + "" + b; });
+	std::string pattern;
+	for (const auto &p : routePatterns) {
+		pattern.append(p);
+	}
 
 	// replace all wildcards (occurrences of "/*/") to "/".
 	return strutils::replace_copy(pattern, "/*/", "/");
@@ -68,17 +76,17 @@ std::string iti::http::router::RoutingContext::join_route_patterns() const {
 std::string iti::http::router::RoutingContext::get_url_param_from_ctx(
     const iti::Context &ctx, const std::string &key) {
 
-	std::shared_ptr<RoutingContext> rctx = nullptr;
-	if (ctx.try_get_value(RoutingContext::routeCtxKey, rctx) &&
-	    rctx != nullptr) {
-		return rctx->get_url_param(key);
+	const auto *rctx = ctx.get(RoutingContext::routeCtxKey);
+	if (rctx != nullptr && *rctx != nullptr) {
+		return (*rctx)->get_url_param(key);
 	}
 
 	return std::string();
 }
 
-RouteParams iti::http::router::RoutingContext::get_route_params() {
-	return RouteParams(routeParams);
+const RouteParams &
+iti::http::router::RoutingContext::get_route_params() const {
+	return routeParams;
 }
 
 std::shared_ptr<iti::http::router::RoutingContext>
@@ -86,7 +94,7 @@ iti::http::router::RoutingContext::get_create_ctx_from_request(
     const Request &req) {
 	std::shared_ptr<RoutingContext> rctx = nullptr;
 	if (!req.context.try_get_value(RoutingContext::routeCtxKey, rctx)) {
-		rctx = std::make_shared<RoutingContext>();
+		rctx = create(req);
 		rctx->set_parent_context(req.context);
 		req.context.set_value(RoutingContext::routeCtxKey, rctx);
 	}
@@ -94,4 +102,11 @@ iti::http::router::RoutingContext::get_create_ctx_from_request(
 	return rctx;
 }
 
+std::shared_ptr<iti::http::router::RoutingContext>
+iti::http::router::RoutingContext::create(const Request &req) {
+	std::pmr::memory_resource *mr = req.arena.resource();
+	return std::allocate_shared<RoutingContext>(
+	    std::pmr::polymorphic_allocator<RoutingContext>(mr), mr);
+}
+
 #endif // ITI_LIB_HTTP_ROUTER_CONTEXT_CPP
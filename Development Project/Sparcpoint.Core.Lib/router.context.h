@@ -2,6 +2,7 @@
 #define ITI_LIB_HTTP_ROUTER_CONTEXT_H
 
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -21,26 +22,37 @@ class Node;
 // Context is the default routing context set on the root node of a
 // request context to track route patterns, URL parameters and
 // an optional routing path.
+//
+// A routing context and everything it holds are allocated from the arena of
+// the request it routes (see `Request::arena`).
 class RoutingContext {
 	friend class Node;
 
   public:
-	static constexpr const std::string_view routeCtxKey =
-	    "iti::http::router::RoutingContext";
+	// routeCtxKey is the request context key the routing context is stored
+	// under.
+	static const iti::ContextKey<std::shared_ptr<RoutingContext>> routeCtxKey;
 
 	static std::shared_ptr<RoutingContext>
 	get_create_ctx_from_request(const Request &req);
 
+	// create returns a new routing context allocated from the arena of
+	// `req`. It must not outlive the request.
+	static std::shared_ptr<RoutingContext> create(const Request &req);
+
 	static std::string get_url_param_from_ctx(const iti::Context &ctx,
 	                                          const std::string &key);
 
+	explicit RoutingContext(
+	    std::pmr::memory_resource *mr = std::pmr::get_default_resource());
+
 	RoutingContext &operator=(RoutingContext &&) = default;
 
 	std::shared_ptr<iti::http::router::IRoutes> routes = nullptr;
 
 	// Routing path/method override used during the route search.
 	// See "router.mux.h": `Mux.route_http()` method.
-	std::string routePath;
+	std::pmr::string routePath;
 
 	iti::http::Method routeMethod = iti::http::Method::unknown;
 
@@ -51,7 +63,7 @@ class RoutingContext {
 	// Routing pattern stack throughout the lifecycle of the request,
 	// across all connected routers. It is a record of all matching
 	// patterns across a stack of sub-routers.
-	std::vector<std::string> routePatterns;
+	std::pmr::vector<std::pmr::string> routePatterns;
 
 	// Reset a routing context to its initial state.
 	void reset();
@@ -62,14 +74,22 @@ class RoutingContext {
 
 	std::string join_route_patterns() const;
 
-	void set_parent_context(const iti::Context &ctx) { parentCtx = ctx; }
+	// set_parent_context records the context of the request being routed.
+	// It is not copied: `ctx` must outlive the routing context.
+	void set_parent_context(const iti::Context &ctx) { parentCtx = &ctx; }
+
+	const iti::Context *get_parent_context() const { return parentCtx; }
 
-	RouteParams get_route_params();
+	const RouteParams &get_route_params() const;
 
 	bool get_method_not_allowed_hint() const { return methodNotAllowed; }
 
+	// get_allowed_methods returns the "Allow" header value of the route that
+	// matched the path but not the method, or nullptr.
+	const std::string *get_allowed_methods() const { return allowedMethods; }
+
   protected:
-	iti::Context parentCtx;
+	const iti::Context *parentCtx = nullptr;
 
 	// Route parameters matched for the current sub-router. It is
 	// intentionally private so it cant be tampered.
@@ -79,10 +99,14 @@ class RoutingContext {
 	// or `RoutePath` of the current sub-router. This value will update
 	// during the lifecycle of a request passing through a stack of
 	// sub-routers.
-	std::string routePattern;
+	std::pmr::string routePattern;
 
 	// methodNotAllowed hint
 	bool methodNotAllowed = false;
+
+	// the "Allow" header value of the route that matched the path, owned by
+	// the route tree
+	const std::string *allowedMethods = nullptr;
 };
 
 } // namespace router
@@ -5,6 +5,8 @@
 
 #include "router.h"
 
+#include "StrUtils.h"
+
 using namespace iti;
 
 using iti::http::IHandler;
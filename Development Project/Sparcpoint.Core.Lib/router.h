@@ -51,14 +51,10 @@ class Middlewares {
 	std::vector<iti::http::router::middleware> collection;
 
 	middleware operator[](size_t idx) {
-		middleware m = nullptr;
-
-		try {
-			m = collection.at(idx);
-		} catch (const std::out_of_range &) {
+		if (idx >= collection.size()) {
+			return nullptr;
 		}
-
-		return m;
+		return collection[idx];
 	}
 
 	std::shared_ptr<iti::http::IHandler>
@@ -104,6 +100,15 @@ class IRouter : public iti::http::IHandler, public IRoutes {
 	route(const std::string &pattern,
 	      std::function<void(std::shared_ptr<IRouter> r)> fn) = 0;
 
+	// host creates a new Router with its own route tree, used instead of
+	// this one's for requests to `pattern`. The host is taken from the
+	// "Host" header, falling back to the request URL. `pattern` is either an
+	// exact host name ("inventory.internal") or a wildcard over its
+	// subdomains ("*.inventory.internal").
+	virtual std::shared_ptr<IRouter>
+	host(const std::string &pattern,
+	     std::function<void(std::shared_ptr<IRouter> r)> fn) = 0;
+
 	// mount attaches another IRouter along ./pattern/*
 	virtual void mount(const std::string &pattern,
 	                   std::shared_ptr<iti::http::router::IRouter> r) = 0;
@@ -0,0 +1,254 @@
+#ifndef ITI_LIB_HTTP_ROUTER_METRICS_CPP
+#define ITI_LIB_HTTP_ROUTER_METRICS_CPP
+
+#include "pch.h"
+
+#include "router.metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "epoch.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using iti::http::router::LatencyHistogram;
+using iti::http::router::RouteStats;
+using iti::http::router::RouteStatsSnapshot;
+
+// helpers
+// ----------------------------------------------------------------------------
+
+// most_significant_bit returns the index of the highest set bit of `v`,
+// which must not be 0.
+static inline size_t most_significant_bit(uint64_t v) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanReverse64(&idx, v);
+	return idx;
+#else
+	return 63 - __builtin_clzll(v);
+#endif
+}
+
+// stripe_index spreads threads round-robin over the counter stripes.
+static size_t stripe_index() {
+	static std::atomic<size_t> nextStripe{0};
+	thread_local size_t stripe =
+	    nextStripe.fetch_add(1, std::memory_order_relaxed) %
+	    RouteStats::stripeCount;
+	return stripe;
+}
+
+// join_patterns writes the full route pattern of `rctx` into `out`, the same
+// way `RoutingContext::join_route_patterns()` does, but reusing the capacity
+// of `out`.
+static void join_patterns(const iti::http::router::RoutingContext &rctx,
+                          std::string &out) {
+	out.clear();
+	for (const auto &p : rctx.routePatterns) {
+		out.append(p);
+	}
+
+	// replace all wildcards (occurrences of "/*/") to "/".
+	size_t pos = 0;
+	while ((pos = out.find("/*/", pos)) != std::string::npos) {
+		out.erase(pos, 2);
+	}
+}
+
+// latency histogram
+// ----------------------------------------------------------------------------
+size_t LatencyHistogram::bucket_index(uint64_t ns) {
+	if (ns < subBuckets) {
+		return static_cast<size_t>(ns);
+	}
+
+	size_t magnitude = most_significant_bit(ns);
+	if (magnitude > maxMagnitude) {
+		return bucketCount - 1;
+	}
+
+	size_t shift = magnitude - subBucketBits;
+	size_t sub   = static_cast<size_t>(ns >> shift) & (subBuckets - 1);
+	return (shift + 1) * subBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t idx) {
+	if (idx < subBuckets) {
+		return idx;
+	}
+
+	size_t shift = idx / subBuckets - 1;
+	uint64_t sub = idx % subBuckets;
+	return ((subBuckets + sub + 1) << shift) - 1;
+}
+
+// route stats
+// ----------------------------------------------------------------------------
+void RouteStats::record(int status, size_t bytesOut,
+                        std::chrono::nanoseconds latency, size_t arenaBytes) {
+	auto &s = stripes[stripe_index()];
+
+	uint64_t ns = latency.count() > 0 ? uint64_t(latency.count()) : 0;
+
+	s.hits.fetch_add(1, std::memory_order_relaxed);
+	if (status >= 100 && status < 600) {
+		s.statusClasses[status / 100 - 1].fetch_add(1,
+		                                            std::memory_order_relaxed);
+	}
+	s.bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+	s.arenaBytes.fetch_add(arenaBytes, std::memory_order_relaxed);
+	s.latencySumNs.fetch_add(ns, std::memory_order_relaxed);
+
+	uint64_t max = s.latencyMaxNs.load(std::memory_order_relaxed);
+	while (ns > max && !s.latencyMaxNs.compare_exchange_weak(
+	                       max, ns, std::memory_order_relaxed)) {
+	}
+
+	max = s.arenaBytesMax.load(std::memory_order_relaxed);
+	while (arenaBytes > max &&
+	       !s.arenaBytesMax.compare_exchange_weak(max, arenaBytes,
+	                                              std::memory_order_relaxed)) {
+	}
+
+	s.latency.record(ns);
+}
+
+RouteStatsSnapshot RouteStats::snapshot() const {
+	RouteStatsSnapshot snap;
+	uint64_t latencySum = 0;
+
+	std::array<uint64_t, LatencyHistogram::bucketCount> buckets{};
+
+	for (const auto &s : stripes) {
+		snap.hits += s.hits.load(std::memory_order_relaxed);
+		for (size_t i = 0; i < snap.statusClasses.size(); i++) {
+			snap.statusClasses[i] +=
+			    s.statusClasses[i].load(std::memory_order_relaxed);
+		}
+		snap.bytesOut += s.bytesOut.load(std::memory_order_relaxed);
+		snap.arenaBytes += s.arenaBytes.load(std::memory_order_relaxed);
+		snap.arenaBytesMax =
+		    std::max(snap.arenaBytesMax,
+		             s.arenaBytesMax.load(std::memory_order_relaxed));
+		latencySum += s.latencySumNs.load(std::memory_order_relaxed);
+		snap.latencyMaxNs = std::max(
+		    snap.latencyMaxNs, s.latencyMaxNs.load(std::memory_order_relaxed));
+
+		for (size_t i = 0; i < buckets.size(); i++) {
+			buckets[i] += s.latency.count_at(i);
+		}
+	}
+
+	uint64_t total = 0;
+	for (auto c : buckets) {
+		total += c;
+	}
+
+	if (total == 0) {
+		return snap;
+	}
+
+	snap.latencyMeanNs = latencySum / total;
+
+	// walk the merged histogram once, filling the percentiles in order
+	const std::array<std::pair<double, uint64_t *>, 4> percentiles = {{
+	    {0.50, &snap.latencyP50Ns},
+	    {0.90, &snap.latencyP90Ns},
+	    {0.99, &snap.latencyP99Ns},
+	    {0.999, &snap.latencyP999Ns},
+	}};
+
+	size_t next   = 0;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < buckets.size() && next < percentiles.size(); i++) {
+		seen += buckets[i];
+		while (next < percentiles.size() &&
+		       seen >= std::max<uint64_t>(
+		                   1, uint64_t(std::ceil(percentiles[next].first *
+		                                         double(total))))) {
+			*percentiles[next].second = std::min(
+			    LatencyHistogram::bucket_upper_bound(i), snap.latencyMaxNs);
+			next++;
+		}
+	}
+
+	return snap;
+}
+
+// route metrics
+// ----------------------------------------------------------------------------
+iti::http::router::RouteMetrics::~RouteMetrics() {
+	std::scoped_lock<std::mutex> l(mtx);
+	iti::epoch::retire(const_cast<Index *>(index.exchange(nullptr)));
+	iti::epoch::collect();
+}
+
+void iti::http::router::RouteMetrics::record(const RoutingContext &rctx,
+                                             int status, size_t bytesOut,
+                                             std::chrono::nanoseconds latency,
+                                             size_t arenaBytes) {
+	thread_local std::string pattern;
+	join_patterns(rctx, pattern);
+
+	stats(pattern).record(status, bytesOut, latency, arenaBytes);
+}
+
+RouteStats &
+iti::http::router::RouteMetrics::stats(const std::string &pattern) {
+	{
+		iti::epoch::Guard g;
+		const Index *idx = index.load();
+		if (idx != nullptr) {
+			auto it = idx->find(pattern);
+			if (it != idx->end()) {
+				return *it->second;
+			}
+		}
+	}
+
+	// First time we see this pattern: publish a new index with it.
+	std::scoped_lock<std::mutex> l(mtx);
+
+	const Index *prev = index.load();
+	if (prev != nullptr) {
+		auto it = prev->find(pattern);
+		if (it != prev->end()) {
+			return *it->second;
+		}
+	}
+
+	routes.emplace_back(pattern, std::make_unique<RouteStats>());
+	RouteStats *stats = routes.back().second.get();
+
+	Index *next = prev != nullptr ? new Index(*prev) : new Index();
+	next->emplace(pattern, stats);
+
+	index.store(next);
+	iti::epoch::retire(const_cast<Index *>(prev));
+
+	return *stats;
+}
+
+std::vector<std::pair<std::string, RouteStatsSnapshot>>
+iti::http::router::RouteMetrics::snapshot() const {
+	std::vector<std::pair<std::string, RouteStatsSnapshot>> result;
+
+	{
+		std::scoped_lock<std::mutex> l(mtx);
+		result.reserve(routes.size());
+		for (const auto &[pattern, stats] : routes) {
+			result.emplace_back(pattern, stats->snapshot());
+		}
+	}
+
+	std::sort(result.begin(), result.end(),
+	          [](const auto &a, const auto &b) { return a.first < b.first; });
+
+	return result;
+}
+
+#endif // ITI_LIB_HTTP_ROUTER_METRICS_CPP
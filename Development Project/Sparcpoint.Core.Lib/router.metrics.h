@@ -0,0 +1,146 @@
+#ifndef ITI_LIB_HTTP_ROUTER_METRICS_H
+#define ITI_LIB_HTTP_ROUTER_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "http.h"
+#include "router.context.h"
+
+namespace iti {
+namespace http {
+namespace router {
+
+// LatencyHistogram is an HDR-style (log-linear) histogram of durations in
+// nanoseconds. Every power of two is split into `subBuckets` linear
+// sub-buckets, so any recorded value is reported with at most 12.5% error
+// while the whole range (1ns up to ~18 minutes) fits in a few hundred
+// counters. Recording is a single relaxed atomic increment.
+class LatencyHistogram {
+  public:
+	static constexpr size_t subBucketBits = 3;
+	static constexpr size_t subBuckets    = size_t(1) << subBucketBits;
+	static constexpr size_t maxMagnitude  = 40; // 2^40ns ~= 18 minutes
+	static constexpr size_t bucketCount =
+	    (maxMagnitude - subBucketBits + 2) * subBuckets;
+
+	// bucket_index returns the bucket `ns` is counted in.
+	static size_t bucket_index(uint64_t ns);
+
+	// bucket_upper_bound returns the highest value counted in bucket `idx`.
+	static uint64_t bucket_upper_bound(size_t idx);
+
+	void record(uint64_t ns) {
+		counts[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	uint64_t count_at(size_t idx) const {
+		return counts[idx].load(std::memory_order_relaxed);
+	}
+
+  private:
+	std::array<std::atomic<uint64_t>, bucketCount> counts{};
+};
+
+// RouteStatsSnapshot is a point-in-time copy of the statistics of a route,
+// merged across all threads.
+struct RouteStatsSnapshot {
+	uint64_t hits = 0;
+
+	// responses per status class: 1xx, 2xx, 3xx, 4xx, 5xx
+	std::array<uint64_t, 5> statusClasses{};
+
+	uint64_t bytesOut = 0;
+
+	// bytes allocated from the request arena (see "arena.h")
+	uint64_t arenaBytes    = 0;
+	uint64_t arenaBytesMax = 0;
+
+	// latency in nanoseconds
+	uint64_t latencyMeanNs = 0;
+	uint64_t latencyMaxNs  = 0;
+	uint64_t latencyP50Ns  = 0;
+	uint64_t latencyP90Ns  = 0;
+	uint64_t latencyP99Ns  = 0;
+	uint64_t latencyP999Ns = 0;
+};
+
+// RouteStats holds the runtime statistics of one route. Counters are striped
+// so that concurrent threads increment their own cache lines; a snapshot
+// merges the stripes.
+class RouteStats {
+  public:
+	static constexpr size_t stripeCount = 8;
+
+	void record(int status, size_t bytesOut, std::chrono::nanoseconds latency,
+	            size_t arenaBytes = 0);
+
+	RouteStatsSnapshot snapshot() const;
+
+  private:
+	struct alignas(64) Stripe {
+		std::atomic<uint64_t> hits{0};
+		std::array<std::atomic<uint64_t>, 5> statusClasses{};
+		std::atomic<uint64_t> bytesOut{0};
+		std::atomic<uint64_t> arenaBytes{0};
+		std::atomic<uint64_t> arenaBytesMax{0};
+		std::atomic<uint64_t> latencySumNs{0};
+		std::atomic<uint64_t> latencyMaxNs{0};
+		LatencyHistogram latency;
+	};
+
+	std::array<Stripe, stripeCount> stripes;
+};
+
+// RouteMetrics is the registry of per-route statistics, keyed by the
+// matched route pattern (see `RoutingContext::routePatterns`).
+//
+// Lookups on the request path are lock-free: the pattern index is an
+// immutable map that is republished (see "epoch.h") whenever a pattern is
+// seen for the first time.
+class RouteMetrics {
+  public:
+	RouteMetrics() = default;
+	~RouteMetrics();
+
+	RouteMetrics(const RouteMetrics &) = delete;
+	RouteMetrics &operator=(const RouteMetrics &) = delete;
+
+	// record adds a finished request to the statistics of the route that
+	// matched it. Requests that didn't match any route are recorded under
+	// an empty pattern.
+	//
+	// `arenaBytes` is what the request allocated from its arena, see
+	// `RequestArena::bytes_allocated()`.
+	void record(const RoutingContext &rctx, int status, size_t bytesOut,
+	            std::chrono::nanoseconds latency, size_t arenaBytes = 0);
+
+	// stats returns the statistics of `pattern`, creating them if needed.
+	RouteStats &stats(const std::string &pattern);
+
+	// snapshot returns a copy of the statistics of every route seen so far,
+	// ordered by pattern.
+	std::vector<std::pair<std::string, RouteStatsSnapshot>> snapshot() const;
+
+  private:
+	using Index = std::unordered_map<std::string, RouteStats *>;
+
+	std::atomic<const Index *> index{nullptr};
+
+	// guards `routes` and the publication of new indexes
+	mutable std::mutex mtx;
+	std::vector<std::pair<std::string, std::unique_ptr<RouteStats>>> routes;
+};
+
+} // namespace router
+} // namespace http
+} // namespace iti
+
+#endif // ITI_LIB_HTTP_ROUTER_METRICS_H
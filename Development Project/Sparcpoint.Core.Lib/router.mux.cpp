@@ -13,6 +13,7 @@
 #include "fmt/format.h"
 
 using iti::http::BasicHandler;
+using iti::http::HeaderName;
 using iti::http::IHandler;
 using iti::http::Request;
 using iti::http::Response;
@@ -36,7 +37,33 @@ void method_not_allowed_default_handler(const Request &req, Response &resp) {
 
 void not_found_default_handler(const Request &req, Response &resp) {
 	resp.status = StatusCode::Status404NotFound;
-	resp.write(fmt::format("Resource ({}) not found", req.url.path));
+	resp.write(fmt::format("Resource ({}) not found", req.url.path()));
+}
+
+// normalize_host writes the lowercase host name of `rawHost`, without its
+// port and trailing dot, into `out`.
+static void normalize_host(std::string_view rawHost, std::string &out) {
+	std::string_view name = rawHost;
+
+	if (!name.empty() && name[0] == '[') {
+		// IPv6 literal: [::1]:8080
+		size_t end = name.find(']');
+		name       = name.substr(0, end == std::string_view::npos ? end : end + 1);
+	} else if (size_t colon = name.rfind(':');
+	           colon != std::string_view::npos) {
+		name = name.substr(0, colon);
+	}
+
+	if (!name.empty() && name.back() == '.') {
+		name.remove_suffix(1);
+	}
+
+	out.assign(name.data(), name.size());
+	for (auto &c : out) {
+		if ('A' <= c && c <= 'Z') {
+			c = c - 'A' + 'a';
+		}
+	}
 }
 
 // mux
@@ -51,15 +78,12 @@ void iti::http::router::Mux::handle_request(const Request &req,
 	}
 
 	// Check if a routing context already exists from a parent router.
-	std::shared_ptr<RoutingContext> rctx = nullptr;
-	bool gotCtx = req.context.try_get_value(RoutingContext::routeCtxKey, rctx);
-
-	if (gotCtx && handler != nullptr) {
+	if (req.context.get(RoutingContext::routeCtxKey) != nullptr) {
 		handler->handle_request(req, resp);
 		return;
 	}
 
-	rctx = std::make_shared<RoutingContext>();
+	auto rctx = RoutingContext::create(req);
 
 	rctx->routes = shared_from_this();
 	rctx->set_parent_context(req.context);
@@ -174,6 +198,94 @@ std::shared_ptr<IRouter> iti::http::router::Mux::route(
 	return subr;
 }
 
+// host creates a new Mux with a fresh middleware stack and route tree, and
+// routes every request for the host `pattern` to it. Host routers are
+// selected before any path matching, after this Mux's middleware stack ran:
+//
+//	r->host("inventory.internal", [](std::shared_ptr<IRouter> r) {
+//		r->get("/", ...);
+//	});
+//	r->host("*.cdn.internal", ...); // a.cdn.internal, a.b.cdn.internal
+//
+// Exact hosts win over wildcards, and longer wildcards over shorter ones.
+// Requests to any other host use this Mux's own routes.
+std::shared_ptr<IRouter> iti::http::router::Mux::host(
+    const std::string &pattern,
+    std::function<void(std::shared_ptr<IRouter> r)> fn) {
+	if (fn == nullptr) {
+		throw std::logic_error(fmt::format(
+		    "mux: attempting to host() a nullptr subrouter on '{}'", pattern));
+	}
+
+	const bool wildcard = pattern.rfind("*.", 0) == 0;
+	auto &hostMap       = wildcard ? wildcardHosts : hosts;
+
+	std::string name;
+	normalize_host(wildcard ? pattern.substr(1) : pattern, name);
+	if (name.empty() || name == ".") {
+		throw std::logic_error(
+		    fmt::format("mux: invalid host() pattern '{}'", pattern));
+	}
+
+	if (hostMap.find(name) != hostMap.end()) {
+		throw std::logic_error(fmt::format(
+		    "mux: attempting to host() '{}' more than once", pattern));
+	}
+
+	// Host routers are dispatched from the route handler, so build it now
+	// like handle() does.
+	if (!isInline && handler == nullptr) {
+		update_route_handler();
+	}
+
+	auto subr = std::make_shared<Mux>();
+	if (notFoundHandler != nullptr) {
+		subr->set_not_found(notFoundHandler);
+	}
+	if (methodNotAllowedHandler != nullptr) {
+		subr->set_method_not_allowed(methodNotAllowedHandler);
+	}
+
+	fn(subr);
+	hostMap.emplace(std::move(name), subr);
+	return subr;
+}
+
+iti::http::router::Mux *
+iti::http::router::Mux::match_host(const Request &req) const {
+	if (hosts.empty() && wildcardHosts.empty()) {
+		return nullptr;
+	}
+
+	std::string_view rawHost = req.url.host();
+	if (auto f = req.header.find(HeaderName::Host); f != nullptr) {
+		rawHost = f->value();
+	}
+
+	thread_local std::string name;
+	normalize_host(rawHost, name);
+
+	if (auto it = hosts.find(name); it != hosts.end()) {
+		return it->second.get();
+	}
+
+	if (wildcardHosts.empty()) {
+		return nullptr;
+	}
+
+	// try the suffixes of the name, longest first
+	thread_local std::string suffix;
+	for (size_t pos = name.find('.'); pos != std::string::npos;
+	     pos        = name.find('.', pos + 1)) {
+		suffix.assign(name, pos, std::string::npos);
+		if (auto it = wildcardHosts.find(suffix); it != wildcardHosts.end()) {
+			return it->second.get();
+		}
+	}
+
+	return nullptr;
+}
+
 // mount attaches another IHandler or IRouter as a subrouter along a
 // routing path. It's very useful to split up a large API as many independent
 // routers and compose them as a single service using mount.
@@ -217,7 +329,7 @@ void iti::http::router::Mux::mount(
 		req.context.try_get_value(RoutingContext::routeCtxKey, rctx);
 
 		// shift the url path past the previous subrouter
-		rctx->routePath = mx->next_route_path(rctx);
+		mx->next_route_path(rctx);
 
 		// reset the wildcard URLParam which connects the subrouter
 		long long n = (long long)rctx->urlParams.keys.size() - 1;
@@ -270,8 +382,9 @@ bool iti::http::router::Mux::match(std::shared_ptr<RoutingContext> rctx,
 	auto h      = std::get<2>(result);
 
 	if (node != nullptr && node->subroutes != nullptr) {
-		rctx->routePath = next_route_path(rctx);
-		return node->subroutes->match(rctx, method, rctx->routePath);
+		next_route_path(rctx);
+		return node->subroutes->match(rctx, method,
+		                              std::string(rctx->routePath));
 	}
 
 	return h != nullptr;
@@ -419,7 +532,7 @@ void iti::http::router::Mux::set_method_not_allowed(
 	}
 
 	// Update the methodNotAllowedHandler from this point forward
-	m->notFoundHandler = h;
+	m->methodNotAllowedHandler = h;
 	m->update_subroutes([&](Mux &subMux) {
 		if (subMux.methodNotAllowedHandler == nullptr) {
 			subMux.set_method_not_allowed(h);
@@ -461,14 +574,20 @@ std::shared_ptr<IHandler> iti::http::router::Mux::route_http() {
 		std::shared_ptr<RoutingContext> rctx = nullptr;
 		if (!req.context.try_get_value(RoutingContext::routeCtxKey, rctx) ||
 		    rctx == nullptr) {
-			throw std::exception(
+			throw std::logic_error(
 			    "mux: do not have RoutingContext when we should");
 		}
 
+		// Dispatch to the host's router before any path matching
+		if (Mux *hm = mx->match_host(req); hm != nullptr) {
+			hm->handle_request(req, resp);
+			return;
+		}
+
 		// The request routing path
-		auto routePath = rctx->routePath;
+		std::string_view routePath = rctx->routePath;
 		if (routePath.empty()) {
-			routePath = req.url.path;
+			routePath = req.url.path();
 			if (routePath.empty()) {
 				routePath = "/";
 			}
@@ -478,6 +597,11 @@ std::shared_ptr<IHandler> iti::http::router::Mux::route_http() {
 			rctx->routeMethod = req.method;
 		}
 
+		// HEAD responses never carry a body
+		if (rctx->routeMethod == Method::HEAD) {
+			resp.omitBody = true;
+		}
+
 		if (!rctx->routeMethod.is_valid()) {
 			mx->method_not_allowed_handler(req, resp);
 			return;
@@ -492,7 +616,20 @@ std::shared_ptr<IHandler> iti::http::router::Mux::route_http() {
 		}
 
 		if (rctx->get_method_not_allowed_hint()) {
+			const std::string *allow = rctx->get_allowed_methods();
+			if (allow != nullptr) {
+				resp.header.set("Allow", *allow);
+			}
+
+			// answer OPTIONS inline when the route has no handler for it
+			if (rctx->routeMethod == Method::OPTIONS && allow != nullptr) {
+				resp.status = StatusCode::Status204NoContent;
+				resp.write();
+				return;
+			}
+
 			mx->method_not_allowed_handler(req, resp);
+			return;
 		}
 
 		mx->not_found_handler(req, resp);
@@ -547,18 +684,19 @@ void iti::http::router::Mux::update_subroutes(
 	}
 }
 
-std::string
-iti::http::router::Mux::next_route_path(std::shared_ptr<RoutingContext> rctx) {
-	std::string routePath{"/"};
+void iti::http::router::Mux::next_route_path(
+    std::shared_ptr<RoutingContext> rctx) {
+	// reuse the capacity of routePath
+	auto &routePath = rctx->routePath;
+	routePath.assign(1, '/');
 
 	// index of last param in list
-	auto routeParams = rctx->get_route_params();
-	long long nx     = (long long)routeParams.keys.size() - 1;
+	const auto &routeParams = rctx->get_route_params();
+	long long nx            = (long long)routeParams.keys.size() - 1;
 	if (nx >= 0 && routeParams.keys[nx] == "*" &&
 	    routeParams.values.size() > nx) {
-		routePath = "/" + routeParams.values[nx];
+		routePath += routeParams.values[nx];
 	}
-	return routePath;
 }
 
 #endif // ITI_LIB_HTTP_ROUTER_MUX_CPP
@@ -5,6 +5,8 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "http.h"
@@ -42,6 +44,10 @@ class Mux : public IRouter, public std::enable_shared_from_this<Mux> {
 	route(const std::string &pattern,
 	      std::function<void(std::shared_ptr<IRouter> r)> fn);
 
+	std::shared_ptr<IRouter>
+	host(const std::string &pattern,
+	     std::function<void(std::shared_ptr<IRouter> r)> fn);
+
 	void mount(const std::string &pattern, std::shared_ptr<IRouter> r);
 
 	void handle(const std::string &pattern,
@@ -93,7 +99,11 @@ class Mux : public IRouter, public std::enable_shared_from_this<Mux> {
 
 	void update_subroutes(std::function<void(Mux &subMux)> fn);
 
-	std::string next_route_path(std::shared_ptr<RoutingContext> rctx);
+	// next_route_path shifts `rctx->routePath` past this router's pattern.
+	void next_route_path(std::shared_ptr<RoutingContext> rctx);
+
+	// match_host returns the host router serving `req`, or nullptr.
+	Mux *match_host(const Request &req) const;
 
 	// The computed mux handler made of the chained middleware stack and
 	// the tree router
@@ -115,6 +125,11 @@ class Mux : public IRouter, public std::enable_shared_from_this<Mux> {
 	// The middleware stack
 	std::vector<middleware> middlewares;
 
+	// Host routers, keyed by exact host name and by wildcard suffix
+	// (".inventory.internal" for "*.inventory.internal").
+	std::unordered_map<std::string, std::shared_ptr<Mux>> hosts;
+	std::unordered_map<std::string, std::shared_ptr<Mux>> wildcardHosts;
+
 	bool isInline = false;
 };
 
@@ -0,0 +1,209 @@
+#ifndef ITI_LIB_HTTP_ROUTER_PIPELINE_H
+#define ITI_LIB_HTTP_ROUTER_PIPELINE_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "http.h"
+#include "router.h"
+
+namespace iti {
+namespace http {
+namespace router {
+
+// Compile-time middleware pipelines.
+//
+// `Middlewares::make_handler()` wraps each middleware around the next one as
+// a `shared_ptr<IHandler>` holding a `BasicHandler` holding a
+// `std::function`, so every hop costs a virtual call, a `std::function`
+// dispatch and a refcounted capture.
+//
+// A pipeline composes middleware *types* instead, so the compiler sees the
+// whole chain and can inline it into a single function:
+//
+//	auto h = pipeline<trim_trailing_slash, logging, extract_id>(endpoint);
+//	h(req, resp);
+//
+// A pipeline middleware is a default constructible type with a
+//
+//	template <class Next>
+//	void handle_request(const Request &req, Response &resp, Next &next);
+//
+// member that calls `next(req, resp)` to continue down the chain (or doesn't,
+// to respond early).
+
+template <class Endpoint, class... Mws> class Pipeline;
+
+template <class Endpoint> class Pipeline<Endpoint> {
+  public:
+	explicit Pipeline(Endpoint ep) : endpoint(std::move(ep)) {}
+
+	void operator()(const Request &req, Response &resp) {
+		endpoint(req, resp);
+	}
+
+  private:
+	Endpoint endpoint;
+};
+
+template <class Endpoint, class Mw, class... Rest>
+class Pipeline<Endpoint, Mw, Rest...> {
+  public:
+	explicit Pipeline(Endpoint ep) : next(std::move(ep)) {}
+
+	void operator()(const Request &req, Response &resp) {
+		mw.handle_request(req, resp, next);
+	}
+
+  private:
+	Mw mw;
+	Pipeline<Endpoint, Rest...> next;
+};
+
+// pipeline composes the middlewares `Mws` (outermost first) around
+// `endpoint`, any callable taking `(const Request &, Response &)`.
+template <class... Mws, class Endpoint>
+Pipeline<std::decay_t<Endpoint>, Mws...> pipeline(Endpoint &&endpoint) {
+	return Pipeline<std::decay_t<Endpoint>, Mws...>(
+	    std::forward<Endpoint>(endpoint));
+}
+
+// InplaceHandler is a move-only, type-erased `(const Request &, Response &)`
+// callable, for when type erasure is unavoidable. Unlike `std::function` it
+// never allocates: the callable is stored inline and must fit in
+// `Capacity` bytes, which is checked at compile time.
+template <size_t Capacity = 64> class InplaceHandler {
+  public:
+	InplaceHandler() = default;
+	InplaceHandler(std::nullptr_t) {}
+
+	template <class F, class = std::enable_if_t<
+	                       !std::is_same_v<std::decay_t<F>, InplaceHandler>>>
+	InplaceHandler(F &&f) {
+		using Fn = std::decay_t<F>;
+		static_assert(sizeof(Fn) <= Capacity,
+		              "InplaceHandler: callable is too large, raise Capacity");
+		static_assert(alignof(Fn) <= alignof(std::max_align_t),
+		              "InplaceHandler: callable is over-aligned");
+		static_assert(std::is_nothrow_move_constructible_v<Fn>,
+		              "InplaceHandler: callable must be nothrow movable");
+
+		new (&storage) Fn(std::forward<F>(f));
+		ops = &ops_for<Fn>;
+	}
+
+	InplaceHandler(InplaceHandler &&other) noexcept { move_from(other); }
+
+	InplaceHandler &operator=(InplaceHandler &&other) noexcept {
+		if (this != &other) {
+			reset();
+			move_from(other);
+		}
+		return *this;
+	}
+
+	InplaceHandler(const InplaceHandler &) = delete;
+	InplaceHandler &operator=(const InplaceHandler &) = delete;
+
+	~InplaceHandler() { reset(); }
+
+	void operator()(const Request &req, Response &resp) {
+		if (ops != nullptr) {
+			ops->invoke(&storage, req, resp);
+		}
+	}
+
+	explicit operator bool() const { return ops != nullptr; }
+
+	void reset() {
+		if (ops != nullptr) {
+			ops->destroy(&storage);
+			ops = nullptr;
+		}
+	}
+
+  private:
+	struct Ops {
+		void (*invoke)(void *, const Request &, Response &);
+		void (*move)(void *dst, void *src);
+		void (*destroy)(void *);
+	};
+
+	template <class Fn>
+	static constexpr Ops ops_for = {
+	    [](void *f, const Request &req, Response &resp) {
+		    (*static_cast<Fn *>(f))(req, resp);
+	    },
+	    [](void *dst, void *src) {
+		    new (dst) Fn(std::move(*static_cast<Fn *>(src)));
+		    static_cast<Fn *>(src)->~Fn();
+	    },
+	    [](void *f) { static_cast<Fn *>(f)->~Fn(); },
+	};
+
+	void move_from(InplaceHandler &other) {
+		if (other.ops != nullptr) {
+			other.ops->move(&storage, &other.storage);
+			ops       = other.ops;
+			other.ops = nullptr;
+		}
+	}
+
+	std::aligned_storage_t<Capacity, alignof(std::max_align_t)> storage;
+	const Ops *ops = nullptr;
+};
+
+// StaticHandler adapts any `(const Request &, Response &)` callable, such as a
+// `Pipeline`, to `IHandler` at the cost of a single virtual call.
+template <class F> class StaticHandler : public iti::http::IHandler {
+  public:
+	explicit StaticHandler(F f) : fn(std::move(f)) {}
+
+	void handle_request(const Request &req, Response &resp) override {
+		fn(req, resp);
+	}
+
+  private:
+	F fn;
+};
+
+// make_pipeline_handler builds an `IHandler` from a compile-time pipeline,
+// ready to be registered with `IRouter::method()` or `IRouter::handle()`.
+template <class... Mws, class Endpoint>
+std::shared_ptr<iti::http::IHandler> make_pipeline_handler(Endpoint &&ep) {
+	using P = decltype(pipeline<Mws...>(std::forward<Endpoint>(ep)));
+	return iti::http::IHandler::make_handler(
+	    new StaticHandler<P>(pipeline<Mws...>(std::forward<Endpoint>(ep))));
+}
+
+// pipeline_middleware fuses a compile-time pipeline into a single dynamic
+// `middleware`, for `IRouter::use()` and `IRouter::with()`. The whole stack
+// then costs one hop instead of one per middleware.
+template <class... Mws> middleware pipeline_middleware() {
+	return [](std::shared_ptr<iti::http::IHandler> next) {
+		InplaceHandler<> nxt = [n = std::move(next)](const Request &req,
+		                                             Response &resp) {
+			if (n != nullptr) {
+				n->handle_request(req, resp);
+			}
+		};
+		return make_pipeline_handler<Mws...>(std::move(nxt));
+	};
+}
+
+// adapt_middleware turns a pipeline middleware type into a dynamic
+// `middleware`, so the same implementation serves both APIs.
+template <class Mw>
+std::shared_ptr<iti::http::IHandler>
+adapt_middleware(std::shared_ptr<iti::http::IHandler> next) {
+	return pipeline_middleware<Mw>()(std::move(next));
+}
+
+} // namespace router
+} // namespace http
+} // namespace iti
+
+#endif // ITI_LIB_HTTP_ROUTER_PIPELINE_H
@@ -0,0 +1,63 @@
+#ifndef ITI_LIB_HTTP_ROUTER_SNAPSHOT_CPP
+#define ITI_LIB_HTTP_ROUTER_SNAPSHOT_CPP
+
+#include "pch.h"
+
+#include "router.snapshot.h"
+
+#include "epoch.h"
+#include "fmt/format.h"
+
+using iti::http::Request;
+using iti::http::Response;
+using iti::http::StatusCode;
+using iti::http::router::IRouter;
+
+// mux snapshot
+// ----------------------------------------------------------------------------
+iti::http::router::MuxSnapshot::~MuxSnapshot() {
+	publish(nullptr);
+	iti::epoch::collect();
+}
+
+void iti::http::router::MuxSnapshot::handle_request(const Request &req,
+                                                    Response &resp) {
+	// The guard pins the snapshot (and the router it holds) for the whole
+	// request, so a concurrent publish() can't free it underneath us.
+	iti::epoch::Guard g;
+
+	Snapshot *s = snapshot.load();
+	if (s == nullptr || s->router == nullptr) {
+		resp.status = StatusCode::Status404NotFound;
+		resp.write(fmt::format("Resource ({}) not found", req.url.path()));
+		return;
+	}
+
+	s->router->handle_request(req, resp);
+}
+
+void iti::http::router::MuxSnapshot::publish(std::shared_ptr<IRouter> r) {
+	Snapshot *next = nullptr;
+	if (r != nullptr) {
+		next = new Snapshot{std::move(r)};
+	}
+
+	std::scoped_lock<std::mutex> l(publishMtx);
+
+	Snapshot *prev = snapshot.exchange(next);
+	generation.fetch_add(1);
+
+	iti::epoch::retire(prev);
+}
+
+std::shared_ptr<IRouter> iti::http::router::MuxSnapshot::current() const {
+	iti::epoch::Guard g;
+
+	Snapshot *s = snapshot.load();
+	if (s == nullptr) {
+		return nullptr;
+	}
+	return s->router;
+}
+
+#endif // ITI_LIB_HTTP_ROUTER_SNAPSHOT_CPP
@@ -0,0 +1,67 @@
+#ifndef ITI_LIB_HTTP_ROUTER_SNAPSHOT_H
+#define ITI_LIB_HTTP_ROUTER_SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "http.h"
+#include "router.h"
+
+namespace iti {
+namespace http {
+namespace router {
+
+// MuxSnapshot serves requests from the most recently published router and
+// lets a new router replace it while the server is running (RCU-style).
+//
+// A replacement router is built off to the side, with its own routes and
+// middleware stack, and then published with a single atomic pointer swap:
+//
+//	auto next = std::make_shared<Mux>();
+//	next->use(middlewares::logging);
+//	next->get("/", ...);
+//	snapshot.publish(next);
+//
+// The lookup path takes no lock. In-flight requests keep using the router
+// they started on; the retired router is reclaimed once the last of them
+// finishes (see "epoch.h").
+class MuxSnapshot : public iti::http::IHandler {
+  public:
+	MuxSnapshot() = default;
+	explicit MuxSnapshot(std::shared_ptr<IRouter> r) { publish(std::move(r)); }
+	~MuxSnapshot();
+
+	MuxSnapshot(const MuxSnapshot &) = delete;
+	MuxSnapshot &operator=(const MuxSnapshot &) = delete;
+
+	void handle_request(const Request &req, Response &resp) override;
+
+	// publish atomically replaces the router serving new requests.
+	// Passing a nullptr unpublishes the current router.
+	void publish(std::shared_ptr<IRouter> r);
+
+	// current returns the router serving new requests, e.g. to
+	// `walk_routes()` it. It may be replaced right after the call returns.
+	std::shared_ptr<IRouter> current() const;
+
+	// version returns the number of publications so far.
+	uint64_t version() const { return generation.load(); }
+
+  private:
+	struct Snapshot {
+		std::shared_ptr<IRouter> router;
+	};
+
+	std::atomic<Snapshot *> snapshot{nullptr};
+	std::atomic<uint64_t> generation{0};
+
+	// serializes writers only
+	std::mutex publishMtx;
+};
+
+} // namespace router
+} // namespace http
+} // namespace iti
+
+#endif // ITI_LIB_HTTP_ROUTER_SNAPSHOT_H
@@ -0,0 +1,123 @@
+#ifndef ITI_LIB_HTTP_ROUTER_STATIC_CPP
+#define ITI_LIB_HTTP_ROUTER_STATIC_CPP
+
+#include "pch.h"
+
+#include "router.static.h"
+
+#include <charconv>
+
+using iti::http::Request;
+using iti::http::Response;
+using iti::http::router::RouteParams;
+using iti::http::router::static_routes::Segment;
+using iti::http::router::static_routes::SegmentKind;
+
+// helpers
+// ----------------------------------------------------------------------------
+// default handlers are in router.mux.cpp
+extern void method_not_allowed_default_handler(const Request &req,
+                                               Response &resp);
+extern void not_found_default_handler(const Request &req, Response &resp);
+
+// is_u64 reports whether `s` is a decimal unsigned 64-bit integer.
+static bool is_u64(std::string_view s) {
+	if (s.empty()) {
+		return false;
+	}
+
+	uint64_t v{};
+	auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+	return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+// static router
+// ----------------------------------------------------------------------------
+void iti::http::router::StaticRouterBase::not_found(const Request &req,
+                                                    Response &resp) {
+	if (notFoundHandler != nullptr) {
+		notFoundHandler->handle_request(req, resp);
+		return;
+	}
+	not_found_default_handler(req, resp);
+}
+
+void iti::http::router::StaticRouterBase::method_not_allowed(
+    const Request &req, Response &resp) {
+	if (methodNotAllowedHandler != nullptr) {
+		methodNotAllowedHandler->handle_request(req, resp);
+		return;
+	}
+	method_not_allowed_default_handler(req, resp);
+}
+
+bool iti::http::router::StaticRouterBase::match_segments(
+    const Segment *segs, size_t count, std::string_view path,
+    RouteParams &params) {
+	if (path.empty() || path[0] != '/') {
+		return false;
+	}
+
+	const size_t prevLen = params.keys.size();
+	auto fail            = [&params, prevLen]() {
+		params.keys.resize(prevLen);
+		params.values.resize(prevLen);
+		return false;
+	};
+
+	size_t pos = 1;
+	for (size_t i = 0; i < count; i++) {
+		const Segment &seg = segs[i];
+
+		// the rest of the path, maybe empty ("/assets/" for "/assets/*");
+		// as with `Mux`, the bare prefix "/assets" doesn't match
+		if (seg.kind == SegmentKind::CatchAll) {
+			if (pos > path.size()) {
+				return fail();
+			}
+			params.add("*", std::string(path.substr(pos)));
+			return true;
+		}
+
+		// the path ran out of segments
+		if (pos > path.size()) {
+			return fail();
+		}
+
+		size_t end = path.find('/', pos);
+		if (end == std::string_view::npos) {
+			end = path.size();
+		}
+		std::string_view part = path.substr(pos, end - pos);
+
+		switch (seg.kind) {
+		case SegmentKind::Static:
+			if (part != seg.text) {
+				return fail();
+			}
+			break;
+		case SegmentKind::U64Param:
+			if (!is_u64(part)) {
+				return fail();
+			}
+			params.add(std::string(seg.text), std::string(part));
+			break;
+		default:
+			if (part.empty()) {
+				return fail();
+			}
+			params.add(std::string(seg.text), std::string(part));
+		}
+
+		pos = end + 1;
+	}
+
+	// the whole path must be consumed
+	if (pos <= path.size()) {
+		return fail();
+	}
+
+	return true;
+}
+
+#endif // ITI_LIB_HTTP_ROUTER_STATIC_CPP
@@ -0,0 +1,501 @@
+#ifndef ITI_LIB_HTTP_ROUTER_STATIC_H
+#define ITI_LIB_HTTP_ROUTER_STATIC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "http.h"
+#include "router.context.h"
+#include "router.pipeline.h"
+
+namespace iti {
+namespace http {
+namespace router {
+
+// Compile-time route tables.
+//
+// `Mux` parses its patterns and grows a radix tree at startup, then walks the
+// tree on every request. When every route of an API is known at compile time
+// a `StaticRouter` does that work in the compiler instead:
+//
+//	static constexpr char productsPattern[] = "/api/v1/products";
+//	static constexpr char productPattern[]  = "/api/v1/products/{id:u64}";
+//
+//	using api = static_router<
+//	    static_route<Method::GET, productsPattern, list_products>,
+//	    static_route<Method::GET, productPattern, get_product,
+//	                 middlewares::compiled::extract_id>>;
+//
+//	mux->handle("/api/v1/*", std::make_shared<api>());
+//
+// Patterns are validated at compile time; a malformed pattern, a duplicate
+// param key or a misplaced wildcard is a compile error. Routes without
+// params are matched through a perfect hash of their path computed at
+// compile time, and dispatch is an index into a table of handlers, so a
+// static route costs one hash and one string compare. Param routes are then
+// tried in declaration order.
+//
+// Pattern syntax is a subset of `Mux`'s, with typed params instead of
+// regexps:
+//
+//	/api/v1/products          static segments
+//	/users/{name}             any non-empty segment
+//	/products/{id:u64}        a segment holding an unsigned 64-bit integer
+//	/assets/*                 the rest of the path, last segment only
+//
+// A param always spans a whole segment. A static router always matches the
+// full request path (or `RoutingContext::routePath` when a middleware set
+// it). Matched params are stored in the request's `RoutingContext`, as `Mux`
+// does, so `get_url_param()` and the route metrics work unchanged.
+
+namespace static_routes {
+
+enum class PatternError : uint8_t {
+	none,
+	empty,
+	noLeadingSlash,
+	paramNotWholeSegment,
+	emptyParamKey,
+	unknownParamType,
+	duplicateParamKey,
+	wildcardNotWholeSegment,
+	wildcardNotLast,
+};
+
+enum class SegmentKind : uint8_t {
+	Static,   // products
+	Param,    // {name}
+	U64Param, // {id:u64}
+	CatchAll, // *
+};
+
+struct Segment {
+	SegmentKind kind = SegmentKind::Static;
+
+	// static text or param key
+	std::string_view text;
+};
+
+// segment_count returns the number of '/' separated segments of `pattern`.
+constexpr size_t segment_count(std::string_view pattern) {
+	size_t n = 1;
+	for (size_t i = 1; i < pattern.size(); i++) {
+		if (pattern[i] == '/') {
+			n++;
+		}
+	}
+	return n;
+}
+
+// segment_text returns the `idx`th segment of `pattern`.
+constexpr std::string_view segment_text(std::string_view pattern,
+                                        size_t idx) {
+	size_t start = 1;
+	for (size_t i = 0; i < idx; i++) {
+		start = pattern.find('/', start) + 1;
+	}
+
+	size_t end = pattern.find('/', start);
+	if (end == std::string_view::npos) {
+		end = pattern.size();
+	}
+	return pattern.substr(start, end - start);
+}
+
+constexpr Segment parse_segment(std::string_view seg) {
+	if (seg == "*") {
+		return Segment{SegmentKind::CatchAll, "*"};
+	}
+
+	if (seg.empty() || seg.front() != '{') {
+		return Segment{SegmentKind::Static, seg};
+	}
+
+	std::string_view inner = seg.substr(1, seg.size() - 2);
+	size_t colon           = inner.find(':');
+	if (colon == std::string_view::npos) {
+		return Segment{SegmentKind::Param, inner};
+	}
+	return Segment{SegmentKind::U64Param, inner.substr(0, colon)};
+}
+
+constexpr PatternError validate(std::string_view pattern) {
+	if (pattern.empty()) {
+		return PatternError::empty;
+	}
+	if (pattern[0] != '/') {
+		return PatternError::noLeadingSlash;
+	}
+
+	const size_t n = segment_count(pattern);
+	for (size_t i = 0; i < n; i++) {
+		std::string_view seg = segment_text(pattern, i);
+
+		if (seg.find('*') != std::string_view::npos) {
+			if (seg != "*") {
+				return PatternError::wildcardNotWholeSegment;
+			}
+			if (i != n - 1) {
+				return PatternError::wildcardNotLast;
+			}
+			continue;
+		}
+
+		bool hasOpen  = seg.find('{') != std::string_view::npos;
+		bool hasClose = seg.find('}') != std::string_view::npos;
+		if (!hasOpen && !hasClose) {
+			continue;
+		}
+
+		if (seg.size() < 2 || seg.front() != '{' || seg.back() != '}' ||
+		    seg.find('{', 1) != std::string_view::npos ||
+		    seg.find('}') != seg.size() - 1) {
+			return PatternError::paramNotWholeSegment;
+		}
+
+		std::string_view inner = seg.substr(1, seg.size() - 2);
+		size_t colon           = inner.find(':');
+		std::string_view key   = inner.substr(0, colon);
+		if (key.empty()) {
+			return PatternError::emptyParamKey;
+		}
+		if (colon != std::string_view::npos && inner.substr(colon + 1) != "u64") {
+			return PatternError::unknownParamType;
+		}
+
+		for (size_t j = 0; j < i; j++) {
+			Segment prev = parse_segment(segment_text(pattern, j));
+			if (prev.kind != SegmentKind::Static &&
+			    prev.kind != SegmentKind::CatchAll && prev.text == key) {
+				return PatternError::duplicateParamKey;
+			}
+		}
+	}
+
+	return PatternError::none;
+}
+
+// is_static reports whether `pattern` has no params and no wildcard.
+constexpr bool is_static(std::string_view pattern) {
+	return pattern.find('{') == std::string_view::npos &&
+	       pattern.find('*') == std::string_view::npos;
+}
+
+template <size_t N>
+constexpr std::array<Segment, N> parse_segments(std::string_view pattern) {
+	std::array<Segment, N> segs{};
+	for (size_t i = 0; i < N; i++) {
+		segs[i] = parse_segment(segment_text(pattern, i));
+	}
+	return segs;
+}
+
+// hash is a seeded FNV-1a, used both at compile time to build the perfect
+// hash of the static paths and at runtime to look a path up.
+constexpr uint32_t hash(std::string_view s, uint32_t seed) {
+	uint32_t h = 2166136261u ^ seed;
+	for (char c : s) {
+		h ^= static_cast<uint8_t>(c);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// table_size returns the number of slots of the perfect hash table for `n`
+// static routes: a power of two, at least twice `n`.
+constexpr size_t table_size(size_t n) {
+	size_t size = 2;
+	while (size < 2 * n) {
+		size <<= 1;
+	}
+	return size;
+}
+
+constexpr int16_t noRoute = -1;
+
+template <size_t N, size_t Size> struct PathTable {
+	bool found    = false;
+	uint32_t seed = 0;
+
+	// slot -> first static route with the path hashing to the slot
+	std::array<int16_t, Size> slots{};
+
+	// route -> next static route with the same path
+	std::array<int16_t, N> nextSamePath{};
+};
+
+// build_path_table searches a seed that maps every distinct static path of
+// `patterns` to its own slot.
+template <size_t N, size_t Size>
+constexpr PathTable<N, Size>
+build_path_table(const std::array<std::string_view, N> &patterns,
+                 const std::array<bool, N> &statics) {
+	PathTable<N, Size> table{};
+
+	for (size_t i = 0; i < N; i++) {
+		table.nextSamePath[i] = noRoute;
+		if (!statics[i]) {
+			continue;
+		}
+		for (size_t j = i + 1; j < N; j++) {
+			if (statics[j] && patterns[j] == patterns[i]) {
+				table.nextSamePath[i] = int16_t(j);
+				break;
+			}
+		}
+	}
+
+	for (uint32_t seed = 0; seed < 4096 && !table.found; seed++) {
+		for (auto &s : table.slots) {
+			s = noRoute;
+		}
+
+		bool collision = false;
+		for (size_t i = 0; i < N && !collision; i++) {
+			if (!statics[i]) {
+				continue;
+			}
+
+			size_t slot = hash(patterns[i], seed) & (Size - 1);
+			if (table.slots[slot] == noRoute) {
+				table.slots[slot] = int16_t(i);
+			} else if (patterns[table.slots[slot]] != patterns[i]) {
+				collision = true;
+			}
+		}
+
+		if (!collision) {
+			table.found = true;
+			table.seed  = seed;
+		}
+	}
+
+	return table;
+}
+
+} // namespace static_routes
+
+// StaticRoute binds `Handler`, a `void (*)(const Request &, Response &)`,
+// to `Method` and `Pattern`. The pipeline middleware types `Mws` (see
+// "router.pipeline.h") are composed around the handler at compile time.
+template <iti::http::Method::Value Method, const char *Pattern, auto Handler,
+          class... Mws>
+struct StaticRoute {
+	static constexpr iti::http::Method::Value method = Method;
+	static constexpr std::string_view pattern{Pattern};
+
+	static constexpr static_routes::PatternError error =
+	    static_routes::validate(pattern);
+
+	static_assert(error != static_routes::PatternError::empty,
+	              "static route: empty pattern");
+	static_assert(error != static_routes::PatternError::noLeadingSlash,
+	              "static route: pattern must begin with '/'");
+	static_assert(error != static_routes::PatternError::paramNotWholeSegment,
+	              "static route: a param must span a whole segment");
+	static_assert(error != static_routes::PatternError::emptyParamKey,
+	              "static route: param key is empty");
+	static_assert(error != static_routes::PatternError::unknownParamType,
+	              "static route: unknown param type, use {key} or {key:u64}");
+	static_assert(error != static_routes::PatternError::duplicateParamKey,
+	              "static route: duplicate param key");
+	static_assert(
+	    error != static_routes::PatternError::wildcardNotWholeSegment,
+	    "static route: a wildcard must span a whole segment");
+	static_assert(error != static_routes::PatternError::wildcardNotLast,
+	              "static route: a wildcard must be the last segment");
+
+	static constexpr bool isStatic = static_routes::is_static(pattern);
+
+	static constexpr size_t segmentCount =
+	    static_routes::segment_count(pattern);
+
+	static constexpr std::array<static_routes::Segment, segmentCount>
+	    segments = static_routes::parse_segments<segmentCount>(pattern);
+
+	static void invoke(const Request &req, Response &resp) {
+		if constexpr (sizeof...(Mws) == 0) {
+			Handler(req, resp);
+		} else {
+			auto p = pipeline<Mws...>(Handler);
+			p(req, resp);
+		}
+	}
+};
+
+template <iti::http::Method::Value Method, const char *Pattern, auto Handler,
+          class... Mws>
+using static_route = StaticRoute<Method, Pattern, Handler, Mws...>;
+
+// StaticRouterBase holds what every `StaticRouter` shares: the not found and
+// method not allowed handlers, and the runtime segment matcher.
+class StaticRouterBase : public iti::http::IHandler {
+  public:
+	void set_not_found(std::shared_ptr<iti::http::IHandler> h) {
+		notFoundHandler = std::move(h);
+	}
+
+	void set_method_not_allowed(std::shared_ptr<iti::http::IHandler> h) {
+		methodNotAllowedHandler = std::move(h);
+	}
+
+  protected:
+	void not_found(const Request &req, Response &resp);
+	void method_not_allowed(const Request &req, Response &resp);
+
+	// match_segments matches `path` against the `count` segments `segs` and
+	// appends the captured params to `params`. On a mismatch `params` is
+	// left untouched.
+	static bool match_segments(const static_routes::Segment *segs,
+	                           size_t count, std::string_view path,
+	                           RouteParams &params);
+
+	std::shared_ptr<iti::http::IHandler> notFoundHandler;
+	std::shared_ptr<iti::http::IHandler> methodNotAllowedHandler;
+};
+
+// StaticRouter is an `IHandler` routing requests over the compile-time route
+// table `Routes`, a list of `StaticRoute`s. It can be used on its own,
+// mounted on a `Mux` or wrapped in middlewares like any other handler.
+template <class... Routes> class StaticRouter : public StaticRouterBase {
+	static_assert(sizeof...(Routes) > 0, "static router: no routes");
+
+	static constexpr size_t routeCount = sizeof...(Routes);
+
+	static constexpr std::array<std::string_view, routeCount> patterns = {
+	    Routes::pattern...};
+
+	static constexpr std::array<iti::http::Method::Value, routeCount>
+	    methods = {Routes::method...};
+
+	static constexpr std::array<bool, routeCount> statics = {
+	    Routes::isStatic...};
+
+	static constexpr std::array<const static_routes::Segment *, routeCount>
+	    segments = {Routes::segments.data()...};
+
+	static constexpr std::array<size_t, routeCount> segmentCounts = {
+	    Routes::segmentCount...};
+
+	using dispatchFunc = void (*)(const Request &, Response &);
+
+	static constexpr std::array<dispatchFunc, routeCount> handlers = {
+	    &Routes::invoke...};
+
+	static constexpr bool has_duplicate_routes() {
+		for (size_t i = 0; i < routeCount; i++) {
+			for (size_t j = i + 1; j < routeCount; j++) {
+				if (patterns[i] == patterns[j] && methods[i] == methods[j]) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	static_assert(!has_duplicate_routes(),
+	              "static router: a method and pattern is routed twice");
+
+	static constexpr size_t tableSize = static_routes::table_size(routeCount);
+
+	static constexpr auto table =
+	    static_routes::build_path_table<routeCount, tableSize>(patterns,
+	                                                           statics);
+
+	static_assert(table.found,
+	              "static router: no perfect hash found for the static paths");
+
+	// method_matches reports whether route `idx` serves `m`. As with `Mux`,
+	// GET routes also serve HEAD.
+	static constexpr bool method_matches(size_t idx,
+	                                     iti::http::Method::Value m) {
+		return methods[idx] == m || methods[idx] == iti::http::Method::ALL ||
+		       (m == iti::http::Method::HEAD &&
+		        methods[idx] == iti::http::Method::GET);
+	}
+
+  public:
+	void handle_request(const Request &req, Response &resp) override {
+		auto rctx = RoutingContext::get_create_ctx_from_request(req);
+
+		std::string_view path = rctx->routePath;
+		if (path.empty()) {
+			path = req.url.path();
+		}
+
+		const auto m     = req.method();
+		bool pathMatched = false;
+
+		// HEAD responses never carry a body
+		if (m == iti::http::Method::HEAD) {
+			resp.omitBody = true;
+		}
+
+		// static routes: perfect hash lookup
+		size_t slot = static_routes::hash(path, table.seed) & (tableSize - 1);
+		for (int16_t i = table.slots[slot];
+		     i != static_routes::noRoute && patterns[i] == path;
+		     i = table.nextSamePath[i]) {
+			pathMatched = true;
+			if (method_matches(i, m)) {
+				dispatch(i, *rctx, req, resp);
+				return;
+			}
+		}
+
+		// param routes, in declaration order
+		for (size_t i = 0; i < routeCount; i++) {
+			if (statics[i]) {
+				continue;
+			}
+
+			const size_t prevLen = rctx->urlParams.keys.size();
+			if (!match_segments(segments[i], segmentCounts[i], path,
+			                    rctx->urlParams)) {
+				continue;
+			}
+
+			if (method_matches(i, m)) {
+				dispatch(i, *rctx, req, resp);
+				return;
+			}
+
+			// the path matched but not the method: drop the params
+			pathMatched = true;
+			rctx->urlParams.keys.resize(prevLen);
+			rctx->urlParams.values.resize(prevLen);
+		}
+
+		if (pathMatched) {
+			method_not_allowed(req, resp);
+			return;
+		}
+
+		not_found(req, resp);
+	}
+
+  private:
+	static void dispatch(size_t idx, RoutingContext &rctx, const Request &req,
+	                     Response &resp) {
+		// when handled under a `Mux` wildcard, the full pattern replaces it
+		auto &pats = rctx.routePatterns;
+		if (!pats.empty() && pats.back().size() >= 2 &&
+		    pats.back().compare(pats.back().size() - 2, 2, "/*") == 0) {
+			pats.back() = patterns[idx];
+		} else {
+			pats.emplace_back(patterns[idx]);
+		}
+		handlers[idx](req, resp);
+	}
+};
+
+template <class... Routes> using static_router = StaticRouter<Routes...>;
+
+} // namespace router
+} // namespace http
+} // namespace iti
+
+#endif // ITI_LIB_HTTP_ROUTER_STATIC_H
@@ -0,0 +1,117 @@
+// StaticRouter tests (see "test.h"): ./run.sh router.static.test.cpp
+//
+// Paths are routed through a StaticRouter and through a Mux with the same
+// routes, which must agree on what matches and on the params captured.
+
+#include "test.h"
+
+#include <memory>
+#include <string>
+
+#include "http.h"
+#include "router.context.h"
+#include "router.mux.h"
+#include "router.static.h"
+
+using iti::http::Method;
+using iti::http::Request;
+using iti::http::Response;
+using iti::http::StatusCode;
+using iti::http::Uri;
+using iti::http::router::Mux;
+using iti::http::router::RoutingContext;
+using iti::http::router::static_route;
+using iti::http::router::static_router;
+
+namespace {
+
+// NullResponse drops what is written to it; the router sets its status.
+class NullResponse : public Response {
+  public:
+	void write(const std::string & /*body*/ = "") override {}
+	void append(std::string_view /*chunk*/) override {}
+};
+
+// matched holds the params of the last request a handler got.
+std::string matched;
+
+void capture_rest(const Request &req, Response & /*resp*/) {
+	matched = "*=" + RoutingContext::get_create_ctx_from_request(req)
+	                     ->get_url_param("*");
+}
+
+void capture_id(const Request &req, Response & /*resp*/) {
+	matched = "id=" + RoutingContext::get_create_ctx_from_request(req)
+	                      ->get_url_param("id");
+}
+
+void capture_name(const Request &req, Response & /*resp*/) {
+	matched = "name=" + RoutingContext::get_create_ctx_from_request(req)
+	                        ->get_url_param("name");
+}
+
+static constexpr char assetsPattern[]  = "/assets/*";
+static constexpr char productPattern[] = "/products/{id:u64}";
+static constexpr char userPattern[]    = "/users/{name}";
+
+using Api =
+    static_router<static_route<Method::GET, assetsPattern, capture_rest>,
+                  static_route<Method::GET, productPattern, capture_id>,
+                  static_route<Method::GET, userPattern, capture_name>>;
+
+// route returns what a GET of `path` through `router` matched, or its
+// status when no handler was called.
+std::string route(iti::http::IHandler &router, const char *path) {
+	Request req;
+	NullResponse resp;
+	req.method = Method::GET;
+	Uri::parse(path, req.url);
+	matched.clear();
+	router.handle_request(req, resp);
+	return matched.empty() ? std::to_string(resp.status) : matched;
+}
+
+} // namespace
+
+int main() {
+	Api api;
+	auto mux = std::make_shared<Mux>();
+	mux->get("/assets/*", capture_rest);
+	mux->get("/products/{id}", capture_id);
+	mux->get("/users/{name}", capture_name);
+
+	const std::string notFound =
+	    std::to_string(StatusCode::Status404NotFound);
+	struct {
+		const char *path;
+		std::string want;
+	} cases[] = {
+	    // the bare prefix of a catch-all, with and without its slash
+	    {"/assets", notFound},
+	    {"/assets/", "*="},
+	    {"/assets/app.js", "*=app.js"},
+	    {"/assets/js/app.js", "*=js/app.js"},
+	    {"/assetsx", notFound},
+	    {"/products/42", "id=42"},
+	    {"/products/", notFound},
+	    {"/products", notFound},
+	    {"/users/ann", "name=ann"},
+	    {"/users/ann/", notFound},
+	    {"/", notFound},
+	};
+	for (const auto &c : cases) {
+		const std::string got = route(api, c.path);
+		if (!ITI_CHECK(got == c.want)) {
+			std::printf("  %s: got %s, want %s\n", c.path, got.c_str(),
+			            c.want.c_str());
+		}
+		if (c.want.rfind("id=", 0) == 0) {
+			continue; // Mux params aren't typed
+		}
+		const std::string gotMux = route(*mux, c.path);
+		if (!ITI_CHECK(gotMux == got)) {
+			std::printf("  %s: Mux got %s\n", c.path, gotMux.c_str());
+		}
+	}
+	return iti::test::report("router.static");
+}
@@ -26,6 +26,35 @@ static const constexpr std::array<http::Method, 9> methodsList = {
     http::Method::POST,    http::Method::PUT,     http::Method::TRACE,
 };
 
+// endpoints
+// ----------------------------------------------------------------------------
+void iti::http::router::Endpoints::update_methods() {
+	methodMask = 0;
+	for (const auto &m : methodsList) {
+		auto ep = collection[slot_of(m())];
+		if (ep != nullptr && ep->handler != nullptr) {
+			methodMask |= static_cast<uint16_t>(m());
+		}
+	}
+
+	// GET implies HEAD, and OPTIONS is always answered
+	uint16_t allowMask = methodMask | uint16_t(http::Method::OPTIONS);
+	if ((methodMask & http::Method::GET) != 0) {
+		allowMask |= uint16_t(http::Method::HEAD);
+	}
+
+	allow.clear();
+	for (const auto &m : methodsList) {
+		if ((allowMask & m()) == 0) {
+			continue;
+		}
+		if (!allow.empty()) {
+			allow += ", ";
+		}
+		allow += m.str();
+	}
+}
+
 // pat_next_segment returns the next segment details from a pattern:
 struct NextSegmentResult {
   public:
@@ -320,10 +349,11 @@ iti::http::router::Node::insert_route(http::Method method,
 	}
 }
 
-std::tuple<std::shared_ptr<Node>, Endpoints, std::shared_ptr<http::IHandler>>
+std::tuple<std::shared_ptr<Node>, const Endpoints *,
+           std::shared_ptr<http::IHandler>>
 iti::http::router::Node::find_route(std::shared_ptr<RoutingContext> rctx,
                                     iti::http::Method method,
-                                    const std::string &path) {
+                                    std::string_view path) {
 
 	// Reset the context routing pattern and params
 	rctx->routePattern.clear();
@@ -333,7 +363,7 @@ iti::http::router::Node::find_route(std::shared_ptr<RoutingContext> rctx,
 	// Find the routing handlers for the path
 	auto rn = find_route_helper(rctx, method, path);
 	if (rn == nullptr) {
-		return std::make_tuple(nullptr, Endpoints(), nullptr);
+		return std::make_tuple(nullptr, nullptr, nullptr);
 	}
 
 	// Record the routing params in the request lifecycle
@@ -346,14 +376,18 @@ iti::http::router::Node::find_route(std::shared_ptr<RoutingContext> rctx,
 	                              rctx->routeParams.values.end());
 
 	// Record the routing pattern in the request lifecycle
-	auto &eps = rn->endpoints.collection[method()];
+	auto eps = rn->endpoints.resolve(method);
+	if (eps == nullptr) {
+		return std::make_tuple(rn, &rn->endpoints, nullptr);
+	}
+
 	if (!(eps->pattern.empty())) {
 		rctx->routePattern = eps->pattern;
 
 		rctx->routePatterns.emplace_back(rctx->routePattern);
 	}
 
-	return std::make_tuple(rn, rn->endpoints, eps->handler);
+	return std::make_tuple(rn, &rn->endpoints, eps->handler);
 }
 
 std::shared_ptr<Node>
@@ -500,19 +534,21 @@ void iti::http::router::Node::set_endpoint(
 		h->pattern   = pattern;
 		h->paramKeys = paramKeys;
 	}
+
+	endpoints.update_methods();
 }
 
 std::shared_ptr<Node>
 iti::http::router::Node::find_route_helper(std::shared_ptr<RoutingContext> rctx,
                                            http::Method method,
-                                           const std::string &path) {
+                                           std::string_view path) {
 	auto nn = shared_from_this();
 
-	std::string search = path;
+	std::string_view search = path;
 
 	for (size_t i = 0; i < nn->children.size(); i++) {
-		NodeType ntyp = (NodeType)i;
-		auto nds      = nn->children[i];
+		NodeType ntyp   = (NodeType)i;
+		const auto &nds = nn->children[i];
 
 		if (nds.empty()) {
 			continue;
@@ -562,8 +598,8 @@ iti::http::router::Node::find_route_helper(std::shared_ptr<RoutingContext> rctx,
 				}
 
 				if (ntyp == NodeType::Regexp && xn->rex != nullptr) {
-					std::string s{xsearch.substr(0, p)};
-					if (!std::regex_search(s, *(xn->rex.get()))) {
+					if (!std::regex_search(xsearch.begin(), xsearch.begin() + p,
+					                       *(xn->rex.get()))) {
 						continue;
 					}
 				} else if (xsearch.substr(0, p).find('/') !=
@@ -578,7 +614,7 @@ iti::http::router::Node::find_route_helper(std::shared_ptr<RoutingContext> rctx,
 
 				if (xsearch.empty()) {
 					if (xn->is_leaf()) {
-						auto h = xn->endpoints[method];
+						auto h = xn->endpoints.resolve(method);
 						if (h != nullptr && h->handler != nullptr) {
 							rctx->routeParams.keys.insert(
 							    rctx->routeParams.keys.end(),
@@ -589,12 +625,12 @@ iti::http::router::Node::find_route_helper(std::shared_ptr<RoutingContext> rctx,
 						// flag that the routing context found a route, but not
 						// a corresponding supported method
 						rctx->methodNotAllowed = true;
+						rctx->allowedMethods   = &xn->endpoints.allow;
 					}
 				}
 
 				// recursively find the next node on this branch
-				auto fin =
-				    xn->find_route_helper(rctx, method, std::string{xsearch});
+				auto fin = xn->find_route_helper(rctx, method, xsearch);
 				if (fin != nullptr) {
 					return fin;
 				}
@@ -621,7 +657,7 @@ iti::http::router::Node::find_route_helper(std::shared_ptr<RoutingContext> rctx,
 		// did we find it yet?
 		if (xsearch.empty()) {
 			if (xn->is_leaf()) {
-				auto h = xn->endpoints[method];
+				auto h = xn->endpoints.resolve(method);
 				if (h != nullptr && h->handler != nullptr) {
 					rctx->routeParams.keys.insert(rctx->routeParams.keys.end(),
 					                              h->paramKeys.begin(),
@@ -632,11 +668,12 @@ iti::http::router::Node::find_route_helper(std::shared_ptr<RoutingContext> rctx,
 				// flag that the routing context found a route, but not a
 				// corresponding supported method
 				rctx->methodNotAllowed = true;
+				rctx->allowedMethods   = &xn->endpoints.allow;
 			}
 		}
 
 		// recursively find the next node..
-		auto fin = xn->find_route_helper(rctx, method, std::string{xsearch});
+		auto fin = xn->find_route_helper(rctx, method, xsearch);
 		if (fin != nullptr) {
 			return fin;
 		}
@@ -687,7 +724,7 @@ std::shared_ptr<Node> iti::http::router::Node::find_edge(NodeType ntyp,
 }
 
 bool iti::http::router::Node::is_leaf() {
-	return !endpoints.collection.empty();
+	return !endpoints.empty();
 }
 
 bool iti::http::router::Node::find_pattern(const std::string &pattern) {
@@ -752,12 +789,13 @@ std::vector<iti::http::router::Route> iti::http::router::Node::get_routes() {
 		    // Group methodHandlers by unique patterns
 		    std::unordered_map<std::string, Endpoints> pats;
 
-		    for (auto &[mt, h] : eps.collection) {
-			    if (h->pattern.empty()) {
+		    for (size_t i = 0; i < Endpoints::slotCount; i++) {
+			    const auto &h = eps.collection[i];
+			    if (h == nullptr || h->pattern.empty()) {
 				    continue;
 			    }
 
-			    pats[h->pattern][mt] = h;
+			    pats[h->pattern].set(Endpoints::method_at(i), h);
 		    }
 
 		    for (auto &[p, mh] : pats) {
@@ -769,16 +807,15 @@ std::vector<iti::http::router::Route> iti::http::router::Node::get_routes() {
 				    hs["*"] = mh[Method::ALL]->handler;
 			    }
 
-			    for (auto &[mt, h] : mh.collection) {
-				    if (h->handler == nullptr) {
+			    for (size_t i = 0; i < Endpoints::allSlot; i++) {
+				    const auto &h = mh.collection[i];
+				    if (h == nullptr || h->handler == nullptr) {
 					    continue;
 				    }
 
-				    try {
-					    std::string m{mt.str()};
+				    std::string m{Endpoints::method_at(i).str()};
+				    if (!m.empty()) {
 					    hs[m] = h->handler;
-				    } catch (const std::logic_error) {
-					    continue;
 				    }
 			    }
 
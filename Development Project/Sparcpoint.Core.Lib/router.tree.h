@@ -34,45 +34,114 @@ class Endpoint {
 
 // endpoints is a mapping of http method constants to handlers
 // for a given route.
+//
+// The collection is a fixed array with one slot per `Method` bit, plus a
+// slot for `Method::ALL`, so a lookup is an index and a miss is a nullptr.
 class Endpoints {
   public:
-	std::unordered_map<iti::http::Method, std::shared_ptr<Endpoint>> collection;
+	// slot of `Method::ALL`; the slots below it are the `Method` bits.
+	static constexpr size_t allSlot   = 10;
+	static constexpr size_t slotCount = allSlot + 1;
+	static constexpr size_t npos      = size_t(-1);
+
+	// slot_of returns the slot of `method`, or `npos` if `method` is neither
+	// a single method nor `Method::ALL`.
+	static constexpr size_t slot_of(iti::http::Method::Value method) {
+		if (method == iti::http::Method::ALL) {
+			return allSlot;
+		}
+		for (size_t i = 0; i < allSlot; i++) {
+			if (method == (1 << i)) {
+				return i;
+			}
+		}
+		return npos;
+	}
 
-	std::shared_ptr<Endpoint> operator[](const iti::http::Method method) const {
-		std::shared_ptr<Endpoint> ep = nullptr;
+	// method_at returns the method stored in slot `idx`.
+	static constexpr iti::http::Method method_at(size_t idx) {
+		if (idx == allSlot) {
+			return iti::http::Method::ALL;
+		}
+		return iti::http::Method::Value(1 << idx);
+	}
+
+	std::array<std::shared_ptr<Endpoint>, slotCount> collection{};
 
-		try {
-			ep = collection.at(method);
-		} catch (const std::out_of_range &) {
+	// find returns the endpoint registered for `method`, or nullptr.
+	std::shared_ptr<Endpoint> find(const iti::http::Method method) const {
+		size_t idx = slot_of(method());
+		if (idx == npos) {
+			return nullptr;
 		}
+		return collection[idx];
+	}
 
-		return ep;
+	std::shared_ptr<Endpoint> operator[](const iti::http::Method method) const {
+		return find(method);
 	}
 
 	std::shared_ptr<Endpoint>
 	operator[](iti::http::Method::Value mValue) const {
-		std::shared_ptr<Endpoint> ep = nullptr;
+		return find(iti::http::Method(mValue));
+	}
 
-		try {
-			ep = collection.at(iti::http::Method(mValue));
-		} catch (const std::out_of_range &) {
+	// Value returns the endpoint registered for `method`, creating it if
+	// needed.
+	std::shared_ptr<Endpoint> Value(http::Method method) {
+		size_t idx = slot_of(method());
+		if (idx == npos) {
+			throw std::logic_error(fmt::format(
+			    "router: endpoints: invalid method {}", method()));
+		}
+
+		auto &ep = collection[idx];
+		if (ep == nullptr) {
+			ep = std::make_shared<Endpoint>();
 		}
 
 		return ep;
 	}
 
-	std::shared_ptr<Endpoint> Value(http::Method method) {
-		std::shared_ptr<Endpoint> ep;
-
-		try {
-			ep = collection.at(method);
-		} catch (const std::out_of_range &) {
-			ep = std::make_shared<Endpoint>();
+	void set(http::Method method, std::shared_ptr<Endpoint> ep) {
+		size_t idx = slot_of(method());
+		if (idx != npos) {
+			collection[idx] = std::move(ep);
+		}
+	}
 
-			collection[method] = ep;
+	bool empty() const {
+		for (const auto &ep : collection) {
+			if (ep != nullptr) {
+				return false;
+			}
 		}
+		return true;
+	}
 
-		return ep;
+	// methodMask has the `Method` bit set for every method with a handler.
+	uint16_t methodMask = 0;
+
+	// allow is the "Allow" header value for the route: every method with a
+	// handler, plus HEAD when GET is handled and OPTIONS.
+	std::string allow;
+
+	// update_methods recomputes `methodMask` and `allow`. It must be called
+	// whenever an endpoint handler changes.
+	void update_methods();
+
+	// resolve returns the endpoint serving `method`, or nullptr. HEAD falls
+	// back to the GET endpoint.
+	std::shared_ptr<Endpoint> resolve(const iti::http::Method method) const {
+		const auto m = method();
+		if ((methodMask & m) != 0) {
+			return collection[slot_of(m)];
+		}
+		if (m == iti::http::Method::HEAD &&
+		    (methodMask & iti::http::Method::GET) != 0) {
+			return collection[slot_of(iti::http::Method::GET)];
+		}
+		return nullptr;
 	}
 };
 
@@ -114,10 +183,10 @@ class Node : public std::enable_shared_from_this<Node> {
 	                                   const std::string &pattern,
 	                                   std::shared_ptr<http::IHandler> handler);
 
-	std::tuple<std::shared_ptr<Node>, Endpoints,
+	std::tuple<std::shared_ptr<Node>, const Endpoints *,
 	           std::shared_ptr<http::IHandler>>
 	find_route(std::shared_ptr<RoutingContext> rctx, iti::http::Method method,
-	           const std::string &path);
+	           std::string_view path);
 
 	std::vector<iti::http::router::Route> get_routes();
 
@@ -145,7 +214,7 @@ class Node : public std::enable_shared_from_this<Node> {
 	// It's like searching through a multi-dimensional radix trie.
 	std::shared_ptr<Node>
 	find_route_helper(std::shared_ptr<RoutingContext> rctx, http::Method method,
-	                  const std::string &path);
+	                  std::string_view path);
 
 	std::shared_ptr<Node> find_edge(NodeType ntyp, char label);
 
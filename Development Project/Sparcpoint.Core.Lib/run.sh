@@ -0,0 +1,20 @@
+#!/bin/sh
+# run.sh builds one of the benchmark or test programs of the library (the
+# `*.bench.cpp` and `*.test.cpp` files, see "bench.h") with the library
+# sources, and runs it. Paths are relative to this directory:
+#
+#	./run.sh router.bench.cpp
+#	./run.sh ../Interview.Web/evHttpResponse.bench.cpp -levent
+#
+# Extra arguments go to the compiler ($CXX, g++ by default), after
+# $CXXFLAGS (-O2 by default).
+set -e
+cd "$(dirname "$0")"
+src=$1
+shift
+out=${TMPDIR:-/tmp}/$(basename "$src" .cpp)
+${CXX:-g++} -std=c++17 ${CXXFLAGS:--O2} -I. -I../vendor/fmt-7.1.3/include \
+    -I../vendor/nlohmann-3.10.2 -DFMT_HEADER_ONLY -o "$out" "$src" \
+    $(ls *.cpp | grep -v -e '\.bench\.cpp$' -e '\.test\.cpp$') \
+    -lpthread "$@"
+"$out"
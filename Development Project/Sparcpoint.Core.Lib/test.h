@@ -0,0 +1,56 @@
+#ifndef ITI_LIB_TEST_H
+#define ITI_LIB_TEST_H
+
+#include <cstdio>
+
+// Helpers of the tests, the `*.test.cpp` programs next to the code they
+// check. Like the benchmarks (see "bench.h"), each test is a program of its
+// own, built and run with "run.sh"; it exits with 1 if a check failed.
+
+namespace iti {
+namespace test {
+
+inline int &failures() {
+	static int count = 0;
+	return count;
+}
+
+// check records a failure, and prints it, if `ok` is false.
+inline bool check(bool ok, const char *what, const char *file, int line) {
+	if (!ok) {
+		failures()++;
+		std::printf("%s:%d: check failed: %s\n", file, line, what);
+	}
+	return ok;
+}
+
+// report prints the outcome of the checks made so far, and returns the exit
+// status of the test.
+inline int report(const char *name) {
+	if (failures() != 0) {
+		std::printf("%s: %d checks failed\n", name, failures());
+		return 1;
+	}
+	std::printf("%s: ok\n", name);
+	return 0;
+}
+
+} // namespace test
+} // namespace iti
+
+// ITI_CHECK checks that `cond` holds, and carries on either way.
+#define ITI_CHECK(cond) iti::test::check((cond), #cond, __FILE__, __LINE__)
+
+// ITI_CHECK_THROWS checks that `expr` throws an exception of type `E`.
+#define ITI_CHECK_THROWS(expr, E)                                              \
+	do {                                                                       \
+		bool thrown = false;                                                   \
+		try {                                                                  \
+			expr;                                                              \
+		} catch (const E &) {                                                  \
+			thrown = true;                                                     \
+		}                                                                      \
+		iti::test::check(thrown, #expr " throws " #E, __FILE__, __LINE__);     \
+	} while (0)
+
+#endif // ITI_LIB_TEST_H
@@ -0,0 +1,129 @@
+// Uri micro-benchmarks (see "bench.h"): ./run.sh uri.bench.cpp
+
+#include "bench.h"
+
+#include <algorithm>
+#include <charconv>
+#include <memory_resource>
+#include <string>
+
+#include "StrUtils.h"
+#include "uri.h"
+
+using iti::http::Uri;
+
+namespace before {
+
+// Uri as it was before views and query parsing: every part is copied into
+// a string of its own, and there is no query parser.
+class Uri {
+  public:
+	std::pmr::string queryString, path, protocol, host, rawPort;
+	long port{};
+
+	static void parse(const std::string &rawUri, Uri &result) {
+		result.reset();
+
+		if (rawUri.empty()) {
+			return;
+		}
+
+		auto uriEnd = rawUri.end();
+
+		// get query start
+		auto queryStart = std::find(rawUri.begin(), uriEnd, '?');
+
+		// protocol
+		auto protocolStart = rawUri.begin();
+		auto protocolEnd   = std::find(protocolStart, uriEnd, ':');
+
+		if (protocolEnd != uriEnd) {
+			std::string prot = &*(protocolEnd);
+			if ((prot.length() > 3) && (prot.substr(0, 3) == "://")) {
+				result.protocol.assign(protocolStart, protocolEnd);
+				protocolEnd += 3; // ://
+			} else {
+				protocolEnd = rawUri.begin(); // no protocol
+			}
+		} else {
+			protocolEnd = rawUri.begin(); // no protocol
+		}
+		// host
+		auto hostStart = protocolEnd;
+		auto pathStart = std::find(hostStart, uriEnd, '/'); // get pathStart
+
+		auto hostEnd = std::find(protocolEnd,
+		                         (pathStart != uriEnd) ? pathStart : queryStart,
+		                         ':'); // check for port
+
+		result.host.assign(hostStart, hostEnd);
+
+		// port
+		if ((hostEnd != uriEnd) && ((&*(hostEnd))[0] == ':')) {
+			// we have a port
+			hostEnd++;
+			auto portEnd   = (pathStart != uriEnd) ? pathStart : queryStart;
+			result.rawPort.assign(hostEnd, portEnd);
+			const auto res = std::from_chars(
+			    result.rawPort.data(),
+			    result.rawPort.data() + result.rawPort.size(), result.port);
+
+			if (res.ec != std::errc()) {
+				result.port = 0;
+			}
+		}
+
+		if (result.port == 0) {
+			if (iti::strutils::iequals(result.protocol, "http")) {
+				result.port = 80;
+			} else if (iti::strutils::iequals(result.protocol, "https")) {
+				result.port = 443;
+			}
+		}
+
+		// path
+		if (pathStart != uriEnd) {
+			result.path.assign(pathStart, queryStart);
+		}
+
+		// query
+		if (queryStart != uriEnd) {
+			result.queryString.assign(queryStart, rawUri.end());
+		}
+	}
+
+	void reset() {
+		queryString.clear();
+		path.clear();
+		protocol.clear();
+		host.clear();
+		rawPort.clear();
+		port = 0;
+	}
+};
+
+} // namespace before
+
+// a product listing request, as libevent hands it over
+static const char listing[] =
+    "/api/v1/products?limit=25&offset=50&category=tools";
+
+int main() {
+	before::Uri oldUri;
+	iti::bench::run("Uri::parse of a listing, before (no query parsing)",
+	                1000000, [&] {
+		                before::Uri::parse(listing, oldUri);
+		                iti::bench::keep(oldUri.path.size());
+	                });
+
+	Uri uri;
+	iti::bench::run("Uri::parse of a listing, after", 1000000, [&] {
+		Uri::parse(listing, uri);
+		iti::bench::keep(uri.path().size());
+	});
+	iti::bench::run("Uri::parse + query().get<int>(\"limit\")", 1000000, [&] {
+		Uri::parse(listing, uri);
+		iti::bench::keep(uri.query().get<int>("limit"));
+	});
+	return 0;
+}
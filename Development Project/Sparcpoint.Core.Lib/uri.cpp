@@ -0,0 +1,333 @@
+#ifndef ITI_LIB_HTTP_URI_CPP
+#define ITI_LIB_HTTP_URI_CPP
+
+#include "pch.h"
+
+#include "uri.h"
+
+#include "StrUtils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ITI_URI_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+using iti::http::Query;
+using iti::http::Uri;
+
+// Helpers
+// ----------------------------------------------------------------------------
+
+#ifdef ITI_URI_SSE2
+static inline unsigned first_set_bit(unsigned mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return idx;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// `next_escape()` returns the index of the first '%', or '+' if `plusAsSpace`
+// is set, in `in` at or after `i`, or `in.size()`. Plain runs are skipped 16
+// bytes at a time.
+static size_t next_escape(std::string_view in, size_t i, bool plusAsSpace) {
+#ifdef ITI_URI_SSE2
+	const __m128i percent = _mm_set1_epi8('%');
+	const __m128i plus    = _mm_set1_epi8(plusAsSpace ? '+' : '%');
+
+	for (; i + 16 <= in.size(); i += 16) {
+		__m128i chunk =
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(in.data() + i));
+		unsigned mask = unsigned(_mm_movemask_epi8(_mm_or_si128(
+		    _mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus))));
+		if (mask != 0) {
+			return i + first_set_bit(mask);
+		}
+	}
+#endif
+
+	for (; i < in.size(); i++) {
+		if (in[i] == '%' || (plusAsSpace && in[i] == '+')) {
+			return i;
+		}
+	}
+	return in.size();
+}
+
+static inline int hex_value(char c) {
+	if ('0' <= c && c <= '9') {
+		return c - '0';
+	}
+	if ('a' <= c && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if ('A' <= c && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+// `is_dot_segment()` reports whether the segment starting at `path[i]` is
+// "." or "..".
+static inline bool is_dot_segment(std::string_view path, size_t i) {
+	size_t end = path.find('/', i);
+	auto seg   = path.substr(i, end == std::string_view::npos ? end : end - i);
+	return seg == "." || seg == "..";
+}
+
+void iti::http::percent_decode(std::string_view in, std::pmr::string &out,
+                               bool plusAsSpace) {
+	size_t i = 0;
+	while (i < in.size()) {
+		size_t esc = next_escape(in, i, plusAsSpace);
+		out.append(in.data() + i, esc - i);
+		if (esc == in.size()) {
+			break;
+		}
+
+		if (in[esc] == '+') {
+			out.push_back(' ');
+			i = esc + 1;
+			continue;
+		}
+
+		int hi = esc + 2 < in.size() ? hex_value(in[esc + 1]) : -1;
+		int lo = hi >= 0 ? hex_value(in[esc + 2]) : -1;
+		if (lo < 0) {
+			// malformed escape: keep it as it is
+			out.push_back('%');
+			i = esc + 1;
+			continue;
+		}
+
+		out.push_back(char((hi << 4) | lo));
+		i = esc + 3;
+	}
+}
+
+// query
+// ----------------------------------------------------------------------------
+void iti::http::Query::parse(std::string_view rawQuery) {
+	reset();
+	raw = rawQuery;
+
+	size_t pos = 0;
+	while (pos <= raw.size()) {
+		size_t amp = raw.find('&', pos);
+		if (amp == std::string_view::npos) {
+			amp = raw.size();
+		}
+
+		auto pair = raw.substr(pos, amp - pos);
+		if (!pair.empty()) {
+			size_t eq = pair.find('=');
+
+			Param p;
+			p.key = make_part(pair.substr(0, eq));
+			if (eq != std::string_view::npos) {
+				p.value = make_part(pair.substr(eq + 1));
+			}
+			params.push_back(p);
+		}
+
+		pos = amp + 1;
+	}
+}
+
+Query::Part iti::http::Query::make_part(std::string_view s) {
+	Part p;
+
+	// most keys and values need no decoding: keep a view of them
+	if (next_escape(s, 0, true) == s.size()) {
+		p.pos = uint32_t(s.data() - raw.data());
+		p.len = uint32_t(s.size());
+		return p;
+	}
+
+	p.pos = uint32_t(decoded.size());
+	percent_decode(s, decoded, true);
+	p.len       = uint32_t(decoded.size() - p.pos);
+	p.isDecoded = true;
+	return p;
+}
+
+const Query::Param *iti::http::Query::find(std::string_view key) const {
+	for (const auto &p : params) {
+		if (view(p.key) == key) {
+			return &p;
+		}
+	}
+	return nullptr;
+}
+
+std::string_view iti::http::Query::get(std::string_view key) const {
+	const Param *p = find(key);
+	return p != nullptr ? view(p->value) : std::string_view();
+}
+
+std::vector<std::string_view>
+iti::http::Query::get_all(std::string_view key) const {
+	std::vector<std::string_view> values;
+	for (const auto &p : params) {
+		if (view(p.key) == key) {
+			values.emplace_back(view(p.value));
+		}
+	}
+	return values;
+}
+
+// uri
+// ----------------------------------------------------------------------------
+void iti::http::Uri::parse(std::string_view rawUri, Uri &result) {
+	result.reset();
+
+	// the fragment is never sent to the server
+	if (auto hash = rawUri.find('#'); hash != std::string_view::npos) {
+		rawUri = rawUri.substr(0, hash);
+	}
+
+	if (rawUri.empty()) {
+		return;
+	}
+
+	result.raw.assign(rawUri.data(), rawUri.size());
+	std::string_view uri = result.raw;
+
+	auto part = [](size_t pos, size_t len) {
+		return Part{uint32_t(pos), uint32_t(len)};
+	};
+
+	size_t queryStart = uri.find('?');
+	size_t pathEnd = queryStart == std::string_view::npos ? uri.size()
+	                                                      : queryStart;
+
+	// protocol: a "scheme://" prefix, before any '/'
+	size_t pos       = 0;
+	size_t schemeEnd = uri.find("://");
+	if (schemeEnd != std::string_view::npos && schemeEnd < pathEnd &&
+	    uri.find('/') > schemeEnd) {
+		result.protocolPart = part(0, schemeEnd);
+		pos                 = schemeEnd + 3;
+
+		// authority: [userinfo@]host[:port], up to the path
+		size_t pathStart = std::min(uri.find('/', pos), pathEnd);
+		auto authority   = uri.substr(pos, pathStart - pos);
+
+		if (auto at = authority.rfind('@'); at != std::string_view::npos) {
+			pos += at + 1;
+			authority.remove_prefix(at + 1);
+		}
+
+		// the colons of an IPv6 literal ("[::1]:8080") aren't the port's
+		size_t colon   = authority.rfind(':');
+		size_t bracket = authority.rfind(']');
+		if (colon != std::string_view::npos &&
+		    (bracket == std::string_view::npos || bracket < colon)) {
+			result.hostPart = part(pos, colon);
+			result.portPart =
+			    part(pos + colon + 1, authority.size() - colon - 1);
+
+			auto rawPort   = result.raw_port();
+			const auto res = std::from_chars(
+			    rawPort.data(), rawPort.data() + rawPort.size(),
+			    result.portNumber);
+			if (res.ec != std::errc()) {
+				result.portNumber = 0;
+			}
+		} else {
+			result.hostPart = part(pos, authority.size());
+		}
+
+		pos = pathStart;
+	}
+
+	if (result.portNumber == 0) {
+		if (strutils::iequals(result.protocol(), "http")) {
+			result.portNumber = 80;
+		} else if (strutils::iequals(result.protocol(), "https")) {
+			result.portNumber = 443;
+		}
+	}
+
+	result.pathPart = part(pos, pathEnd - pos);
+	if (queryStart != std::string_view::npos) {
+		result.queryPart = part(queryStart + 1, uri.size() - queryStart - 1);
+	}
+
+	result.pathNormalized =
+	    normalize_path(result.raw_path(), result.normalized);
+}
+
+bool iti::http::Uri::normalize_path(std::string_view path,
+                                    std::pmr::string &out) {
+	// most paths are already normalized: check before copying
+	bool clean = true;
+	for (size_t i = path.find('/'); i != std::string_view::npos && clean;
+	     i = path.find('/', i + 1)) {
+		clean = !(i + 1 < path.size() && path[i + 1] == '/') &&
+		        !is_dot_segment(path, i + 1);
+	}
+	if (clean) {
+		return false;
+	}
+
+	out.clear();
+	out.reserve(path.size());
+
+	size_t i = 0;
+	while (i < path.size()) {
+		if (path[i] == '/') {
+			i++; // duplicate slashes collapse
+			continue;
+		}
+
+		size_t end = path.find('/', i);
+		if (end == std::string_view::npos) {
+			end = path.size();
+		}
+
+		auto seg = path.substr(i, end - i);
+		if (seg == "..") {
+			// drop the last segment, never going above the root
+			size_t last = out.rfind('/');
+			out.resize(last == std::string::npos ? 0 : last);
+		} else if (seg != ".") {
+			out.push_back('/');
+			out.append(seg.data(), seg.size());
+		}
+
+		i = end;
+	}
+
+	// keep the trailing slash, including the one implied by a final dot
+	// segment ("/a/b/.." is "/a/")
+	if (out.empty() || path.back() == '/' ||
+	    is_dot_segment(path, path.rfind('/') + 1)) {
+		out.push_back('/');
+	}
+
+	return true;
+}
+
+void iti::http::Uri::reset() {
+	raw.clear();
+	normalized.clear();
+	protocolPart   = Part{};
+	hostPart       = Part{};
+	portPart       = Part{};
+	pathPart       = Part{};
+	queryPart      = Part{};
+	portNumber     = 0;
+	pathNormalized = false;
+	queryParsed    = false;
+	params.reset();
+}
+
+#endif // ITI_LIB_HTTP_URI_CPP
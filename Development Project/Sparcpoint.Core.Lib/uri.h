@@ -1,94 +1,254 @@
 #ifndef ITI_LIB_HTTP_URI_H
 #define ITI_LIB_HTTP_URI_H
 
-#include <algorithm>
 #include <charconv>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
-
-#include "StrUtils.h"
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace iti {
 namespace http {
 
+// percent_decode appends `in` to `out`, decoding "%XX" escapes, and '+' to a
+// space when `plusAsSpace` is set. Malformed escapes are kept as they are.
+void percent_decode(std::string_view in, std::pmr::string &out,
+                    bool plusAsSpace = false);
+
+// Query holds the parameters of a query string, percent-decoded.
+//
+// Values that don't need decoding are views into the query string; the
+// others are decoded once, into a buffer owned by the Query.
+//
+//	long long limit = req.url.query().get<long long>("limit", 20);
+//	std::string_view category = req.url.query().get("category");
+class Query {
+  public:
+	explicit Query(
+	    std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+	    : params(mr), decoded(mr) {}
+
+	// parse parses `rawQuery` (without the leading '?'), which must outlive
+	// the Query.
+	void parse(std::string_view rawQuery);
+
+	// get returns the first value of `key`, or an empty view.
+	std::string_view get(std::string_view key) const;
+
+	// get returns the first value of `key` converted to `T` (an arithmetic
+	// type, `bool`, `std::string` or `std::string_view`), or `fallback` if
+	// there is none or it doesn't convert.
+	template <class T> T get(std::string_view key, T fallback = T{}) const {
+		T value{};
+		return try_get(key, value) ? value : fallback;
+	}
+
+	// try_get converts the first value of `key` to `T` (see `get()`).
+	template <class T> bool try_get(std::string_view key, T &value) const;
+
+	// get_all returns all the values of `key`.
+	std::vector<std::string_view> get_all(std::string_view key) const;
+
+	bool has(std::string_view key) const { return find(key) != nullptr; }
+
+	size_t size() const { return params.size(); }
+
+	void reset() {
+		raw = std::string_view();
+		params.clear();
+		decoded.clear();
+	}
+
+  private:
+	// Part is a key or a value: a span of the query string, or of `decoded`.
+	struct Part {
+		uint32_t pos   = 0;
+		uint32_t len   = 0;
+		bool isDecoded = false;
+	};
+
+	struct Param {
+		Part key;
+		Part value;
+	};
+
+	std::string_view view(const Part &p) const {
+		return (p.isDecoded ? std::string_view(decoded) : raw)
+		    .substr(p.pos, p.len);
+	}
+
+	// make_part returns the part for `s`, a span of the query string,
+	// decoding it if needed.
+	Part make_part(std::string_view s);
+
+	const Param *find(std::string_view key) const;
+
+	std::string_view raw;
+	std::pmr::vector<Param> params;
+	std::pmr::string decoded;
+};
+
+// Uri is a parsed request URI.
+//
+// The URI is copied once; its parts are views into that copy. The query
+// string is only split into parameters the first time `query()` is called.
 class Uri {
   public:
-	std::string queryString, path, protocol, host, rawPort;
-	long port{};
+	// The URI is copied into `mr`; a request URL lives in the request arena
+	// (see "arena.h").
+	explicit Uri(
+	    std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+	    : raw(mr), normalized(mr), params(mr) {}
 
-	static Uri parse(const std::string &rawUri) {
+	static Uri parse(std::string_view rawUri) {
 		Uri result;
+		parse(rawUri, result);
+		return result;
+	}
 
-		if (rawUri.empty()) {
-			return result;
-		}
+	// parse parses `rawUri` into `result`, reusing its buffers.
+	static void parse(std::string_view rawUri, Uri &result);
 
-		auto uriEnd = rawUri.end();
-
-		// get query start
-		auto queryStart = std::find(rawUri.begin(), uriEnd, '?');
-
-		// protocol
-		auto protocolStart = rawUri.begin();
-		auto protocolEnd   = std::find(protocolStart, uriEnd, ':');
-
-		if (protocolEnd != uriEnd) {
-			std::string prot = &*(protocolEnd);
-			if ((prot.length() > 3) && (prot.substr(0, 3) == "://")) {
-				result.protocol = std::string(protocolStart, protocolEnd);
-				protocolEnd += 3; // ://
-			} else {
-				protocolEnd = rawUri.begin(); // no protocol
-			}
-		} else {
-			protocolEnd = rawUri.begin(); // no protocol
-		}
-		// host
-		auto hostStart = protocolEnd;
-		auto pathStart = std::find(hostStart, uriEnd, '/'); // get pathStart
-
-		auto hostEnd = std::find(protocolEnd,
-		                         (pathStart != uriEnd) ? pathStart : queryStart,
-		                         ':'); // check for port
-
-		result.host = std::string(hostStart, hostEnd);
-
-		// port
-		if ((hostEnd != uriEnd) && ((&*(hostEnd))[0] == ':')) {
-			// we have a port
-			hostEnd++;
-			auto portEnd   = (pathStart != uriEnd) ? pathStart : queryStart;
-			result.rawPort = std::string(hostEnd, portEnd);
-			const auto res = std::from_chars(
-			    result.rawPort.data(),
-			    result.rawPort.data() + result.rawPort.size(), result.port);
-
-			if (res.ec != std::errc()) {
-				result.port = 0;
-			}
-		}
+	// normalize_path removes the dot segments ("/./", "/../") and duplicate
+	// slashes from `path`, writing the result to `out`. It returns false,
+	// leaving `out` alone, if `path` is already normalized.
+	static bool normalize_path(std::string_view path, std::pmr::string &out);
+
+	std::string_view protocol() const { return view(protocolPart); }
+	std::string_view host() const { return view(hostPart); }
+	std::string_view raw_port() const { return view(portPart); }
+
+	// port is the port of the URI, or the default port of its protocol.
+	long port() const { return portNumber; }
+
+	// path is the normalized path (see `normalize_path()`).
+	std::string_view path() const {
+		return pathNormalized ? std::string_view(normalized) : raw_path();
+	}
 
-		if (result.port == 0) {
-			if (strutils::iequals(result.protocol, "http")) {
-				result.port = 80;
-			} else if (strutils::iequals(result.protocol, "https")) {
-				result.port = 443;
-			}
+	// raw_path is the path as it was received.
+	std::string_view raw_path() const { return view(pathPart); }
+
+	// query_string is the query, without the leading '?'.
+	std::string_view query_string() const { return view(queryPart); }
+
+	// query returns the query parameters, parsing them on first use.
+	const Query &query() const {
+		if (!queryParsed) {
+			params.parse(query_string());
+			queryParsed = true;
 		}
+		return params;
+	}
+
+	// reset clears the Uri, keeping the capacity of its buffers.
+	void reset();
+
+	Uri(const Uri &other) : raw(other.raw), normalized(other.normalized) {
+		copy_parts(other);
+	}
 
-		// path
-		if (pathStart != uriEnd) {
-			result.path = std::string(pathStart, queryStart);
+	Uri &operator=(const Uri &other) {
+		if (this != &other) {
+			raw        = other.raw;
+			normalized = other.normalized;
+			copy_parts(other);
 		}
+		return *this;
+	}
+
+	Uri(Uri &&other) noexcept
+	    : raw(std::move(other.raw)), normalized(std::move(other.normalized)),
+	      params(std::move(other.params)) {
+		copy_parts(other);
+	}
 
-		// query
-		if (queryStart != uriEnd) {
-			result.queryString = std::string(queryStart, rawUri.end());
+	Uri &operator=(Uri &&other) noexcept {
+		if (this != &other) {
+			raw        = std::move(other.raw);
+			normalized = std::move(other.normalized);
+			params     = std::move(other.params);
+			copy_parts(other);
 		}
+		return *this;
+	}
 
-		return result;
+  private:
+	struct Part {
+		uint32_t pos = 0;
+		uint32_t len = 0;
+	};
+
+	std::string_view view(const Part &p) const {
+		return std::string_view(raw).substr(p.pos, p.len);
 	}
+
+	// copy_parts copies everything but the buffers; the query is parsed
+	// again when needed, as it refers to the query string of `other`.
+	void copy_parts(const Uri &other) {
+		protocolPart   = other.protocolPart;
+		hostPart       = other.hostPart;
+		portPart       = other.portPart;
+		pathPart       = other.pathPart;
+		queryPart      = other.queryPart;
+		portNumber     = other.portNumber;
+		pathNormalized = other.pathNormalized;
+		queryParsed    = false;
+		params.reset();
+	}
+
+	std::pmr::string raw;
+	std::pmr::string normalized;
+
+	Part protocolPart, hostPart, portPart, pathPart, queryPart;
+	long portNumber     = 0;
+	bool pathNormalized = false;
+
+	mutable bool queryParsed = false;
+	mutable Query params;
 };
 
+template <class T>
+bool Query::try_get(std::string_view key, T &value) const {
+	const Param *p = find(key);
+	if (p == nullptr) {
+		return false;
+	}
+
+	std::string_view v = view(p->value);
+
+	if constexpr (std::is_same_v<T, std::string_view>) {
+		value = v;
+		return true;
+	} else if constexpr (std::is_same_v<T, std::string>) {
+		value.assign(v.data(), v.size());
+		return true;
+	} else if constexpr (std::is_same_v<T, bool>) {
+		if (v == "1" || v == "true") {
+			value = true;
+			return true;
+		}
+		if (v == "0" || v == "false") {
+			value = false;
+			return true;
+		}
+		return false;
+	} else {
+		static_assert(std::is_arithmetic_v<T>,
+		              "Query::try_get: unsupported value type");
+
+		T parsed{};
+		auto res = std::from_chars(v.data(), v.data() + v.size(), parsed);
+		if (res.ec != std::errc() || res.ptr != v.data() + v.size()) {
+			return false;
+		}
+		value = parsed;
+		return true;
+	}
+}
+
 } // namespace http
 } // namespace iti
 
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Building blocks of the in-memory product store: append-only structures
+// that any number of readers use without locking while a single writer
+// appends to them.
+namespace iti {
+namespace columns {
+
+// floor_log2 returns the index of the highest bit set in `v`, not 0.
+inline unsigned floor_log2(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return unsigned(i);
+#else
+    return 63u - unsigned(__builtin_clzll(v));
+#endif
+}
+
+// Column is an append-only array. Its elements live in chunks that never
+// move, each twice the size of the one before it: a column of a few elements
+// is a few hundred bytes, a large one is a handful of allocations, and an
+// element is found with one bit scan.
+//
+// An element is visible to readers once `push_back()` returns; readers must
+// not index past `size()`.
+template <class T, unsigned FirstChunkBits = 4> class Column {
+  public:
+    Column() = default;
+    Column(const Column &) = delete;
+    Column &operator=(const Column &) = delete;
+    ~Column() {
+        for (auto *chunk : chunks) {
+            delete[] chunk;
+        }
+    }
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+    const T &operator[](size_t i) const {
+        size_t k = chunk_of(i);
+        return chunks[k][i - chunk_begin(k)];
+    }
+
+    // at returns an element, for the writer to update it in place.
+    T &at(size_t i) {
+        size_t k = chunk_of(i);
+        return chunks[k][i - chunk_begin(k)];
+    }
+
+    // push_back appends `v`: writer only.
+    void push_back(T v) {
+        size_t i = count.load(std::memory_order_relaxed);
+        slot(i)  = std::move(v);
+        count.store(i + 1, std::memory_order_release);
+    }
+
+    // emplace_back appends a value-initialized element: writer only.
+    void emplace_back() {
+        size_t i = count.load(std::memory_order_relaxed);
+        slot(i);
+        count.store(i + 1, std::memory_order_release);
+    }
+
+  private:
+    T &slot(size_t i) {
+        size_t k = chunk_of(i);
+        if (chunks[k] == nullptr) {
+            chunks[k] = new T[chunk_begin(k + 1) - chunk_begin(k)]();
+        }
+        return chunks[k][i - chunk_begin(k)];
+    }
+
+    static size_t chunk_of(size_t i) {
+        return floor_log2((i >> FirstChunkBits) + 1);
+    }
+    static size_t chunk_begin(size_t k) {
+        return ((size_t(1) << k) - 1) << FirstChunkBits;
+    }
+
+    // chunk k holds the elements [chunk_begin(k), chunk_begin(k + 1))
+    T *chunks[64 - FirstChunkBits] = {};
+    std::atomic<size_t> count{0};
+};
+
+// StringArena copies strings into large blocks that are never freed nor
+// moved before the arena is: the views it returns stay valid as long as it
+// does. Writer only; the views can be read from any thread.
+class StringArena {
+  public:
+    static constexpr size_t blockSize = 64 * 1024;
+
+    StringArena() = default;
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+
+    std::string_view copy(std::string_view s) {
+        if (s.empty()) {
+            return std::string_view();
+        }
+        if (s.size() > blockSize / 4) {
+            // large strings get a block of their own, so the current one
+            // isn't wasted
+            large.emplace_back(new char[s.size()]);
+            std::memcpy(large.back().get(), s.data(), s.size());
+            return std::string_view(large.back().get(), s.size());
+        }
+        if (s.size() > blockSize - used) {
+            blocks.emplace_back(new char[blockSize]);
+            used = 0;
+        }
+
+        char *p = blocks.back().get() + used;
+        std::memcpy(p, s.data(), s.size());
+        used += s.size();
+        return std::string_view(p, s.size());
+    }
+
+  private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::unique_ptr<char[]>> large;
+    size_t used = blockSize; // of the last block
+};
+
+// NameIndex numbers names densely (0, 1, ...) and finds them back with an
+// open addressing hash table. The table is replaced by one twice its size
+// when half full; the old ones are kept until the index is destroyed, as
+// readers may still be probing them.
+class NameIndex {
+  public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    NameIndex() { current.store(grow(), std::memory_order_release); }
+    NameIndex(const NameIndex &) = delete;
+    NameIndex &operator=(const NameIndex &) = delete;
+
+    size_t size() const { return names.size(); }
+    std::string_view name(uint32_t id) const { return names[id]; }
+
+    // find returns the id of `name`, or npos.
+    uint32_t find(std::string_view name) const {
+        const Table *t = current.load(std::memory_order_acquire);
+        for (size_t i = hash(name) & t->mask;; i = (i + 1) & t->mask) {
+            uint32_t slot = t->slots[i].load(std::memory_order_acquire);
+            if (slot == 0) {
+                return npos;
+            }
+            if (names[slot - 1] == name) {
+                return slot - 1;
+            }
+        }
+    }
+
+    // add numbers `name`, which isn't in the index yet and must outlive it
+    // (see `StringArena`): writer only.
+    uint32_t add(std::string_view name) {
+        auto id = uint32_t(names.size());
+        names.push_back(name);
+
+        Table *t = current.load(std::memory_order_relaxed);
+        if ((size_t(id) + 1) * 2 > t->mask + 1) {
+            t = grow();
+            current.store(t, std::memory_order_release);
+        } else {
+            place(*t, id);
+        }
+        return id;
+    }
+
+  private:
+    // Table holds id + 1 in each slot, 0 when empty.
+    struct Table {
+        size_t mask;
+        std::unique_ptr<std::atomic<uint32_t>[]> slots;
+    };
+
+    static size_t hash(std::string_view name) {
+        return std::hash<std::string_view>()(name);
+    }
+
+    void place(Table &t, uint32_t id) {
+        size_t i = hash(names[id]) & t.mask;
+        while (t.slots[i].load(std::memory_order_relaxed) != 0) {
+            i = (i + 1) & t.mask;
+        }
+        t.slots[i].store(id + 1, std::memory_order_release);
+    }
+
+    // grow returns a new table, twice the size of the last one, holding
+    // all the names.
+    Table *grow() {
+        size_t capacity = tables.empty() ? 16 : (tables.back()->mask + 1) * 2;
+        tables.emplace_back(new Table{
+            capacity - 1, std::make_unique<std::atomic<uint32_t>[]>(capacity)});
+        for (uint32_t id = 0; id < names.size(); id++) {
+            place(*tables.back(), id);
+        }
+        return tables.back().get();
+    }
+
+    Column<std::string_view> names;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::atomic<Table *> current{nullptr};
+};
+
+} // namespace columns
+} // namespace iti
@@ -0,0 +1,196 @@
+#include "ConnectionPool.h"
+
+#include <algorithm>
+
+namespace iti {
+namespace db {
+ConnectionPool::Lease &
+ConnectionPool::Lease::operator=(Lease &&other) noexcept {
+    if (this != &other) {
+        release();
+        pool         = other.pool;
+        conn         = std::move(other.conn);
+        broken       = other.broken;
+        other.pool   = nullptr;
+        other.broken = false;
+    }
+    return *this;
+}
+
+void ConnectionPool::Lease::release() {
+    if (pool != nullptr && conn != nullptr) {
+        pool->release(std::move(conn), broken);
+    }
+    pool   = nullptr;
+    broken = false;
+}
+
+ConnectionPool::ConnectionPool(Connector connect, Options options)
+    : connect(std::move(connect)), opts(options) {}
+
+ConnectionPool::~ConnectionPool() = default;
+
+ConnectionPool::Lease ConnectionPool::checkout() {
+    const auto start    = clock::now();
+    const auto deadline = start + opts.checkoutTimeout;
+    bool waited         = false;
+
+    // a served connection may turn out to be dead: then try again
+    for (;;) {
+        // connections closed by this iteration, once `mtx` is unlocked
+        Doomed doomed;
+        Idle got;
+        bool open = false;
+        {
+            std::unique_lock<std::mutex> l(mtx);
+            evict(clock::now(), doomed);
+
+            // don't pass those already waiting
+            if (waiters.empty() && !idle.empty()) {
+                got = take_idle();
+            } else if (waiters.empty() && size < opts.maxSize) {
+                size++;
+                open = true;
+            } else {
+                Waiter w;
+                waiters.push_back(&w);
+                waited = true;
+                if (!w.cv.wait_until(l, deadline, [&w] { return w.served; })) {
+                    waiters.erase(
+                        std::find(waiters.begin(), waiters.end(), &w));
+                    counters.timeouts++;
+                    return Lease();
+                }
+                got  = std::move(w.idle);
+                open = got.conn == nullptr;
+            }
+        }
+
+        if (open) {
+            got.conn = connect();
+            if (got.conn == nullptr) {
+                std::lock_guard<std::mutex> l(mtx);
+                counters.openFailures++;
+                drop();
+                return Lease();
+            }
+        } else if (clock::now() - got.since >= opts.validateAfter &&
+                   !got.conn->alive()) {
+            std::lock_guard<std::mutex> l(mtx);
+            counters.deadOnCheckout++;
+            drop();
+            doomed.push_back(std::move(got.conn));
+            continue;
+        }
+
+        const auto ns = uint64_t(std::chrono::duration_cast<
+                                     std::chrono::nanoseconds>(clock::now() -
+                                                               start)
+                                     .count());
+        std::lock_guard<std::mutex> l(mtx);
+        counters.checkouts++;
+        counters.opened += open ? 1 : 0;
+        counters.waits += waited ? 1 : 0;
+        counters.waitNsTotal += ns;
+        counters.waitNsMax = std::max(counters.waitNsMax, ns);
+        return Lease(this, std::move(got.conn));
+    }
+}
+
+bool ConnectionPool::fill() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> l(mtx);
+            if (size >= opts.minSize) {
+                return true;
+            }
+            size++;
+        }
+
+        Idle opened{connect(), clock::now()};
+        std::lock_guard<std::mutex> l(mtx);
+        if (opened.conn == nullptr) {
+            counters.openFailures++;
+            drop();
+            return false;
+        }
+        counters.opened++;
+        if (!hand_over(opened)) {
+            idle.push_back(std::move(opened));
+        }
+    }
+}
+
+void ConnectionPool::evict() {
+    Doomed doomed;
+    std::lock_guard<std::mutex> l(mtx);
+    evict(clock::now(), doomed);
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    std::lock_guard<std::mutex> l(mtx);
+    Stats s   = counters;
+    s.size    = size;
+    s.inUse   = size - idle.size();
+    s.waiting = waiters.size();
+    s.maxSize = opts.maxSize;
+    return s;
+}
+
+void ConnectionPool::release(std::unique_ptr<IConnection> conn,
+                             bool broken) {
+    Doomed doomed;
+    std::lock_guard<std::mutex> l(mtx);
+    if (broken) {
+        doomed.push_back(std::move(conn));
+        drop();
+        return;
+    }
+
+    Idle returned{std::move(conn), clock::now()};
+    if (!hand_over(returned)) {
+        idle.push_back(std::move(returned));
+    }
+}
+
+ConnectionPool::Idle ConnectionPool::take_idle() {
+    // the warmest one
+    Idle taken = std::move(idle.back());
+    idle.pop_back();
+    return taken;
+}
+
+void ConnectionPool::evict(clock::time_point now, Doomed &doomed) {
+    // `idle` is in the order the connections were returned
+    while (!idle.empty() && size > opts.minSize &&
+           now - idle.front().since >= opts.idleTimeout) {
+        doomed.push_back(std::move(idle.front().conn));
+        idle.erase(idle.begin());
+        size--;
+        counters.evicted++;
+    }
+}
+
+bool ConnectionPool::hand_over(Idle &i) {
+    if (waiters.empty()) {
+        return false;
+    }
+
+    Waiter *w = waiters.front();
+    waiters.pop_front();
+    w->idle   = std::move(i);
+    w->served = true;
+    w->cv.notify_one();
+    return true;
+}
+
+void ConnectionPool::drop() {
+    size--;
+    if (!waiters.empty()) {
+        size++;
+        Idle none;
+        hand_over(none);
+    }
+}
+} // namespace db
+} // namespace iti
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Database connections, and the pool the SQL backend draws them from.
+namespace iti {
+namespace db {
+
+// IConnection is a connection to the database, used by one thread at a time.
+class IConnection {
+  public:
+    virtual ~IConnection() = default;
+
+    // alive tells whether the connection is still usable. The pool calls it
+    // on checkout, so it should be cheap.
+    virtual bool alive() = 0;
+};
+
+// Connector opens a connection, or returns nullptr if it couldn't.
+using Connector = std::function<std::unique_ptr<IConnection>()>;
+
+// ConnectionPool keeps connections open between requests:
+//  - it opens them on demand, up to `maxSize`, and closes those idle for
+//    longer than `idleTimeout`, down to `minSize`;
+//  - a connection idle for longer than `validateAfter` is checked with
+//    `alive()` before it is handed out, and replaced if it's dead;
+//  - when all are in use, callers wait in turn (first come, first served)
+//    for one to be returned, up to `checkoutTimeout`;
+//  - the most recently returned connection is handed out first: it is the
+//    warmest, and the others stay idle long enough to be closed.
+class ConnectionPool {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    struct Options {
+        size_t minSize = 1;
+        size_t maxSize = 8;
+        std::chrono::milliseconds idleTimeout{60000};
+        std::chrono::milliseconds checkoutTimeout{5000};
+        std::chrono::milliseconds validateAfter{1000};
+    };
+
+    // Stats are counters since the pool was created, and the current state.
+    struct Stats {
+        size_t size    = 0; // open connections, and being opened
+        size_t inUse   = 0;
+        size_t waiting = 0;
+        size_t maxSize = 0;
+
+        uint64_t checkouts      = 0;
+        uint64_t timeouts       = 0; // checkouts that got no connection
+        uint64_t waits          = 0; // checkouts that waited in line
+        uint64_t waitNsTotal    = 0; // time spent in checkout()
+        uint64_t waitNsMax      = 0;
+        uint64_t opened         = 0;
+        uint64_t openFailures   = 0;
+        uint64_t deadOnCheckout = 0;
+        uint64_t evicted        = 0;
+    };
+
+    // Lease is a connection checked out of the pool, returned to it when
+    // the lease is destroyed. An empty lease (false) means no connection
+    // could be had.
+    class Lease {
+      public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept { *this = std::move(other); }
+        Lease &operator=(Lease &&other) noexcept;
+        ~Lease() { release(); }
+
+        explicit operator bool() const { return conn != nullptr; }
+        IConnection &operator*() const { return *conn; }
+        IConnection *operator->() const { return conn.get(); }
+        // as returns the connection as the type the connector opens.
+        template <class T> T &as() const { return static_cast<T &>(*conn); }
+
+        // discard closes the connection when it is returned, rather than
+        // pooling it: a caller that finds it broken calls it.
+        void discard() { broken = true; }
+
+      private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *pool, std::unique_ptr<IConnection> conn)
+            : pool(pool), conn(std::move(conn)) {}
+        void release();
+
+        ConnectionPool *pool = nullptr;
+        std::unique_ptr<IConnection> conn;
+        bool broken = false;
+    };
+
+    ConnectionPool(Connector connect, Options options);
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+    // all the leases must have been returned
+    ~ConnectionPool();
+
+    // checkout returns a connection, or an empty lease if none was returned
+    // to the pool within `checkoutTimeout` or a new one couldn't be opened.
+    Lease checkout();
+
+    // fill opens connections up to `minSize`, and returns false if one
+    // couldn't be opened.
+    bool fill();
+
+    // evict closes the connections idle for longer than `idleTimeout`, down
+    // to `minSize`. `checkout()` does it as well.
+    void evict();
+
+    Stats stats() const;
+    const Options &options() const { return opts; }
+
+  private:
+    // Idle is a connection in the pool.
+    struct Idle {
+        std::unique_ptr<IConnection> conn;
+        clock::time_point since;
+    };
+
+    // Waiter is a checkout waiting in line. It is served either a
+    // connection, or an empty one: the right to open a connection.
+    struct Waiter {
+        std::condition_variable cv;
+        bool served = false;
+        Idle idle;
+    };
+
+    using Doomed = std::vector<std::unique_ptr<IConnection>>;
+
+    void release(std::unique_ptr<IConnection> conn, bool broken);
+    // the functions below are called under `mtx`
+    Idle take_idle();
+    void evict(clock::time_point now, Doomed &doomed);
+    // hand_over gives `idle` to the first waiter, or returns false if
+    // there's none.
+    bool hand_over(Idle &idle);
+    // drop forgets a connection that was closed or couldn't be opened: a
+    // waiter may open another.
+    void drop();
+
+    Connector connect;
+    const Options opts;
+
+    mutable std::mutex mtx;
+    std::vector<Idle> idle; // the most recently returned last
+    std::deque<Waiter *> waiters;
+    size_t size = 0;
+    Stats counters;
+};
+
+} // namespace db
+} // namespace iti
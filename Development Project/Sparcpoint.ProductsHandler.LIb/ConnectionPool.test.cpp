@@ -0,0 +1,283 @@
+// ConnectionPool tests (see "test.h"), with fake connections; also meant to
+// be run under ThreadSanitizer:
+//
+//	./run.sh ConnectionPool.test.cpp
+//	CXXFLAGS="-O1 -fsanitize=thread" ./run.sh ConnectionPool.test.cpp
+
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ConnectionPool.h"
+
+using iti::db::ConnectionPool;
+using iti::db::IConnection;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Fakes counts the connections `fake_connector()` opened and closed, and
+// tells whether opening one fails.
+struct Fakes {
+    std::atomic<int> opened{0};
+    std::atomic<int> closed{0};
+    std::atomic<bool> failOpen{false};
+};
+
+class FakeConnection : public IConnection {
+  public:
+    explicit FakeConnection(Fakes &fakes) : fakes(fakes), id(++fakes.opened) {}
+    ~FakeConnection() override { fakes.closed++; }
+
+    bool alive() override { return isAlive; }
+
+    Fakes &fakes;
+    const int id;
+    std::atomic<bool> isAlive{true};
+    // set while leased, to catch a connection handed out twice
+    std::atomic<bool> leased{false};
+};
+
+iti::db::Connector fake_connector(Fakes &fakes) {
+    return [&fakes]() -> std::unique_ptr<IConnection> {
+        if (fakes.failOpen) {
+            return nullptr;
+        }
+        return std::make_unique<FakeConnection>(fakes);
+    };
+}
+
+ConnectionPool::Options options(size_t minSize, size_t maxSize) {
+    ConnectionPool::Options o;
+    o.minSize = minSize;
+    o.maxSize = maxSize;
+    return o;
+}
+
+// wait_for waits until `cond()` holds, for up to a second.
+template <class F> bool wait_for(F &&cond) {
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+// reuse: connections are opened on demand, and the one returned last is
+// the one handed out next
+void reuse() {
+    Fakes fakes;
+    ConnectionPool pool(fake_connector(fakes), options(0, 4));
+
+    int first = 0;
+    {
+        auto a = pool.checkout();
+        auto b = pool.checkout();
+        ITI_CHECK(a && b);
+        first = a.as<FakeConnection>().id;
+        b     = ConnectionPool::Lease();
+    }
+    ITI_CHECK(fakes.opened == 2);
+    {
+        auto a = pool.checkout();
+        ITI_CHECK(a && a.as<FakeConnection>().id == first);
+    }
+
+    auto s = pool.stats();
+    ITI_CHECK(s.size == 2 && s.inUse == 0 && s.opened == 2);
+    ITI_CHECK(s.checkouts == 3);
+}
+
+// fill: connections are opened up to minSize ahead of time
+void fill() {
+    Fakes fakes;
+    ConnectionPool pool(fake_connector(fakes), options(3, 4));
+    ITI_CHECK(pool.fill());
+    ITI_CHECK(fakes.opened == 3 && pool.stats().size == 3);
+
+    Fakes failing;
+    failing.failOpen = true;
+    ConnectionPool broken(fake_connector(failing), options(1, 1));
+    ITI_CHECK(!broken.fill());
+    ITI_CHECK(broken.stats().size == 0 && broken.stats().openFailures == 1);
+}
+
+// timeouts: past maxSize, a checkout waits up to checkoutTimeout, then
+// gets nothing
+void timeouts() {
+    Fakes fakes;
+    auto o            = options(0, 2);
+    o.checkoutTimeout = 50ms;
+    ConnectionPool pool(fake_connector(fakes), o);
+
+    auto a = pool.checkout();
+    auto b = pool.checkout();
+    const auto start = std::chrono::steady_clock::now();
+    auto c           = pool.checkout();
+    ITI_CHECK(!c);
+    ITI_CHECK(std::chrono::steady_clock::now() - start >= 50ms);
+
+    auto s = pool.stats();
+    ITI_CHECK(s.timeouts == 1 && s.waits == 0 && s.waiting == 0);
+    ITI_CHECK(fakes.opened == 2);
+
+    // a connection that couldn't be opened is no connection either
+    Fakes failing;
+    failing.failOpen = true;
+    ConnectionPool broken(fake_connector(failing), options(0, 1));
+    ITI_CHECK(!broken.checkout());
+    ITI_CHECK(broken.stats().openFailures == 1 && broken.stats().size == 0);
+}
+
+// fairness: those waiting are served first come, first served
+void fairness() {
+    Fakes fakes;
+    ConnectionPool pool(fake_connector(fakes), options(0, 1));
+    auto held = pool.checkout();
+
+    constexpr int numWaiters = 5;
+    std::mutex mtx;
+    std::vector<int> served;
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < numWaiters; i++) {
+        waiters.emplace_back([&, i] {
+            auto lease = pool.checkout();
+            std::lock_guard<std::mutex> l(mtx);
+            served.push_back(lease ? i : -1);
+        });
+        // queue them one after the other
+        ITI_CHECK(wait_for(
+            [&] { return pool.stats().waiting == size_t(i) + 1; }));
+    }
+
+    held = ConnectionPool::Lease();
+    for (auto &t : waiters) {
+        t.join();
+    }
+    ITI_CHECK(served == (std::vector<int>{0, 1, 2, 3, 4}));
+    ITI_CHECK(fakes.opened == 1 && pool.stats().waits == numWaiters);
+}
+
+// dead connections: a connection idle for longer than validateAfter is
+// checked, and replaced if it's dead; one discarded is closed
+void dead_connections() {
+    Fakes fakes;
+    auto o          = options(0, 2);
+    o.validateAfter = 0ms;
+    ConnectionPool pool(fake_connector(fakes), o);
+
+    {
+        auto a = pool.checkout();
+        a.as<FakeConnection>().isAlive = false;
+    }
+    {
+        auto a = pool.checkout();
+        ITI_CHECK(a && a.as<FakeConnection>().id == 2);
+    }
+    auto s = pool.stats();
+    ITI_CHECK(s.deadOnCheckout == 1 && s.opened == 2 && s.size == 1);
+    ITI_CHECK(fakes.closed == 1);
+
+    {
+        auto a = pool.checkout();
+        a.discard();
+    }
+    ITI_CHECK(fakes.closed == 2 && pool.stats().size == 0);
+
+    // a discarded connection lets a waiter open another
+    auto held = pool.checkout();
+    auto other = pool.checkout();
+    int got = 0;
+    std::thread waiter([&] {
+        auto lease = pool.checkout();
+        got        = lease ? lease.as<FakeConnection>().id : -1;
+    });
+    ITI_CHECK(wait_for([&] { return pool.stats().waiting == 1; }));
+    held.discard();
+    held = ConnectionPool::Lease();
+    waiter.join();
+    ITI_CHECK(got == 5);
+}
+
+// eviction: connections idle for longer than idleTimeout are closed, down
+// to minSize
+void eviction() {
+    Fakes fakes;
+    auto o        = options(1, 4);
+    o.idleTimeout = 20ms;
+    ConnectionPool pool(fake_connector(fakes), o);
+    {
+        auto a = pool.checkout();
+        auto b = pool.checkout();
+        auto c = pool.checkout();
+    }
+    ITI_CHECK(pool.stats().size == 3);
+
+    pool.evict();
+    ITI_CHECK(pool.stats().size == 3);
+    std::this_thread::sleep_for(30ms);
+    pool.evict();
+    auto s = pool.stats();
+    ITI_CHECK(s.size == 1 && s.evicted == 2 && fakes.closed == 2);
+}
+
+// concurrency: many threads share a few connections, never the same one at
+// the same time, and none goes without
+void concurrency() {
+    Fakes fakes;
+    auto o            = options(0, 4);
+    o.checkoutTimeout = 10s;
+    ConnectionPool pool(fake_connector(fakes), o);
+
+    constexpr int numThreads   = 16;
+    constexpr int numCheckouts = 2000;
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < numCheckouts; i++) {
+                auto lease = pool.checkout();
+                if (!lease) {
+                    errors++;
+                    continue;
+                }
+                auto &conn = lease.as<FakeConnection>();
+                if (conn.leased.exchange(true)) {
+                    errors++;
+                }
+                std::this_thread::yield();
+                conn.leased = false;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    auto s = pool.stats();
+    ITI_CHECK(errors == 0);
+    ITI_CHECK(s.checkouts == uint64_t(numThreads) * numCheckouts);
+    ITI_CHECK(s.timeouts == 0 && s.inUse == 0 && s.waiting == 0);
+    ITI_CHECK(s.size <= 4 && fakes.opened <= 4);
+}
+
+} // namespace
+
+int main() {
+    reuse();
+    fill();
+    timeouts();
+    fairness();
+    dead_connections();
+    eviction();
+    concurrency();
+    return iti::test::report("ConnectionPool");
+}
@@ -11,10 +11,11 @@ class ILogger;
 } // namespace iti
 
 namespace iti {
-enum class ProductHandlerType { MSSQL };
+enum class ProductHandlerType { MSSQL, InMemory };
 using ILogger = iti::logger::ILogger;
 
 class IProductHandler;
+class IProductHandlerV2;
 
 // Class factory
 class ProductHandlerFactory {
@@ -25,6 +26,8 @@ class ProductHandlerFactory {
     ProductHandlerFactory& operator=(const ProductHandlerFactory &) = delete;
 
     IProductHandler *Create(ProductHandlerType type);
+    // CreateV2 creates a handler with the UTF-8 API, see "IProductHandlerV2.h"
+    IProductHandlerV2 *CreateV2(ProductHandlerType type);
   private:
     ILogger *logger;
 };
@@ -46,6 +49,33 @@ class IProductHandler {
     using StrList = std::vector<std::wstring>;
     using Handle = void*;
 
+    // ProductInput is a product to add, see AddProductDefinitions()
+    struct ProductInput {
+        std::wstring name;
+        std::wstring gen_details;
+        StrList categories;
+        StrList metadata;
+    };
+    using ProductBatch = std::vector<ProductInput>;
+
+    // InventoryChange adds `delta` units to the inventory of product `id`,
+    // or removes -delta (at most what is present); 0 just reports it.
+    struct InventoryChange {
+        uint64_t id   = 0;
+        int64_t delta = 0;
+    };
+    // InventoryResult is what came of a change: the units added or
+    // removed, and those present after it.
+    struct InventoryResult {
+        ErrorCode error     = ErrorCode::SUCCESS;
+        uint64_t numChanged = 0;
+        uint64_t numPresent = 0;
+    };
+    enum class Atomicity {
+        AllOrNothing, // a change that fails cancels them all
+        BestEffort    // the changes that can be made are
+    };
+
     // configJson params are implementation-specific
     /* For SQL Server config JSON format:
      * {"ConnStr" : "some-ODBC-conn-str"}
@@ -58,6 +88,13 @@ class IProductHandler {
                                            const StrList &categories,
                                            const StrList &metadata,
                                            uint64_t& o_id) = 0;
+    /* AddProductDefinitions adds a batch of products, each as
+     * AddProductDefinition() would, in one transaction: either all are
+     * added, or none is (if one is invalid, say). o_ids are their ids, in
+     * the order of the batch.
+     */
+    virtual ErrorCode AddProductDefinitions(const ProductBatch &batch,
+                                            std::vector<uint64_t> &o_ids) = 0;
     /* GetProductDefinitionById Output JSON format:
     * {
     *	"id" : <string>,
@@ -102,6 +139,20 @@ class IProductHandler {
                                              uint64_t &o_numPresent)      = 0;
     virtual ErrorCode ReportProductInventory(uint64_t id,
                                              uint64_t& o_numPresent) const = 0;
+    /* AdjustProductInventories makes a batch of changes, in order (a
+     * product may be changed more than once), each as
+     * AddProductInventory() or RemoveProductInventory() would, in one
+     * call to the store. o_results has the result of each change.
+     * With Atomicity::AllOrNothing, if a change fails nothing is changed,
+     * and the error of a change that failed is returned (o_results tells
+     * which); the results of the others are SUCCESS with no units changed
+     * or present, as none was applied. With Atomicity::BestEffort, the
+     * changes that fail are left out, and SUCCESS is returned.
+     */
+    virtual ErrorCode
+    AdjustProductInventories(const std::vector<InventoryChange> &changes,
+                             Atomicity atomicity,
+                             std::vector<InventoryResult> &o_results) = 0;
   protected:
     virtual ~IProductHandler() {}
 };
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IProductHandler.h"
+
+namespace iti {
+// ProductDefinition is a product, as views of its text. They point into the
+// memory of the handler, or into `storage`, and are valid as long as both
+// the handler and the struct are, until the struct is filled again.
+struct ProductDefinition {
+    uint64_t id = 0;
+    std::string_view name;
+    std::string_view generalDetails;
+    std::vector<std::string_view> categories;
+    std::vector<std::string_view> metadata;
+
+    // for the handler, if it has to copy the text
+    std::string storage;
+};
+
+// ProductVisitor is called with each product of a listing; the product is
+// only valid during the call.
+using ProductVisitor = std::function<void(const ProductDefinition &)>;
+
+// IProductHandlerV2 is IProductHandler with UTF-8 text, so that callers
+// don't convert anything:
+//  - string inputs are views, which need only live for the call;
+//  - JSON results are appended to a string of the caller, which it can
+//    reuse from call to call.
+// The JSON formats, handles and error codes are those of IProductHandler,
+// see "IProductHandler.h". Invalid UTF-8 is INVALID_INPUT_PARAM.
+//
+// Products can also be read as structs, or visited one by one, so that
+// callers write them in any format without parsing JSON back.
+class IProductHandlerV2 {
+  public:
+    using ErrorCode   = IProductHandler::ErrorCode;
+    using Handle      = IProductHandler::Handle;
+    using StrViewList = std::vector<std::string_view>;
+    using InventoryChange = IProductHandler::InventoryChange;
+    using InventoryResult = IProductHandler::InventoryResult;
+    using Atomicity       = IProductHandler::Atomicity;
+
+    // ProductInput is a product to add, see AddProductDefinitions()
+    struct ProductInput {
+        std::string_view name;
+        std::string_view gen_details;
+        StrViewList categories;
+        StrViewList metadata;
+    };
+    using ProductBatch = std::vector<ProductInput>;
+
+    virtual ErrorCode Init(std::string_view configJson, ILogger *logger) = 0;
+    virtual ErrorCode Shutdown() = 0;
+
+    virtual ErrorCode AddProductDefinition(std::string_view name,
+                                           std::string_view gen_details,
+                                           const StrViewList &categories,
+                                           const StrViewList &metadata,
+                                           uint64_t &o_id) = 0;
+    virtual ErrorCode AddProductDefinitions(const ProductBatch &batch,
+                                            std::vector<uint64_t> &o_ids) = 0;
+    virtual ErrorCode
+    GetProductDefinitionById(uint64_t id,
+                             std::string &o_prodDefJson) const = 0;
+    // o_numItems, if given, is set to the number of products listed: a
+    // page shorter than `numItemsToGet` is the last one.
+    virtual ErrorCode
+    GetProductDefinitions(std::string_view name,
+                          std::string_view gen_details_regex,
+                          const StrViewList &categories,
+                          const StrViewList &metadata, int numItemsToGet,
+                          std::string &o_prodDefJson,
+                          Handle *o_CollectionHandle = nullptr,
+                          int *o_numItems = nullptr) const = 0;
+    virtual ErrorCode
+    GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
+                              std::string &o_prodDefJson,
+                              int *o_numItems = nullptr) const = 0;
+
+    // the same, filling a struct, or visiting the products, instead of
+    // writing JSON. Errors are returned before any product is visited.
+    // An empty visitor skips the products: the listing moves past them
+    // without reading them, as for an offset.
+    virtual ErrorCode
+    GetProductDefinitionById(uint64_t id,
+                             ProductDefinition &o_prodDef) const = 0;
+    virtual ErrorCode
+    GetProductDefinitions(std::string_view name,
+                          std::string_view gen_details_regex,
+                          const StrViewList &categories,
+                          const StrViewList &metadata, int numItemsToGet,
+                          const ProductVisitor &visitor,
+                          Handle *o_CollectionHandle = nullptr) const = 0;
+    virtual ErrorCode
+    GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
+                              const ProductVisitor &visitor) const = 0;
+
+    virtual ErrorCode CloseCollectionHandle(Handle collectionHandle) = 0;
+    virtual ErrorCode AddProductInventory(uint64_t id, uint64_t numToAdd,
+                                          uint64_t &o_numPresent) = 0;
+    virtual ErrorCode RemoveProductInventory(uint64_t id, uint64_t numToRemove,
+                                             uint64_t &o_numRemoved,
+                                             uint64_t &o_numPresent) = 0;
+    virtual ErrorCode ReportProductInventory(uint64_t id,
+                                             uint64_t &o_numPresent) const = 0;
+    virtual ErrorCode
+    AdjustProductInventories(const std::vector<InventoryChange> &changes,
+                             Atomicity atomicity,
+                             std::vector<InventoryResult> &o_results) = 0;
+
+    // ConnectionPoolStats are the counters of the connection pool of a
+    // backend since it was created, and its current state.
+    struct ConnectionPoolStats {
+        size_t size    = 0; // open connections, and being opened
+        size_t inUse   = 0;
+        size_t waiting = 0;
+        size_t maxSize = 0;
+
+        uint64_t checkouts      = 0;
+        uint64_t timeouts       = 0; // checkouts that got no connection
+        uint64_t waits          = 0; // checkouts that waited in line
+        uint64_t waitNsTotal    = 0; // time spent getting a connection
+        uint64_t waitNsMax      = 0;
+        uint64_t opened         = 0;
+        uint64_t openFailures   = 0;
+        uint64_t deadOnCheckout = 0;
+        uint64_t evicted        = 0;
+    };
+
+    // StatementStats are the lookups in the prepared statement caches of
+    // the connections of a SQL backend.
+    struct StatementStats {
+        uint64_t hits      = 0;
+        uint64_t misses    = 0;
+        uint64_t evictions = 0;
+    };
+
+    // PoolStats returns the statistics of the connection pool of the
+    // backend, or nothing if it has none.
+    virtual std::optional<ConnectionPoolStats> PoolStats() const {
+        return std::nullopt;
+    }
+    // StatementCacheStats returns the statistics of the prepared statement
+    // caches of the backend, or nothing if it has none.
+    virtual std::optional<StatementStats> StatementCacheStats() const {
+        return std::nullopt;
+    }
+
+    virtual ~IProductHandlerV2() {}
+};
+} // namespace iti
@@ -0,0 +1,247 @@
+#include "OdbcConnection.h"
+#include "utf.h"
+
+#include <algorithm>
+
+namespace iti {
+namespace db {
+namespace {
+// SQLWCHAR is a UTF-16 unit, whatever the size of wchar_t
+static_assert(sizeof(SQLWCHAR) == sizeof(char16_t), "SQLWCHAR isn't UTF-16");
+
+SQLWCHAR *sqlw(std::u16string &s) {
+    return reinterpret_cast<SQLWCHAR *>(s.data());
+}
+} // namespace
+
+std::string odbc_error(SQLSMALLINT handleType, SQLHANDLE handle) {
+    SQLWCHAR state[SQL_SQLSTATE_SIZE + 1]     = {};
+    SQLWCHAR message[SQL_MAX_MESSAGE_LENGTH] = {};
+    SQLINTEGER native                        = 0;
+    SQLSMALLINT size                         = 0;
+    if (!SQL_SUCCEEDED(SQLGetDiagRecW(handleType, handle, 1, state, &native,
+                                      message, SQL_MAX_MESSAGE_LENGTH,
+                                      &size))) {
+        return "no diagnostic";
+    }
+
+    std::string out;
+    utf::utf16_to_utf8(
+        std::u16string_view(reinterpret_cast<const char16_t *>(state),
+                            SQL_SQLSTATE_SIZE),
+        out);
+    out += ": ";
+    size = std::min<SQLSMALLINT>(size, SQL_MAX_MESSAGE_LENGTH - 1);
+    utf::utf16_to_utf8(
+        std::u16string_view(reinterpret_cast<const char16_t *>(message),
+                            size_t(size)),
+        out);
+    return out;
+}
+
+std::unique_ptr<OdbcEnvironment> OdbcEnvironment::create() {
+    SQLHENV env = SQL_NULL_HANDLE;
+    if (!SQL_SUCCEEDED(
+            SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &env))) {
+        return nullptr;
+    }
+    if (!SQL_SUCCEEDED(SQLSetEnvAttr(env, SQL_ATTR_ODBC_VERSION,
+                                     (SQLPOINTER)SQL_OV_ODBC3, 0))) {
+        SQLFreeHandle(SQL_HANDLE_ENV, env);
+        return nullptr;
+    }
+    return std::unique_ptr<OdbcEnvironment>(new OdbcEnvironment(env));
+}
+
+OdbcEnvironment::~OdbcEnvironment() { SQLFreeHandle(SQL_HANDLE_ENV, env); }
+
+std::unique_ptr<OdbcConnection>
+OdbcConnection::open(const OdbcEnvironment &env, std::string_view connStr,
+                     size_t statementCacheSize, StatementCounters *counters,
+                     std::string *o_error) {
+    std::u16string wideConnStr;
+    if (!utf::utf8_to_utf16(connStr, wideConnStr)) {
+        if (o_error != nullptr) {
+            *o_error = "the connection string isn't valid UTF-8";
+        }
+        return nullptr;
+    }
+
+    SQLHDBC dbc = SQL_NULL_HANDLE;
+    if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_DBC, env.handle(), &dbc))) {
+        if (o_error != nullptr) {
+            *o_error = odbc_error(SQL_HANDLE_ENV, env.handle());
+        }
+        return nullptr;
+    }
+    if (!SQL_SUCCEEDED(SQLDriverConnectW(
+            dbc, nullptr, sqlw(wideConnStr), SQLSMALLINT(wideConnStr.size()),
+            nullptr, 0, nullptr, SQL_DRIVER_NOPROMPT))) {
+        if (o_error != nullptr) {
+            *o_error = odbc_error(SQL_HANDLE_DBC, dbc);
+        }
+        SQLFreeHandle(SQL_HANDLE_DBC, dbc);
+        return nullptr;
+    }
+    return std::unique_ptr<OdbcConnection>(
+        new OdbcConnection(dbc, statementCacheSize, counters));
+}
+
+OdbcConnection::~OdbcConnection() {
+    for (auto &s : statements) {
+        SQLFreeHandle(SQL_HANDLE_STMT, s.stmt);
+    }
+    SQLDisconnect(dbc);
+    SQLFreeHandle(SQL_HANDLE_DBC, dbc);
+}
+
+bool OdbcConnection::alive() {
+    SQLUINTEGER dead = SQL_CD_TRUE;
+    if (SQL_SUCCEEDED(SQLGetConnectAttr(dbc, SQL_ATTR_CONNECTION_DEAD, &dead,
+                                        SQL_IS_UINTEGER, nullptr))) {
+        return dead == SQL_CD_FALSE;
+    }
+
+    SQLHSTMT stmt = SQL_NULL_HANDLE;
+    if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, dbc, &stmt))) {
+        return false;
+    }
+    std::u16string query = u"SELECT 1";
+    bool ok = SQL_SUCCEEDED(SQLExecDirectW(stmt, sqlw(query), SQL_NTS));
+    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    return ok;
+}
+
+SQLHSTMT OdbcConnection::prepare(std::string_view sql) {
+    if (auto it = bySql.find(sql); it != bySql.end()) {
+        if (counters != nullptr) {
+            counters->hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        statements.splice(statements.begin(), statements, it->second);
+
+        SQLHSTMT stmt = it->second->stmt;
+        SQLFreeStmt(stmt, SQL_CLOSE);
+        SQLFreeStmt(stmt, SQL_UNBIND);
+        SQLFreeStmt(stmt, SQL_RESET_PARAMS);
+        return stmt;
+    }
+    if (counters != nullptr) {
+        counters->misses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::u16string wideSql;
+    SQLHSTMT stmt = SQL_NULL_HANDLE;
+    if (!utf::utf8_to_utf16(sql, wideSql) ||
+        !SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, dbc, &stmt))) {
+        return SQL_NULL_HANDLE;
+    }
+    if (!SQL_SUCCEEDED(SQLPrepareW(stmt, sqlw(wideSql),
+                                   SQLINTEGER(wideSql.size())))) {
+        SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+        return SQL_NULL_HANDLE;
+    }
+
+    if (statements.size() >= capacity) {
+        bySql.erase(statements.back().sql);
+        SQLFreeHandle(SQL_HANDLE_STMT, statements.back().stmt);
+        statements.pop_back();
+        if (counters != nullptr) {
+            counters->evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    statements.push_front(Statement{std::string(sql), stmt});
+    bySql.emplace(statements.front().sql, statements.begin());
+    return stmt;
+}
+
+ColumnBatch::ColumnBatch(SQLHSTMT stmt, size_t rows)
+    : stmt(stmt), rows(std::max<size_t>(rows, 1)),
+      status(new SQLUSMALLINT[this->rows]) {
+    // a driver may lower the array size (with a warning), and report fewer
+    // rows per fetch
+    ok = SQL_SUCCEEDED(SQLSetStmtAttr(stmt, SQL_ATTR_ROW_BIND_TYPE,
+                                      (SQLPOINTER)SQL_BIND_BY_COLUMN, 0)) &&
+         SQL_SUCCEEDED(SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                      (SQLPOINTER)SQLULEN(this->rows), 0)) &&
+         SQL_SUCCEEDED(SQLSetStmtAttr(stmt, SQL_ATTR_ROWS_FETCHED_PTR,
+                                      &fetched, 0)) &&
+         SQL_SUCCEEDED(SQLSetStmtAttr(stmt, SQL_ATTR_ROW_STATUS_PTR,
+                                      status.get(), 0));
+}
+
+ColumnBatch::~ColumnBatch() {
+    // the statement is kept by its connection: leave it as prepare() would
+    SQLFreeStmt(stmt, SQL_UNBIND);
+    SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)SQLULEN(1), 0);
+    SQLSetStmtAttr(stmt, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+    SQLSetStmtAttr(stmt, SQL_ATTR_ROW_STATUS_PTR, nullptr, 0);
+}
+
+bool ColumnBatch::bind_integer() {
+    Column &c = columns.emplace_back();
+    c.integers.reset(new int64_t[rows]);
+    c.indicators.reset(new SQLLEN[rows]);
+    ok = ok && SQL_SUCCEEDED(SQLBindCol(stmt, SQLUSMALLINT(columns.size()),
+                                        SQL_C_SBIGINT, c.integers.get(),
+                                        sizeof(int64_t), c.indicators.get()));
+    return ok;
+}
+
+bool ColumnBatch::bind_text(size_t maxUnits) {
+    // each value has room for its terminator
+    Column &c = columns.emplace_back();
+    c.width   = std::max<size_t>(maxUnits, 1);
+    c.units.reset(new char16_t[rows * (c.width + 1)]);
+    c.indicators.reset(new SQLLEN[rows]);
+    ok = ok && SQL_SUCCEEDED(SQLBindCol(
+                   stmt, SQLUSMALLINT(columns.size()), SQL_C_WCHAR,
+                   c.units.get(), SQLLEN((c.width + 1) * sizeof(char16_t)),
+                   c.indicators.get()));
+    return ok;
+}
+
+bool ColumnBatch::fetch(size_t &o_count) {
+    o_count = 0;
+    if (!ok) {
+        return false;
+    }
+
+    SQLRETURN rc = SQLFetchScroll(stmt, SQL_FETCH_NEXT, 0);
+    if (rc == SQL_NO_DATA) {
+        return true;
+    }
+    if (!SQL_SUCCEEDED(rc)) {
+        return false;
+    }
+    for (size_t row = 0; row < size_t(fetched); row++) {
+        if (status[row] == SQL_ROW_ERROR) {
+            return false;
+        }
+    }
+    o_count = size_t(fetched);
+    return true;
+}
+
+int64_t ColumnBatch::integer(SQLUSMALLINT column, size_t row) const {
+    const Column &c = columns[column - 1];
+    return c.indicators[row] == SQL_NULL_DATA ? 0 : c.integers[row];
+}
+
+bool ColumnBatch::text(SQLUSMALLINT column, size_t row,
+                       std::string &out) const {
+    const Column &c       = columns[column - 1];
+    const SQLLEN indicator = c.indicators[row];
+    if (indicator == SQL_NULL_DATA) {
+        return true;
+    }
+    if (indicator == SQL_NO_TOTAL || indicator < 0 ||
+        size_t(indicator) > c.width * sizeof(char16_t)) {
+        return false;
+    }
+    return utf::utf16_to_utf8(
+        std::u16string_view(c.units.get() + row * (c.width + 1),
+                            size_t(indicator) / sizeof(char16_t)),
+        out);
+}
+} // namespace db
+} // namespace iti
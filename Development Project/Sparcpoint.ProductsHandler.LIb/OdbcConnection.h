@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <sql.h>
+#include <sqlext.h>
+
+#include "ConnectionPool.h"
+
+// ODBC connections of the SQL backend. Text crosses the ODBC API as UTF-16
+// (the W functions), and is UTF-8 everywhere else.
+namespace iti {
+namespace db {
+
+// odbc_error returns the first diagnostic record of `handle`, as
+// "SQLSTATE: message".
+std::string odbc_error(SQLSMALLINT handleType, SQLHANDLE handle);
+
+// OdbcEnvironment is the ODBC 3 environment connections are allocated in. It
+// must outlive them.
+class OdbcEnvironment {
+  public:
+    // create returns nullptr if the driver manager couldn't allocate it.
+    static std::unique_ptr<OdbcEnvironment> create();
+
+    OdbcEnvironment(const OdbcEnvironment &) = delete;
+    OdbcEnvironment &operator=(const OdbcEnvironment &) = delete;
+    ~OdbcEnvironment();
+
+    SQLHENV handle() const { return env; }
+
+  private:
+    explicit OdbcEnvironment(SQLHENV env) : env(env) {}
+
+    SQLHENV env;
+};
+
+// StatementCounters count the lookups in the statement caches of the
+// connections sharing them (those of a pool).
+struct StatementCounters {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+// OdbcConnection is a connection opened with SQLDriverConnect, closed when
+// it is destroyed.
+//
+// It keeps the statements it prepared, keyed by their SQL text: a query
+// built the same way (of the same shape) is prepared once per connection,
+// then only executed. Past `statementCacheSize` statements, the least
+// recently used one is freed.
+class OdbcConnection : public IConnection {
+  public:
+    // open connects with `connStr`, and returns nullptr on failure, with the
+    // reason in `o_error` if it isn't null. `counters`, if not null, must
+    // outlive the connection.
+    static std::unique_ptr<OdbcConnection>
+    open(const OdbcEnvironment &env, std::string_view connStr,
+         size_t statementCacheSize = 64,
+         StatementCounters *counters = nullptr,
+         std::string *o_error = nullptr);
+
+    OdbcConnection(const OdbcConnection &) = delete;
+    OdbcConnection &operator=(const OdbcConnection &) = delete;
+    ~OdbcConnection() override;
+
+    // alive asks the driver whether the connection is dead, which costs no
+    // round trip; drivers that can't tell get a "SELECT 1".
+    bool alive() override;
+
+    // prepare returns the statement of `sql`, with no cursor open nor
+    // parameter or column bound, or null if it couldn't be prepared. It
+    // belongs to the connection: don't free it, and don't prepare another
+    // one while using it, as that may free it.
+    SQLHSTMT prepare(std::string_view sql);
+
+    size_t cached() const { return statements.size(); }
+
+    SQLHDBC handle() const { return dbc; }
+
+  private:
+    struct Statement {
+        std::string sql;
+        SQLHSTMT stmt;
+    };
+
+    OdbcConnection(SQLHDBC dbc, size_t statementCacheSize,
+                   StatementCounters *counters)
+        : dbc(dbc), capacity(std::max<size_t>(statementCacheSize, 1)),
+          counters(counters) {}
+
+    SQLHDBC dbc;
+
+    // the most recently used first; the keys are views of `Statement::sql`
+    std::list<Statement> statements;
+    std::unordered_map<std::string_view, std::list<Statement>::iterator>
+        bySql;
+    size_t capacity;
+    StatementCounters *counters;
+};
+
+// ColumnBatch reads the result set of a statement `rows` rows at a time,
+// into arrays bound to its columns (column-wise binding): one SQLFetchScroll
+// per batch, rather than a SQLFetch per row and a SQLGetData per column.
+//
+//  db::ColumnBatch batch(stmt, 128);
+//  batch.bind_integer();   // column 1
+//  batch.bind_text(256);   // column 2
+//  size_t n;
+//  while (batch.fetch(n) && n > 0) {
+//      for (size_t row = 0; row < n; row++) {
+//          batch.integer(1, row); batch.text(2, row, out);
+//      }
+//  }
+//
+// The statement is unbound when the batch is destroyed.
+class ColumnBatch {
+  public:
+    ColumnBatch(SQLHSTMT stmt, size_t rows);
+    ColumnBatch(const ColumnBatch &) = delete;
+    ColumnBatch &operator=(const ColumnBatch &) = delete;
+    ~ColumnBatch();
+
+    // bind_integer and bind_text bind the next column, as a BIGINT or as
+    // text of at most `maxUnits` UTF-16 units. They return false if the
+    // driver refused.
+    bool bind_integer();
+    bool bind_text(size_t maxUnits);
+
+    // fetch reads the next rows, and returns false on error; `o_count` is 0
+    // past the last row.
+    bool fetch(size_t &o_count);
+
+    // integer and text read the value of `column` (from 1) in `row` of the
+    // last fetch. A NULL is 0, or empty. text appends UTF-8 to `out`, and
+    // returns false if the value was longer than the column was bound for.
+    int64_t integer(SQLUSMALLINT column, size_t row) const;
+    bool text(SQLUSMALLINT column, size_t row, std::string &out) const;
+
+  private:
+    struct Column {
+        size_t width = 0; // in units, 0 for an integer
+        std::unique_ptr<int64_t[]> integers;
+        std::unique_ptr<char16_t[]> units;
+        std::unique_ptr<SQLLEN[]> indicators;
+    };
+
+    SQLHSTMT stmt;
+    size_t rows;
+    bool ok;
+    std::vector<Column> columns;
+    std::unique_ptr<SQLUSMALLINT[]> status;
+    SQLULEN fetched = 0;
+};
+
+} // namespace db
+} // namespace iti
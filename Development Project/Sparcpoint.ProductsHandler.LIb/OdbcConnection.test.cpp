@@ -0,0 +1,122 @@
+// OdbcConnection and ColumnBatch tests (see "test.h"), through unixODBC and
+// the SQLite ODBC driver (libsqliteodbc), which need no server:
+//
+//	./run.sh OdbcConnection.test.cpp OdbcConnection.cpp -lodbc
+//
+// ITI_TEST_ODBC overrides the connection string. The test is skipped if
+// the connection can't be opened: it then exits with 77, as automake and
+// CTest (SKIP_RETURN_CODE) take a skipped test to, so that a run without
+// the driver isn't mistaken for a pass.
+
+#include "test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "OdbcConnection.h"
+
+using iti::db::ColumnBatch;
+using iti::db::OdbcConnection;
+using iti::db::OdbcEnvironment;
+using iti::db::StatementCounters;
+
+namespace {
+
+// the exit status of a skipped test
+constexpr int skipped = 77;
+
+constexpr size_t numRows   = 300;
+constexpr size_t batchRows = 128;
+constexpr size_t maxUnits  = 32;
+
+// rows 1 to `numRows`: every 70th id is NULL, every 50th name is NULL, and
+// name 7 is 200 characters, longer than the column is bound for
+const char rowsSql[] =
+    "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n "
+    "WHERE i < 300) "
+    "SELECT CASE WHEN i % 70 = 0 THEN NULL ELSE i END, "
+    "CASE WHEN i % 50 = 0 THEN NULL "
+    "WHEN i = 7 THEN hex(zeroblob(100)) "
+    "ELSE 'name ' || i || ' \xc3\xa9' END "
+    "FROM n ORDER BY i";
+
+std::string expected_name(size_t i) {
+    if (i % 50 == 0) {
+        return std::string();
+    }
+    return "name " + std::to_string(i) + " \xc3\xa9";
+}
+
+void statements(OdbcConnection &conn, StatementCounters &counters) {
+    SQLHSTMT a = conn.prepare("SELECT 1");
+    SQLHSTMT b = conn.prepare("SELECT 1");
+    ITI_CHECK(a != SQL_NULL_HANDLE && a == b);
+    ITI_CHECK(conn.cached() == 1);
+    ITI_CHECK(counters.misses == 1 && counters.hits == 1);
+
+    // past the capacity (2), the least recently used one goes
+    conn.prepare("SELECT 2");
+    conn.prepare("SELECT 3");
+    ITI_CHECK(conn.cached() == 2 && counters.evictions == 1);
+    ITI_CHECK(conn.alive());
+}
+
+void column_batch(OdbcConnection &conn) {
+    SQLHSTMT stmt = conn.prepare(rowsSql);
+    ITI_CHECK(stmt != SQL_NULL_HANDLE);
+    if (stmt == SQL_NULL_HANDLE) {
+        return;
+    }
+
+    ColumnBatch batch(stmt, batchRows);
+    ITI_CHECK(batch.bind_integer() && batch.bind_text(maxUnits));
+    ITI_CHECK(SQL_SUCCEEDED(SQLExecute(stmt)));
+
+    // the rows come in batches of `batchRows`, the last one short
+    size_t seen = 0, batches = 0, n = 0;
+    while (batch.fetch(n) && n > 0) {
+        ITI_CHECK(n == std::min(batchRows, numRows - seen));
+        for (size_t row = 0; row < n; row++) {
+            const size_t i = seen + row + 1;
+            ITI_CHECK(batch.integer(1, row) ==
+                      (i % 70 == 0 ? 0 : int64_t(i)));
+
+            std::string name;
+            if (i == 7) {
+                ITI_CHECK(!batch.text(2, row, name));
+                continue;
+            }
+            ITI_CHECK(batch.text(2, row, name) && name == expected_name(i));
+        }
+        seen += n;
+        batches++;
+    }
+    ITI_CHECK(seen == numRows && batches == 3);
+    SQLCloseCursor(stmt);
+}
+
+} // namespace
+
+int main() {
+    const char *connStr = std::getenv("ITI_TEST_ODBC");
+    if (connStr == nullptr) {
+        connStr = "Driver=SQLite3;Database=:memory:";
+    }
+
+    auto env = OdbcEnvironment::create();
+    StatementCounters counters;
+    std::string error;
+    auto conn = env != nullptr ? OdbcConnection::open(*env, connStr, 2,
+                                                      &counters, &error)
+                               : nullptr;
+    if (conn == nullptr) {
+        std::printf("OdbcConnection: skipped, can't connect to \"%s\": %s\n",
+                    connStr, error.c_str());
+        return skipped;
+    }
+
+    statements(*conn, counters);
+    column_batch(*conn);
+    return iti::test::report("OdbcConnection");
+}
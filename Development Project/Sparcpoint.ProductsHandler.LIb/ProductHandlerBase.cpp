@@ -0,0 +1,155 @@
+#include "ProductHandlerBase.h"
+#include "utf.h"
+
+namespace iti {
+namespace {
+// Utf8List holds a list of strings converted to UTF-8, and views of them.
+struct Utf8List {
+    std::vector<std::string> strings;
+    IProductHandlerV2::StrViewList views;
+
+    bool convert(const IProductHandler::StrList &list) {
+        strings.resize(list.size());
+        for (size_t i = 0; i < list.size(); i++) {
+            if (!utf::wide_to_utf8(list[i], strings[i])) {
+                return false;
+            }
+        }
+        views.assign(strings.begin(), strings.end());
+        return true;
+    }
+};
+
+// to_wide replaces `out` with the UTF-8 JSON `json`.
+IProductHandler::ErrorCode to_wide(IProductHandler::ErrorCode err,
+                                   const std::string &json,
+                                   std::wstring &out) {
+    if (err != IProductHandler::ErrorCode::SUCCESS) {
+        return err;
+    }
+    out.clear();
+    return utf::utf8_to_wide(json, out)
+               ? err
+               : IProductHandler::ErrorCode::INTERNAL_ERROR;
+}
+} // namespace
+
+bool ProductHandlerBase::valid(std::string_view name,
+                               std::string_view gen_details,
+                               const StrViewList &categories,
+                               const StrViewList &metadata) {
+    if (name.empty() || name.size() > maxNameSize ||
+        gen_details.size() > maxDetailsSize || !utf::validate_utf8(name) ||
+        !utf::validate_utf8(gen_details)) {
+        return false;
+    }
+    for (auto category : categories) {
+        if (category.empty() || category.size() > maxCategorySize ||
+            !utf::validate_utf8(category)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < metadata.size(); i++) {
+        std::string_view attribute = metadata[i];
+        size_t keySize             = key_size(attribute);
+        size_t valueSize =
+            keySize < attribute.size() ? attribute.size() - keySize - 1 : 0;
+        if (keySize == 0 || keySize > maxAttributeKeySize ||
+            valueSize > maxAttributeValueSize ||
+            !utf::validate_utf8(attribute)) {
+            return false;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (metadata[j].substr(0, key_size(metadata[j])) ==
+                attribute.substr(0, keySize)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+IProductHandler::ErrorCode
+ProductHandlerBase::Init(const std::wstring &configJson, ILogger *logger) {
+    std::string config;
+    if (!utf::wide_to_utf8(configJson, config)) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+    return Init(std::string_view(config), logger);
+}
+
+IProductHandler::ErrorCode ProductHandlerBase::AddProductDefinition(
+    const std::wstring &name, const std::wstring &gen_details,
+    const StrList &categories, const StrList &metadata, uint64_t &o_id)
+{
+    std::string nameA, detailsA;
+    Utf8List categoriesA, metadataA;
+    if (!utf::wide_to_utf8(name, nameA) ||
+        !utf::wide_to_utf8(gen_details, detailsA) ||
+        !categoriesA.convert(categories) || !metadataA.convert(metadata)) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+    return AddProductDefinition(std::string_view(nameA), detailsA,
+                                categoriesA.views, metadataA.views, o_id);
+}
+
+IProductHandler::ErrorCode ProductHandlerBase::AddProductDefinitions(
+    const IProductHandler::ProductBatch &batch, std::vector<uint64_t> &o_ids)
+{
+    // the converted strings don't move once the views are taken
+    struct Utf8Product {
+        std::string name, details;
+        Utf8List categories, metadata;
+    };
+    std::vector<Utf8Product> products(batch.size());
+    ProductBatch batchA(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        Utf8Product &p = products[i];
+        if (!utf::wide_to_utf8(batch[i].name, p.name) ||
+            !utf::wide_to_utf8(batch[i].gen_details, p.details) ||
+            !p.categories.convert(batch[i].categories) ||
+            !p.metadata.convert(batch[i].metadata)) {
+            return ErrorCode::INVALID_INPUT_PARAM;
+        }
+        batchA[i] = ProductInput{p.name, p.details, p.categories.views,
+                                 p.metadata.views};
+    }
+    return AddProductDefinitions(batchA, o_ids);
+}
+
+IProductHandler::ErrorCode ProductHandlerBase::GetProductDefinitionById(
+    uint64_t id, std::wstring &o_prodDefJson) const
+{
+    std::string json;
+    return to_wide(GetProductDefinitionById(id, json), json, o_prodDefJson);
+}
+
+IProductHandler::ErrorCode ProductHandlerBase::GetProductDefinitions(
+    const std::wstring &name, const std::wstring &gen_details_regex,
+    const StrList &categories, const StrList &metadata, int numItemsToGet,
+    std::wstring &o_prodDefJson, Handle *o_CollectionHandle) const
+{
+    std::string nameA, regexA;
+    Utf8List categoriesA, metadataA;
+    if (!utf::wide_to_utf8(name, nameA) ||
+        !utf::wide_to_utf8(gen_details_regex, regexA) ||
+        !categoriesA.convert(categories) || !metadataA.convert(metadata)) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    std::string json;
+    return to_wide(GetProductDefinitions(
+                       std::string_view(nameA), regexA, categoriesA.views,
+                       metadataA.views, numItemsToGet, json,
+                       o_CollectionHandle),
+                   json, o_prodDefJson);
+}
+
+IProductHandler::ErrorCode ProductHandlerBase::GetNextProductDefinitions(
+    Handle collectionHandle, int numItemsToGet, std::wstring &o_prodDefJson) const {
+    std::string json;
+    return to_wide(
+        GetNextProductDefinitions(collectionHandle, numItemsToGet, json),
+        json, o_prodDefJson);
+}
+}; // namespace iti
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IProductHandler.h"
+#include "IProductHandlerV2.h"
+
+namespace iti {
+    // ProductHandlerBase implements IProductHandler over IProductHandlerV2:
+    // handlers implement the UTF-8 API only, and legacy callers get theirs
+    // transcoded (see "utf.h"). Invalid UTF-16 is INVALID_INPUT_PARAM.
+    // The calls without text are the same in both, and overridden once.
+    class ProductHandlerBase : public IProductHandler,
+                               public IProductHandlerV2 {
+      public:
+        using ErrorCode   = IProductHandler::ErrorCode;
+        using Handle      = IProductHandler::Handle;
+        using StrList     = IProductHandler::StrList;
+        using StrViewList = IProductHandlerV2::StrViewList;
+        using ProductInput = IProductHandlerV2::ProductInput;
+        using ProductBatch = IProductHandlerV2::ProductBatch;
+        using InventoryChange = IProductHandler::InventoryChange;
+        using InventoryResult = IProductHandler::InventoryResult;
+        using Atomicity       = IProductHandler::Atomicity;
+
+        // limits of the columns of the SQL Server tables, so that all
+        // backends accept the same products (in bytes of UTF-8)
+        static constexpr size_t maxNameSize           = 256;
+        static constexpr size_t maxDetailsSize        = 256;
+        static constexpr size_t maxCategorySize       = 64;
+        static constexpr size_t maxAttributeKeySize   = 64;
+        static constexpr size_t maxAttributeValueSize = 512;
+
+        // valid tells whether a product can be added: a name, all of it
+        // UTF-8 within the limits above, and metadata of distinct keys.
+        static bool valid(std::string_view name, std::string_view gen_details,
+                          const StrViewList &categories,
+                          const StrViewList &metadata);
+        // key_size returns the size of the key of a "key=value" attribute.
+        static size_t key_size(std::string_view attribute) {
+            return std::min(attribute.find('='), attribute.size());
+        }
+
+        // the UTF-8 API, overridden by the handlers
+        using IProductHandlerV2::Init;
+        using IProductHandlerV2::AddProductDefinition;
+        using IProductHandlerV2::AddProductDefinitions;
+        using IProductHandlerV2::GetProductDefinitionById;
+        using IProductHandlerV2::GetProductDefinitions;
+        using IProductHandlerV2::GetNextProductDefinitions;
+
+        ErrorCode Init(const std::wstring &configJson,
+                       ILogger *logger) override;
+        ErrorCode AddProductDefinition(const std::wstring &name,
+                                       const std::wstring &gen_details,
+                                       const StrList &categories,
+                                       const StrList &metadata,
+                                       uint64_t &o_id) override;
+        ErrorCode
+        AddProductDefinitions(const IProductHandler::ProductBatch &batch,
+                              std::vector<uint64_t> &o_ids) override;
+        ErrorCode
+        GetProductDefinitionById(uint64_t id,
+                                 std::wstring &o_prodDefJson) const override;
+        ErrorCode GetProductDefinitions(
+            const std::wstring &name, const std::wstring &gen_details_regex,
+            const StrList &categories, const StrList &metadata,
+            int numItemsToGet, std::wstring &o_prodDefJson,
+            Handle *o_CollectionHandle = nullptr) const override;
+        ErrorCode
+        GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
+                                  std::wstring &o_prodDefJson) const override;
+    };
+}; // namespace iti
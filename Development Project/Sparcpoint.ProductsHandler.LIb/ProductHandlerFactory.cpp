@@ -1,4 +1,5 @@
 #include "IProductHandler.h"
+#include "ProductHandlerInMemory.h"
 #include "ProductHandlerMSSql.h"
 
 namespace iti {
@@ -6,6 +7,17 @@ namespace iti {
 	{
 	if (type == ProductHandlerType::MSSQL)
 		return new ProductHandlerMSSql();
+	if (type == ProductHandlerType::InMemory)
+		return new ProductHandlerInMemory();
+	return nullptr;
+	}
+
+	IProductHandlerV2 *ProductHandlerFactory::CreateV2(ProductHandlerType type)
+	{
+	if (type == ProductHandlerType::MSSQL)
+		return new ProductHandlerMSSql();
+	if (type == ProductHandlerType::InMemory)
+		return new ProductHandlerInMemory();
 	return nullptr;
 	}
 }
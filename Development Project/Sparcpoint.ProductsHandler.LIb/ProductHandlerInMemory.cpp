@@ -0,0 +1,665 @@
+#include "ProductHandlerInMemory.h"
+#include "utf.h"
+
+#include <algorithm>
+#include <limits>
+#include <regex>
+
+#include "json.hpp"
+
+using nlohmann::json;
+
+namespace iti {
+// Cursor is a listing in progress: its filters, and where it is at.
+struct ProductHandlerInMemory::Cursor {
+    std::string name;
+    bool hasRegex = false;
+    std::regex details;
+    std::vector<std::string> metadata;
+
+    // categories of the filter, but `driver`'s
+    std::vector<uint32_t> categories;
+    // rows of the least common category of the filter, or null to scan
+    // all the products
+    const columns::Column<uint32_t> *driver = nullptr;
+    // a category of the filter doesn't exist: nothing matches
+    bool none = false;
+
+    // next index in `driver`, or next row
+    size_t next = 0;
+};
+
+namespace {
+// append_json_string appends `s` to `out` as a JSON string.
+void append_json_string(std::string &out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+
+    out.push_back('"');
+    size_t clean = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        auto c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(s.data() + clean, i - clean);
+        clean = i + 1;
+        switch (c) {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default:
+            out.append("\\u00");
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 0xf]);
+        }
+    }
+    out.append(s.data() + clean, s.size() - clean);
+    out.push_back('"');
+}
+} // namespace
+
+template <class F>
+void ProductHandlerInMemory::each_match(Cursor &cursor, int numItemsToGet,
+                                        F &&f) const {
+    if (cursor.none) {
+        return;
+    }
+
+    // the rows published so far; more may be added while paging. A category
+    // lists a row before it is published.
+    uint32_t published = numProducts.load(std::memory_order_acquire);
+    size_t end = cursor.driver != nullptr ? cursor.driver->size() : published;
+    for (int n = 0; n < numItemsToGet && cursor.next < end;) {
+        uint32_t row = cursor.driver != nullptr
+                           ? (*cursor.driver)[cursor.next]
+                           : uint32_t(cursor.next);
+        if (row >= published) {
+            break;
+        }
+        cursor.next++;
+        if (matches(cursor, row)) {
+            f(row);
+            n++;
+        }
+    }
+}
+
+IProductHandler::ErrorCode
+ProductHandlerInMemory::Init(std::string_view configJson,
+                             ILogger * /*logger*/) {
+    if (state == State::Uninitialized) {
+        if (!configJson.empty() && !json::accept(configJson)) {
+            return ErrorCode::INVALID_INPUT_PARAM;
+        }
+        state = State::Initialized;
+        return ErrorCode::SUCCESS;
+    }
+    return ErrorCode::INCORRECT_STATE;
+}
+
+IProductHandler::ErrorCode
+    ProductHandlerInMemory::Shutdown()
+{
+    // the catalog is kept: it lives as long as the handler
+    if (state == State::Initialized) {
+        state = State::Uninitialized;
+        return ErrorCode::SUCCESS;
+    }
+
+    return ErrorCode::INCORRECT_STATE;
+}
+
+IProductHandler::ErrorCode ProductHandlerInMemory::AddProductDefinition(
+    std::string_view name, std::string_view gen_details,
+    const StrViewList &categories, const StrViewList &metadata, uint64_t &o_id)
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    // validate everything first: a product is added whole, or not at all
+    if (!valid(name, gen_details, categories, metadata)) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    std::lock_guard<std::mutex> l(writer);
+
+    uint32_t row = numProducts.load(std::memory_order_relaxed);
+    if (row == std::numeric_limits<uint32_t>::max()) {
+        return ErrorCode::RESOURCE_UNAVAILABLE;
+    }
+    append(row, name, gen_details, categories, metadata);
+
+    // publish the row
+    numProducts.store(row + 1, std::memory_order_release);
+    o_id = uint64_t(row) + 1;
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::AddProductDefinitions(
+    const ProductBatch &batch, std::vector<uint64_t> &o_ids)
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    for (const auto &p : batch) {
+        if (!valid(p.name, p.gen_details, p.categories, p.metadata)) {
+            return ErrorCode::INVALID_INPUT_PARAM;
+        }
+    }
+
+    std::lock_guard<std::mutex> l(writer);
+
+    uint32_t first = numProducts.load(std::memory_order_relaxed);
+    if (batch.size() > size_t(std::numeric_limits<uint32_t>::max() - first)) {
+        return ErrorCode::RESOURCE_UNAVAILABLE;
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        append(first + uint32_t(i), batch[i].name, batch[i].gen_details,
+               batch[i].categories, batch[i].metadata);
+    }
+
+    // publish the rows
+    numProducts.store(first + uint32_t(batch.size()),
+                      std::memory_order_release);
+    o_ids.clear();
+    for (size_t i = 0; i < batch.size(); i++) {
+        o_ids.push_back(uint64_t(first) + i + 1);
+    }
+    return ErrorCode::SUCCESS;
+}
+
+
+void ProductHandlerInMemory::append(uint32_t row, std::string_view name,
+                                    std::string_view gen_details,
+                                    const StrViewList &categories,
+                                    const StrViewList &metadata) {
+    names.push_back(strings.copy(name));
+    details.push_back(strings.copy(gen_details));
+    inventory.emplace_back();
+
+    Range range{uint32_t(productCategories.size()), 0};
+    for (auto category : categories) {
+        uint32_t id = this->categories.find(category);
+        if (id == columns::NameIndex::npos) {
+            // its rows first: readers may use the id once it is found
+            categoryProducts.push_back(
+                std::make_unique<columns::Column<uint32_t>>());
+            id = this->categories.add(strings.copy(category));
+        }
+
+        // the same category twice is the same category
+        auto &rows = *categoryProducts.at(id);
+        if (rows.size() > 0 && rows[rows.size() - 1] == row) {
+            continue;
+        }
+        rows.push_back(row);
+        productCategories.push_back(id);
+        range.count++;
+    }
+    categoryRanges.push_back(range);
+
+    range = Range{uint32_t(productAttributes.size()), 0};
+    for (auto attribute : metadata) {
+        productAttributes.push_back(
+            Attribute{strings.copy(attribute), uint32_t(key_size(attribute))});
+        range.count++;
+    }
+    attributeRanges.push_back(range);
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::GetProductDefinitionById(
+    uint64_t id, std::string &o_prodDefJson) const
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    uint32_t r;
+    if (!row(id, r)) {
+        return ErrorCode::NOT_FOUND;
+    }
+
+    write_product(r, o_prodDefJson);
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::GetProductDefinitions(
+    std::string_view name, std::string_view gen_details_regex,
+    const StrViewList &categories, const StrViewList &metadata,
+    int numItemsToGet, std::string &o_prodDefJson,
+    Handle *o_CollectionHandle, int *o_numItems) const
+{
+    std::unique_ptr<Cursor> cursor;
+    if (auto err = open_cursor(name, gen_details_regex, categories, metadata,
+                               numItemsToGet, cursor);
+        err != ErrorCode::SUCCESS) {
+        return err;
+    }
+
+    const int n = next_page(*cursor, numItemsToGet, o_prodDefJson);
+    if (o_numItems != nullptr) {
+        *o_numItems = n;
+    }
+
+    if (o_CollectionHandle != nullptr) {
+        *o_CollectionHandle = cursor.release();
+    }
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::GetNextProductDefinitions(
+    Handle collectionHandle, int numItemsToGet, std::string &o_prodDefJson,
+    int *o_numItems) const {
+    if (collectionHandle == nullptr || numItemsToGet <= 0) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    const int n = next_page(*static_cast<Cursor *>(collectionHandle),
+                            numItemsToGet, o_prodDefJson);
+    if (o_numItems != nullptr) {
+        *o_numItems = n;
+    }
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::GetProductDefinitionById(
+    uint64_t id, ProductDefinition &o_prodDef) const
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    uint32_t r;
+    if (!row(id, r)) {
+        return ErrorCode::NOT_FOUND;
+    }
+
+    fill(r, o_prodDef);
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::GetProductDefinitions(
+    std::string_view name, std::string_view gen_details_regex,
+    const StrViewList &categories, const StrViewList &metadata,
+    int numItemsToGet, const ProductVisitor &visitor,
+    Handle *o_CollectionHandle) const
+{
+    std::unique_ptr<Cursor> cursor;
+    if (auto err = open_cursor(name, gen_details_regex, categories, metadata,
+                               numItemsToGet, cursor);
+        err != ErrorCode::SUCCESS) {
+        return err;
+    }
+
+    visit(*cursor, numItemsToGet, visitor);
+
+    if (o_CollectionHandle != nullptr) {
+        *o_CollectionHandle = cursor.release();
+    }
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::GetNextProductDefinitions(
+    Handle collectionHandle, int numItemsToGet, const ProductVisitor &visitor) const {
+    if (collectionHandle == nullptr || numItemsToGet <= 0) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    visit(*static_cast<Cursor *>(collectionHandle), numItemsToGet, visitor);
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode
+ProductHandlerInMemory::CloseCollectionHandle(Handle collectionHandle) {
+    if (collectionHandle == nullptr) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    delete static_cast<Cursor *>(collectionHandle);
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode
+ProductHandlerInMemory::AddProductInventory(uint64_t id, uint64_t numToAdd, uint64_t &o_numPresent) {
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    uint32_t r;
+    if (!row(id, r)) {
+        return ErrorCode::NOT_FOUND;
+    }
+
+    std::lock_guard<std::mutex> l(writer);
+    auto &present = inventory.at(r);
+    uint64_t n    = present.load(std::memory_order_relaxed);
+    if (numToAdd > std::numeric_limits<uint64_t>::max() - n) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    o_numPresent = n + numToAdd;
+    present.store(o_numPresent, std::memory_order_relaxed);
+    return ErrorCode::SUCCESS;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerInMemory::RemoveProductInventory(uint64_t id, uint64_t numToRemove,
+                                            uint64_t &o_numRemoved, uint64_t &o_numPresent) {
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    uint32_t r;
+    if (!row(id, r)) {
+        return ErrorCode::NOT_FOUND;
+    }
+
+    std::lock_guard<std::mutex> l(writer);
+    auto &present = inventory.at(r);
+    uint64_t n    = present.load(std::memory_order_relaxed);
+    o_numRemoved  = std::min(n, numToRemove);
+    o_numPresent  = n - o_numRemoved;
+    present.store(o_numPresent, std::memory_order_relaxed);
+    return ErrorCode::SUCCESS;
+}
+
+IProductHandler::ErrorCode
+ProductHandlerInMemory::ReportProductInventory(uint64_t id, uint64_t &o_numPresent) const
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    uint32_t r;
+    if (!row(id, r)) {
+        return ErrorCode::NOT_FOUND;
+    }
+
+    o_numPresent = inventory[r].load(std::memory_order_relaxed);
+    return ErrorCode::SUCCESS;
+}
+
+IProductHandler::ErrorCode ProductHandlerInMemory::AdjustProductInventories(
+    const std::vector<InventoryChange> &changes, Atomicity atomicity,
+    std::vector<InventoryResult> &o_results)
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+
+    // the products not found fail whatever the order: all-or-nothing
+    // checks them before changing anything
+    o_results.assign(changes.size(), InventoryResult());
+    ErrorCode first = ErrorCode::SUCCESS;
+    for (size_t i = 0; i < changes.size(); i++) {
+        uint32_t r;
+        if (!row(changes[i].id, r)) {
+            o_results[i].error = ErrorCode::NOT_FOUND;
+            if (first == ErrorCode::SUCCESS) {
+                first = ErrorCode::NOT_FOUND;
+            }
+        }
+    }
+    if (atomicity == Atomicity::AllOrNothing && first != ErrorCode::SUCCESS) {
+        return first;
+    }
+
+    std::lock_guard<std::mutex> l(writer);
+
+    // the inventories before the changes, to undo them if one overflows
+    // (readers may see them in between, as with single calls)
+    std::vector<std::pair<uint32_t, uint64_t>> undo;
+    if (atomicity == Atomicity::AllOrNothing) {
+        undo.reserve(changes.size());
+    }
+    for (size_t i = 0; i < changes.size(); i++) {
+        InventoryResult &result = o_results[i];
+        if (result.error != ErrorCode::SUCCESS) {
+            continue;
+        }
+        // found above, and products are never removed
+        uint32_t r = uint32_t(changes[i].id - 1);
+
+        auto &present = inventory.at(r);
+        const uint64_t n = present.load(std::memory_order_relaxed);
+        // the magnitude of the delta, which may be INT64_MIN
+        const int64_t delta  = changes[i].delta;
+        const uint64_t units =
+            delta < 0 ? uint64_t(0) - uint64_t(delta) : uint64_t(delta);
+        if (delta >= 0 && units > std::numeric_limits<uint64_t>::max() - n) {
+            result.error = ErrorCode::INVALID_INPUT_PARAM;
+            if (atomicity == Atomicity::AllOrNothing) {
+                for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+                    inventory.at(it->first).store(it->second,
+                                                  std::memory_order_relaxed);
+                }
+                // none was applied
+                for (size_t j = 0; j < i; j++) {
+                    o_results[j].numChanged = 0;
+                    o_results[j].numPresent = 0;
+                }
+                return result.error;
+            }
+            continue;
+        }
+
+        result.numChanged = delta >= 0 ? units : std::min(n, units);
+        result.numPresent = delta >= 0 ? n + units : n - result.numChanged;
+        if (atomicity == Atomicity::AllOrNothing) {
+            undo.emplace_back(r, n);
+        }
+        present.store(result.numPresent, std::memory_order_relaxed);
+    }
+    return ErrorCode::SUCCESS;
+}
+
+bool ProductHandlerInMemory::row(uint64_t id, uint32_t &o_row) const {
+    if (id == 0 || id > numProducts.load(std::memory_order_acquire)) {
+        return false;
+    }
+    o_row = uint32_t(id - 1);
+    return true;
+}
+
+void ProductHandlerInMemory::write_product(uint32_t row,
+                                           std::string &out) const {
+    out.append("{\"id\":\"");
+    out.append(std::to_string(uint64_t(row) + 1));
+    out.append("\",\"name\":");
+    append_json_string(out, names[row]);
+
+    out.append(",\"categories\":[");
+    Range range = categoryRanges[row];
+    for (uint32_t i = 0; i < range.count; i++) {
+        if (i > 0) {
+            out.push_back(',');
+        }
+        append_json_string(
+            out, categories.name(productCategories[range.begin + i]));
+    }
+
+    out.append("],\"metadata\":[");
+    range = attributeRanges[row];
+    for (uint32_t i = 0; i < range.count; i++) {
+        if (i > 0) {
+            out.push_back(',');
+        }
+        append_json_string(out, productAttributes[range.begin + i].text);
+    }
+
+    out.append("],\"general-details\":");
+    append_json_string(out, details[row]);
+    out.push_back('}');
+}
+
+void ProductHandlerInMemory::fill(uint32_t row,
+                                  ProductDefinition &o_prodDef) const {
+    o_prodDef.id             = uint64_t(row) + 1;
+    o_prodDef.name           = names[row];
+    o_prodDef.generalDetails = details[row];
+
+    o_prodDef.categories.clear();
+    Range range = categoryRanges[row];
+    for (uint32_t i = 0; i < range.count; i++) {
+        o_prodDef.categories.push_back(
+            categories.name(productCategories[range.begin + i]));
+    }
+
+    o_prodDef.metadata.clear();
+    range = attributeRanges[row];
+    for (uint32_t i = 0; i < range.count; i++) {
+        o_prodDef.metadata.push_back(productAttributes[range.begin + i].text);
+    }
+}
+
+IProductHandler::ErrorCode ProductHandlerInMemory::open_cursor(
+    std::string_view name, std::string_view gen_details_regex,
+    const StrViewList &categories, const StrViewList &metadata,
+    int numItemsToGet, std::unique_ptr<Cursor> &o_cursor) const
+{
+    if (state != State::Initialized) {
+        return ErrorCode::NOT_READY;
+    }
+    if (numItemsToGet <= 0) {
+        return ErrorCode::INVALID_INPUT_PARAM;
+    }
+
+    auto cursor  = std::make_unique<Cursor>();
+    cursor->name = std::string(name);
+    if (!gen_details_regex.empty()) {
+        try {
+            cursor->details  = std::regex(gen_details_regex.begin(),
+                                          gen_details_regex.end());
+            cursor->hasRegex = true;
+        } catch (const std::regex_error &) {
+            return ErrorCode::INVALID_INPUT_PARAM;
+        }
+    }
+    cursor->metadata.assign(metadata.begin(), metadata.end());
+
+    // walk the rows of the least common category, and check the others
+    for (auto category : categories) {
+        uint32_t id = this->categories.find(category);
+        if (id == columns::NameIndex::npos) {
+            cursor->none = true;
+            break;
+        }
+        cursor->categories.push_back(id);
+    }
+    if (!cursor->none && !cursor->categories.empty()) {
+        auto rarest = std::min_element(
+            cursor->categories.begin(), cursor->categories.end(),
+            [this](uint32_t a, uint32_t b) {
+                return categoryProducts[a]->size() <
+                       categoryProducts[b]->size();
+            });
+        cursor->driver = categoryProducts[*rarest].get();
+        cursor->categories.erase(rarest);
+    }
+
+    o_cursor = std::move(cursor);
+    return ErrorCode::SUCCESS;
+}
+
+int ProductHandlerInMemory::next_page(Cursor &cursor, int numItemsToGet,
+                                      std::string &out) const {
+    out.push_back('[');
+    int n = 0;
+    each_match(cursor, numItemsToGet, [&](uint32_t row) {
+        if (n++ > 0) {
+            out.push_back(',');
+        }
+        write_product(row, out);
+    });
+    out.push_back(']');
+    return n;
+}
+
+void ProductHandlerInMemory::skip(Cursor &cursor, int numItems) const {
+    // every published row matches an unfiltered listing of the catalog:
+    // jump past them
+    if (cursor.driver == nullptr && !cursor.none && cursor.name.empty() &&
+        !cursor.hasRegex && cursor.categories.empty() &&
+        cursor.metadata.empty()) {
+        const size_t published = numProducts.load(std::memory_order_acquire);
+        cursor.next =
+            std::min(published, cursor.next + size_t(numItems));
+        return;
+    }
+    each_match(cursor, numItems, [](uint32_t /*row*/) {});
+}
+
+void ProductHandlerInMemory::visit(Cursor &cursor, int numItemsToGet,
+                                   const ProductVisitor &visitor) const {
+    if (!visitor) {
+        skip(cursor, numItemsToGet);
+        return;
+    }
+    ProductDefinition product;
+    each_match(cursor, numItemsToGet, [&](uint32_t row) {
+        fill(row, product);
+        visitor(product);
+    });
+}
+
+bool ProductHandlerInMemory::matches(const Cursor &cursor,
+                                     uint32_t row) const {
+    if (!cursor.name.empty() &&
+        names[row].find(cursor.name) == std::string_view::npos) {
+        return false;
+    }
+
+    Range range = categoryRanges[row];
+    for (uint32_t id : cursor.categories) {
+        bool found = false;
+        for (uint32_t i = 0; i < range.count && !found; i++) {
+            found = productCategories[range.begin + i] == id;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+
+    range = attributeRanges[row];
+    for (const auto &m : cursor.metadata) {
+        bool found = false;
+        for (uint32_t i = 0; i < range.count && !found; i++) {
+            const Attribute &a = productAttributes[range.begin + i];
+            found = a.text == m ||
+                    (m.find('=') == std::string::npos && a.key() == m);
+        }
+        if (!found) {
+            return false;
+        }
+    }
+
+    if (cursor.hasRegex) {
+        auto d = details[row];
+        return std::regex_search(d.begin(), d.end(), cursor.details);
+    }
+    return true;
+}
+}; // namespace iti
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ColumnStore.h"
+#include "ProductHandlerBase.h"
+
+namespace iti {
+    // ProductHandlerInMemory keeps the catalog in process memory, laid out
+    // as the Instances.Products, ProductCategories and ProductAttributes
+    // tables are, one column per field (see "ColumnStore.h"):
+    //  - a product id is its row + 1, so finding a product is an index;
+    //  - categories are numbered densely, and each lists the rows of its
+    //    products, so filtering by category walks the shortest list;
+    //  - the text lives in a string arena, as UTF-8.
+    //
+    // Reads never lock: rows are published with a release store of the
+    // number of products, after their columns are written. Writes are
+    // serialized by a mutex. The configuration JSON and the logger are
+    // ignored: there is nothing to configure, nor to log.
+    class ProductHandlerInMemory : public ProductHandlerBase {
+      public:
+        ProductHandlerInMemory() = default;
+        ProductHandlerInMemory(const ProductHandlerInMemory &) = delete;
+        ProductHandlerInMemory& operator=(const ProductHandlerInMemory &) = delete;
+
+        // the wide API of IProductHandler
+        using ProductHandlerBase::Init;
+        using ProductHandlerBase::AddProductDefinition;
+        using ProductHandlerBase::AddProductDefinitions;
+        using ProductHandlerBase::GetProductDefinitionById;
+        using ProductHandlerBase::GetProductDefinitions;
+        using ProductHandlerBase::GetNextProductDefinitions;
+
+        ErrorCode Init(std::string_view configJson,
+                       ILogger *logger) override;
+        ErrorCode Shutdown()            override;
+
+        /* metadata are "key=value" (or just "key") attributes, keys are
+         * unique per product
+         */
+        ErrorCode AddProductDefinition(std::string_view name,
+                                       std::string_view gen_details,
+                                       const StrViewList &categories,
+                                       const StrViewList &metadata,
+                                       uint64_t &o_id) override;
+        /* the products of the batch are published together: readers see
+         * all of them, or none
+         */
+        ErrorCode AddProductDefinitions(const ProductBatch &batch,
+                                        std::vector<uint64_t> &o_ids) override;
+        ErrorCode
+        GetProductDefinitionById(uint64_t id,
+                                 std::string &o_prodDefJson) const override;
+        /* A product is listed if its name contains `name`, its details match
+         * `gen_details_regex` (ECMAScript), it is in all of `categories`,
+         * and it has all of `metadata`: "key=value" matches an attribute,
+         * "key" any attribute with that key. Empty filters match all.
+         */
+        ErrorCode GetProductDefinitions(
+            std::string_view name, std::string_view gen_details_regex,
+            const StrViewList &categories, const StrViewList &metadata,
+            int numItemsToGet, std::string &o_prodDefJson,
+            Handle *o_CollectionHandle = nullptr,
+            int *o_numItems = nullptr) const override;
+        ErrorCode
+        GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
+                                  std::string &o_prodDefJson,
+                                  int *o_numItems = nullptr) const override;
+        /* the views point into the catalog: they are valid as long as the
+         * handler is
+         */
+        ErrorCode
+        GetProductDefinitionById(uint64_t id,
+                                 ProductDefinition &o_prodDef) const override;
+        ErrorCode GetProductDefinitions(
+            std::string_view name, std::string_view gen_details_regex,
+            const StrViewList &categories, const StrViewList &metadata,
+            int numItemsToGet, const ProductVisitor &visitor,
+            Handle *o_CollectionHandle = nullptr) const override;
+        ErrorCode
+        GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
+                                  const ProductVisitor &visitor) const override;
+        ErrorCode
+        CloseCollectionHandle(Handle collectionHandle) override;
+        ErrorCode AddProductInventory(uint64_t id,
+                            uint64_t numToAdd, uint64_t &o_numPresent) override;
+        /* removes what is present, at most `numToRemove` */
+        ErrorCode RemoveProductInventory(uint64_t id,
+                                         uint64_t numToRemove,
+                                         uint64_t &o_numRemoved,
+                                         uint64_t &o_numPresent) override;
+        ErrorCode
+        ReportProductInventory(uint64_t id, uint64_t &o_numPresent) const override;
+        ErrorCode AdjustProductInventories(
+            const std::vector<InventoryChange> &changes, Atomicity atomicity,
+            std::vector<InventoryResult> &o_results) override;
+
+      private:
+        // Range is a product's slice of a ProductCategories or
+        // ProductAttributes column.
+        struct Range {
+            uint32_t begin = 0;
+            uint32_t count = 0;
+        };
+
+        // Attribute is a "key=value" string; the key is its first keySize
+        // bytes.
+        struct Attribute {
+            std::string_view text;
+            uint32_t keySize = 0;
+
+            std::string_view key() const { return text.substr(0, keySize); }
+        };
+
+        struct Cursor;
+
+        // append writes the columns of a product at `row`, which isn't
+        // published. It is called with `writer` locked.
+        void append(uint32_t row, std::string_view name,
+                    std::string_view gen_details,
+                    const StrViewList &categories,
+                    const StrViewList &metadata);
+
+        // row returns the row of product `id`, or false if there's none.
+        bool row(uint64_t id, uint32_t &o_row) const;
+        // write_product appends the JSON of a product to `out`.
+        void write_product(uint32_t row, std::string &out) const;
+        // fill makes `o_prodDef` a view of a product.
+        void fill(uint32_t row, ProductDefinition &o_prodDef) const;
+
+        // open_cursor starts a listing of the products matching the
+        // filters (see `GetProductDefinitions()`).
+        ErrorCode open_cursor(std::string_view name,
+                              std::string_view gen_details_regex,
+                              const StrViewList &categories,
+                              const StrViewList &metadata, int numItemsToGet,
+                              std::unique_ptr<Cursor> &o_cursor) const;
+        // next_page appends the JSON array of the next products of
+        // `cursor` to `out`, at most `numItemsToGet`, and returns their
+        // number.
+        int next_page(Cursor &cursor, int numItemsToGet,
+                      std::string &out) const;
+        // each_match calls `f(row)` for the next products of `cursor`, at
+        // most `numItemsToGet`.
+        template <class F>
+        void each_match(Cursor &cursor, int numItemsToGet, F &&f) const;
+        // skip moves `cursor` past its next `numItems` products.
+        void skip(Cursor &cursor, int numItems) const;
+        // visit calls `visitor` with the next products of `cursor`, or
+        // skips them if it is empty.
+        void visit(Cursor &cursor, int numItemsToGet,
+                   const ProductVisitor &visitor) const;
+        bool matches(const Cursor &cursor, uint32_t row) const;
+
+        enum class State {
+            Initialized,
+            Uninitialized
+        };
+        std::atomic<State> state{State::Uninitialized};
+
+        // rows [0, numProducts) are visible to readers
+        std::atomic<uint32_t> numProducts{0};
+
+        // Products: one column per field
+        columns::Column<std::string_view, 10> names;
+        columns::Column<std::string_view, 10> details;
+        columns::Column<Range, 10> categoryRanges;
+        columns::Column<Range, 10> attributeRanges;
+        columns::Column<std::atomic<uint64_t>, 10> inventory;
+
+        // ProductCategories and ProductAttributes, grouped by product
+        columns::Column<uint32_t, 10> productCategories;
+        columns::Column<Attribute, 10> productAttributes;
+
+        // Categories: names, and the rows of their products in order
+        columns::NameIndex categories;
+        columns::Column<std::unique_ptr<columns::Column<uint32_t>>>
+            categoryProducts;
+
+        columns::StringArena strings;
+        std::mutex writer;
+    };
+}; // namespace iti
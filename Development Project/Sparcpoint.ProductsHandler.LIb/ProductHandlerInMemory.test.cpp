@@ -0,0 +1,293 @@
+// ProductHandlerInMemory tests (see "test.h"), also meant to be run under
+// ThreadSanitizer:
+//
+//	./run.sh ProductHandlerInMemory.test.cpp
+//	CXXFLAGS="-O1 -fsanitize=thread" ./run.sh ProductHandlerInMemory.test.cpp
+
+#include "test.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.hpp"
+
+#include "ProductHandlerInMemory.h"
+
+using iti::ProductDefinition;
+using iti::ProductHandlerInMemory;
+using ErrorCode = ProductHandlerInMemory::ErrorCode;
+using Atomicity = ProductHandlerInMemory::Atomicity;
+using nlohmann::json;
+
+namespace {
+
+// count_listing returns the number of products of a listing, visiting them
+// page by page with a cursor, or -1 on error. Each product must have
+// `category`.
+int count_listing(ProductHandlerInMemory &h, std::string_view category,
+                  int pageSize) {
+    int n = 0;
+    bool complete = true;
+    auto visit = [&](const ProductDefinition &p) {
+        bool has = false;
+        for (auto c : p.categories) {
+            has = has || c == category;
+        }
+        complete = complete && has && !p.name.empty();
+        n++;
+    };
+
+    ProductHandlerInMemory::Handle cursor = nullptr;
+    if (h.GetProductDefinitions("", "", {category}, {}, pageSize, visit,
+                                &cursor) != ErrorCode::SUCCESS) {
+        return -1;
+    }
+    for (int before = -1; before != n;) {
+        before = n;
+        if (h.GetNextProductDefinitions(cursor, pageSize, visit) !=
+            ErrorCode::SUCCESS) {
+            return -1;
+        }
+    }
+    h.CloseCollectionHandle(cursor);
+    return complete ? n : -1;
+}
+
+void lifecycle() {
+    ProductHandlerInMemory h;
+    uint64_t id = 0;
+    ITI_CHECK(h.AddProductDefinition("x", "", {}, {}, id) ==
+              ErrorCode::NOT_READY);
+    ITI_CHECK(h.Init("{", nullptr) == ErrorCode::INVALID_INPUT_PARAM);
+    ITI_CHECK(h.Init("", nullptr) == ErrorCode::SUCCESS);
+    ITI_CHECK(h.Init("", nullptr) == ErrorCode::INCORRECT_STATE);
+    ITI_CHECK(h.Shutdown() == ErrorCode::SUCCESS);
+    ITI_CHECK(h.Shutdown() == ErrorCode::INCORRECT_STATE);
+}
+
+void products() {
+    ProductHandlerInMemory h;
+    h.Init("", nullptr);
+
+    uint64_t id = 0;
+    ITI_CHECK(h.AddProductDefinition("", "", {}, {}, id) ==
+              ErrorCode::INVALID_INPUT_PARAM);
+    ITI_CHECK(h.AddProductDefinition("a", "", {}, {"k=1", "k=2"}, id) ==
+              ErrorCode::INVALID_INPUT_PARAM);
+    ITI_CHECK(h.AddProductDefinition("Hammer \"big\"", "steel\nhead",
+                                     {"tools", "tools", "garden"},
+                                     {"color=red", "heavy"},
+                                     id) == ErrorCode::SUCCESS);
+    ITI_CHECK(id == 1);
+
+    std::string out;
+    ITI_CHECK(h.GetProductDefinitionById(1, out) == ErrorCode::SUCCESS);
+    auto j = json::parse(out);
+    ITI_CHECK(j["name"] == "Hammer \"big\"");
+    ITI_CHECK(j["general-details"] == "steel\nhead");
+    ITI_CHECK(j["categories"].size() == 2);
+    ITI_CHECK(h.GetProductDefinitionById(2, out) == ErrorCode::NOT_FOUND);
+
+    for (int i = 0; i < 1000; i++) {
+        std::string name = "p" + std::to_string(i);
+        std::string category = "cat" + std::to_string(i % 10);
+        h.AddProductDefinition(name, "details " + std::to_string(i),
+                               {i % 2 ? "odd" : "even", category}, {}, id);
+    }
+    out.clear();
+    ITI_CHECK(h.GetProductDefinitions("", "", {"cat7", "odd"}, {}, 1000,
+                                      out) == ErrorCode::SUCCESS);
+    ITI_CHECK(json::parse(out).size() == 100);
+    ITI_CHECK(count_listing(h, "cat3", 7) == 100);
+    out.clear();
+    ITI_CHECK(h.GetProductDefinitions("", "^details 99\\d$", {}, {}, 1000,
+                                      out) == ErrorCode::SUCCESS);
+    ITI_CHECK(json::parse(out).size() == 10);
+    ITI_CHECK(h.GetProductDefinitions("", "(", {}, {}, 1, out) ==
+              ErrorCode::INVALID_INPUT_PARAM);
+}
+
+// first_id returns the id of the first product of the page after skipping
+// `offset` products of a listing, with an empty visitor, or 0 if there's
+// none; `o_numItems` is the number of products of that page.
+uint64_t first_id(ProductHandlerInMemory &h, const std::string &category,
+                  int offset, int &o_numItems) {
+    ProductHandlerInMemory::Handle cursor = nullptr;
+    std::vector<std::string_view> categories;
+    if (!category.empty()) {
+        categories.push_back(category);
+    }
+    h.GetProductDefinitions("", "", categories, {}, offset,
+                            iti::ProductVisitor(), &cursor);
+    std::string out;
+    o_numItems = -1;
+    h.GetNextProductDefinitions(cursor, 10, out, &o_numItems);
+    h.CloseCollectionHandle(cursor);
+    auto page = json::parse(out);
+    return page.empty() ? 0 : std::stoull(page[0]["id"].get<std::string>());
+}
+
+// skipping: an empty visitor moves a listing past products without
+// visiting them, filtered or not, and stops at its end
+void skipping() {
+    ProductHandlerInMemory h;
+    h.Init("", nullptr);
+    uint64_t id = 0;
+    for (int i = 0; i < 100; i++) {
+        h.AddProductDefinition("p" + std::to_string(i), "",
+                               {i % 3 ? "other" : "third"}, {}, id);
+    }
+
+    int n = 0;
+    ITI_CHECK(first_id(h, "", 1, n) == 2 && n == 10);
+    ITI_CHECK(first_id(h, "", 95, n) == 96 && n == 5);
+    ITI_CHECK(first_id(h, "", 100, n) == 0 && n == 0);
+    ITI_CHECK(first_id(h, "", 1000, n) == 0 && n == 0);
+    // products 1, 4, 7... are in "third"
+    ITI_CHECK(first_id(h, "third", 2, n) == 7 && n == 10);
+    ITI_CHECK(first_id(h, "third", 30, n) == 91 && n == 4);
+    ITI_CHECK(first_id(h, "nope", 5, n) == 0 && n == 0);
+
+    // and the JSON listing counts what it wrote
+    std::string out;
+    n = -1;
+    ITI_CHECK(h.GetProductDefinitions("", "", {"third"}, {}, 50, out,
+                                      nullptr, &n) == ErrorCode::SUCCESS);
+    ITI_CHECK(n == 34 && json::parse(out).size() == 34);
+}
+
+void inventory() {
+    ProductHandlerInMemory h;
+    h.Init("", nullptr);
+    uint64_t id = 0, present = 0, removed = 0;
+    h.AddProductDefinition("a", "", {}, {}, id);
+
+    ITI_CHECK(h.AddProductInventory(id, 10, present) == ErrorCode::SUCCESS);
+    ITI_CHECK(present == 10);
+    ITI_CHECK(h.RemoveProductInventory(id, 15, removed, present) ==
+              ErrorCode::SUCCESS);
+    ITI_CHECK(removed == 10 && present == 0);
+    ITI_CHECK(h.AddProductInventory(99, 1, present) == ErrorCode::NOT_FOUND);
+
+    // a batch that isn't applied reports no units for the changes that
+    // could have been made
+    std::vector<ProductHandlerInMemory::InventoryResult> results;
+    ITI_CHECK(h.AdjustProductInventories({{id, 5}, {99, 1}},
+                                         Atomicity::AllOrNothing,
+                                         results) == ErrorCode::NOT_FOUND);
+    ITI_CHECK(results.size() == 2 && results[1].error == ErrorCode::NOT_FOUND);
+    ITI_CHECK(results[0].error == ErrorCode::SUCCESS &&
+              results[0].numChanged == 0 && results[0].numPresent == 0);
+    // nor does one undone when a later change overflows
+    ITI_CHECK(h.AdjustProductInventories(
+                  {{id, INT64_MAX}, {id, INT64_MAX}, {id, 5}},
+                  Atomicity::AllOrNothing,
+                  results) == ErrorCode::INVALID_INPUT_PARAM);
+    ITI_CHECK(results.size() == 3 &&
+              results[2].error == ErrorCode::INVALID_INPUT_PARAM);
+    ITI_CHECK(results[0].numChanged == 0 && results[0].numPresent == 0 &&
+              results[1].numChanged == 0 && results[1].numPresent == 0);
+    h.ReportProductInventory(id, present);
+    ITI_CHECK(present == 0);
+}
+
+// concurrency: readers list products, visit them and read inventories while
+// writers add products one by one and in batches, and adjust inventories.
+// Readers must only ever see whole products and whole batches.
+void concurrency() {
+    ProductHandlerInMemory h;
+    h.Init("", nullptr);
+    uint64_t stockId = 0;
+    h.AddProductDefinition("stock", "", {}, {}, stockId);
+
+    constexpr int numSingles = 5000;
+    constexpr int numBatches = 200;
+    constexpr int batchSize  = 10;
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> errors{0};
+    std::vector<std::thread> readers;
+    for (int k = 0; k < 4; k++) {
+        readers.emplace_back([&] {
+            int singles = 0, batched = 0;
+            std::string out;
+            while (!stop) {
+                int s = count_listing(h, "single", 64);
+                int b = count_listing(h, "batch", 64);
+                // listings only grow, and batches are published whole
+                if (s < singles || b < batched || b % batchSize != 0) {
+                    errors++;
+                }
+                singles = s;
+                batched = b;
+
+                out.clear();
+                uint64_t last = uint64_t(s + b) + 1;
+                if (h.GetProductDefinitionById(last, out) ==
+                        ErrorCode::SUCCESS &&
+                    !json::accept(out)) {
+                    errors++;
+                }
+                uint64_t present = 0;
+                h.ReportProductInventory(stockId, present);
+            }
+        });
+    }
+
+    std::thread singles([&] {
+        uint64_t id = 0;
+        for (int i = 0; i < numSingles; i++) {
+            std::string category = "c" + std::to_string(i);
+            if (h.AddProductDefinition("single", "", {"single", category},
+                                       {}, id) != ErrorCode::SUCCESS) {
+                errors++;
+            }
+        }
+    });
+    std::thread batches([&] {
+        std::vector<uint64_t> ids;
+        for (int i = 0; i < numBatches; i++) {
+            ProductHandlerInMemory::ProductBatch batch(
+                batchSize, {"batched", "", {"batch"}, {"n=1"}});
+            if (h.AddProductDefinitions(batch, ids) != ErrorCode::SUCCESS) {
+                errors++;
+            }
+        }
+    });
+    std::thread stock([&] {
+        std::vector<ProductHandlerInMemory::InventoryResult> results;
+        for (int i = 0; i < 20000; i++) {
+            h.AdjustProductInventories({{stockId, 2}, {stockId, -1}},
+                                       Atomicity::AllOrNothing, results);
+        }
+    });
+
+    singles.join();
+    batches.join();
+    stock.join();
+    stop = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    ITI_CHECK(errors == 0);
+    ITI_CHECK(count_listing(h, "single", 1000) == numSingles);
+    ITI_CHECK(count_listing(h, "batch", 1000) == numBatches * batchSize);
+    uint64_t present = 0;
+    h.ReportProductInventory(stockId, present);
+    ITI_CHECK(present == 20000);
+}
+
+} // namespace
+
+int main() {
+    lifecycle();
+    products();
+    skipping();
+    inventory();
+    concurrency();
+    return iti::test::report("ProductHandlerInMemory");
+}
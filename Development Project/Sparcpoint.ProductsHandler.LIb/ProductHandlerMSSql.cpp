@@ -1,22 +1,68 @@
 #pragma once
 
 #include "ProductHandlerMSSql.h"
-#include "ProductUtil.h"
+#include "OdbcConnection.h"
 
 using nlohmann::json;
 
 namespace iti {
+ProductHandlerMSSql::ProductHandlerMSSql()
+    : logger(nullptr), state(State::Uninitialized) {}
+
+ProductHandlerMSSql::~ProductHandlerMSSql() = default;
+
 IProductHandler::ErrorCode
-ProductHandlerMSSql::Init(const std::wstring &configJson, ILogger *logger) {
+ProductHandlerMSSql::Init(std::string_view configJson, ILogger *logger) {
     if ( state == State::Uninitialized)
     {
-        this->logger = logger;
-        std::string configJsonA = WstrToStr(configJson);
+        db::ConnectionPool::Options options;
+        std::string connStr;
+        size_t statementCacheSize = 64;
         try {
-            this->configJson = json::parse(configJsonA);
-        } catch (json::parse_error & /* ex */) {
+            this->configJson = json::parse(configJson);
+            connStr = this->configJson.at("ConnStr").get<std::string>();
+
+            const json pool = this->configJson.value("Pool", json::object());
+            options.minSize = pool.value("MinSize", options.minSize);
+            options.maxSize = pool.value("MaxSize", options.maxSize);
+            options.idleTimeout = std::chrono::milliseconds(pool.value(
+                "IdleTimeoutMs", int64_t(options.idleTimeout.count())));
+            options.checkoutTimeout = std::chrono::milliseconds(pool.value(
+                "CheckoutTimeoutMs", int64_t(options.checkoutTimeout.count())));
+            options.validateAfter = std::chrono::milliseconds(pool.value(
+                "ValidateAfterMs", int64_t(options.validateAfter.count())));
+            statementCacheSize = this->configJson.value("StatementCacheSize",
+                                                        statementCacheSize);
+        } catch (json::exception & /* ex */) {
             return ErrorCode::INVALID_INPUT_PARAM;
         }
+        if (options.maxSize == 0 || options.minSize > options.maxSize ||
+            statementCacheSize == 0) {
+            return ErrorCode::INVALID_INPUT_PARAM;
+        }
+
+        env = db::OdbcEnvironment::create();
+        if (env == nullptr) {
+            return ErrorCode::RESOURCE_UNAVAILABLE;
+        }
+        statements = std::make_unique<db::StatementCounters>();
+        const db::OdbcEnvironment *environment = env.get();
+        db::StatementCounters *counters        = statements.get();
+        pool = std::make_unique<db::ConnectionPool>(
+            [environment, connStr, statementCacheSize,
+             counters]() -> std::unique_ptr<db::IConnection> {
+                return db::OdbcConnection::open(*environment, connStr,
+                                                statementCacheSize, counters);
+            },
+            options);
+        if (!pool->fill()) {
+            pool.reset();
+            statements.reset();
+            env.reset();
+            return ErrorCode::RESOURCE_UNAVAILABLE;
+        }
+
+        this->logger = logger;
         state = State::Initialized;
         return ErrorCode::SUCCESS;
     }
@@ -27,6 +73,10 @@ IProductHandler::ErrorCode
     ProductHandlerMSSql::Shutdown()
 {
     if (state == State::Initialized) {
+        // the connections are closed before their environment
+        pool.reset();
+        statements.reset();
+        env.reset();
         this->logger = nullptr;
         state        = State::Uninitialized;
         return ErrorCode::SUCCESS;
@@ -35,56 +85,133 @@ IProductHandler::ErrorCode
     return ErrorCode::INCORRECT_STATE;
 }
 
+std::optional<ProductHandlerMSSql::ConnectionPoolStats>
+ProductHandlerMSSql::PoolStats() const {
+    ConnectionPoolStats s;
+    if (pool != nullptr) {
+        const db::ConnectionPool::Stats p = pool->stats();
+        s.size           = p.size;
+        s.inUse          = p.inUse;
+        s.waiting        = p.waiting;
+        s.maxSize        = p.maxSize;
+        s.checkouts      = p.checkouts;
+        s.timeouts       = p.timeouts;
+        s.waits          = p.waits;
+        s.waitNsTotal    = p.waitNsTotal;
+        s.waitNsMax      = p.waitNsMax;
+        s.opened         = p.opened;
+        s.openFailures   = p.openFailures;
+        s.deadOnCheckout = p.deadOnCheckout;
+        s.evicted        = p.evicted;
+    }
+    return s;
+}
+
+std::optional<ProductHandlerMSSql::StatementStats>
+ProductHandlerMSSql::StatementCacheStats() const {
+    StatementStats s;
+    if (statements != nullptr) {
+        s.hits      = statements->hits.load(std::memory_order_relaxed);
+        s.misses    = statements->misses.load(std::memory_order_relaxed);
+        s.evictions = statements->evictions.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
 IProductHandler::ErrorCode ProductHandlerMSSql::AddProductDefinition(
-    const std::wstring &name, const std::wstring &gen_details,
-    const StrList &categories, const StrList &metadata, uint64_t &o_id) 
+    std::string_view /*name*/, std::string_view /*gen_details*/,
+    const StrViewList & /*categories*/, const StrViewList & /*metadata*/,
+    uint64_t & /*o_id*/)
+{
+    return ErrorCode::NOT_IMPLEMENTED;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerMSSql::AddProductDefinitions(
+    const ProductBatch & /*batch*/, std::vector<uint64_t> & /*o_ids*/)
 {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 
 IProductHandler::ErrorCode ProductHandlerMSSql::GetProductDefinitionById(
-    uint64_t id, std::wstring &o_prodDefJson) const 
+    uint64_t /*id*/, std::string & /*o_prodDefJson*/) const
 {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 
 IProductHandler::ErrorCode ProductHandlerMSSql::GetProductDefinitions(
-    const std::wstring &name, const std::wstring &gen_details_regex,
-    const StrList &categories, const StrList &metadata, int numItemsToGet,
-    std::wstring &o_prodDefJson, Handle *o_CollectionHandle) const 
+    std::string_view /*name*/, std::string_view /*gen_details_regex*/,
+    const StrViewList & /*categories*/, const StrViewList & /*metadata*/,
+    int /*numItemsToGet*/, std::string & /*o_prodDefJson*/,
+    Handle * /*o_CollectionHandle*/, int * /*o_numItems*/) const
 {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 
 IProductHandler::ErrorCode ProductHandlerMSSql::GetNextProductDefinitions(
-    Handle collectionHandle, int numItemsToGet, std::wstring &o_prodDefJson) const {
+    Handle /*collectionHandle*/, int /*numItemsToGet*/,
+    std::string & /*o_prodDefJson*/, int * /*o_numItems*/) const {
+    return ErrorCode::NOT_IMPLEMENTED;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerMSSql::GetProductDefinitionById(
+    uint64_t /*id*/, ProductDefinition & /*o_prodDef*/) const
+{
+    return ErrorCode::NOT_IMPLEMENTED;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerMSSql::GetProductDefinitions(
+    std::string_view /*name*/, std::string_view /*gen_details_regex*/,
+    const StrViewList & /*categories*/, const StrViewList & /*metadata*/,
+    int /*numItemsToGet*/, const ProductVisitor & /*visitor*/,
+    Handle * /*o_CollectionHandle*/) const
+{
+    return ErrorCode::NOT_IMPLEMENTED;
+}
+
+
+IProductHandler::ErrorCode ProductHandlerMSSql::GetNextProductDefinitions(
+    Handle /*collectionHandle*/, int /*numItemsToGet*/,
+    const ProductVisitor & /*visitor*/) const {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 
 IProductHandler::ErrorCode
-ProductHandlerMSSql::CloseCollectionHandle(Handle collectionHandle) {
+ProductHandlerMSSql::CloseCollectionHandle(Handle /*collectionHandle*/) {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 
 IProductHandler::ErrorCode
-ProductHandlerMSSql::AddProductInventory(uint64_t id, uint64_t numToAdd, uint64_t &o_numPresent) {
+ProductHandlerMSSql::AddProductInventory(uint64_t /*id*/,
+                                         uint64_t /*numToAdd*/,
+                                         uint64_t & /*o_numPresent*/) {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 
-IProductHandler::ErrorCode ProductHandlerMSSql::RemoveProductInventory(uint64_t id, uint64_t numToRemove,
-                                            uint64_t &o_numRemoved, uint64_t &o_numPresent) {
+IProductHandler::ErrorCode ProductHandlerMSSql::RemoveProductInventory(
+    uint64_t /*id*/, uint64_t /*numToRemove*/, uint64_t & /*o_numRemoved*/,
+    uint64_t & /*o_numPresent*/) {
     return ErrorCode::NOT_IMPLEMENTED;
 }
 
 IProductHandler::ErrorCode
-ProductHandlerMSSql::ReportProductInventory(uint64_t id, uint64_t &o_numPresent) const
+ProductHandlerMSSql::ReportProductInventory(uint64_t /*id*/,
+                                            uint64_t & /*o_numPresent*/) const
 {
     return ErrorCode::NOT_IMPLEMENTED;
 }
+
+IProductHandler::ErrorCode ProductHandlerMSSql::AdjustProductInventories(
+    const std::vector<InventoryChange> & /*changes*/,
+    Atomicity /*atomicity*/, std::vector<InventoryResult> & /*o_results*/) {
+    return ErrorCode::NOT_IMPLEMENTED;
+}
 }; // namespace iti
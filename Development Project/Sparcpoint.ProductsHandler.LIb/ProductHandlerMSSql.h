@@ -1,38 +1,91 @@
 #pragma once
 
-#include "IProductHandler.h"
+#include <memory>
+
+#include "ConnectionPool.h"
+#include "ProductHandlerBase.h"
 #include "json.hpp"
 
 namespace iti {
-    class ProductHandlerMSSql : public IProductHandler {
+    namespace db {
+        class OdbcEnvironment;
+        struct StatementCounters;
+    }
+
+    // ProductHandlerMSSql is the SQL Server backend, through ODBC. Its
+    // connections are pooled (see "ConnectionPool.h"); the pool is
+    // configured by the "Pool" object of the configuration JSON:
+    //
+    //  {
+    //      "ConnStr" : "some-ODBC-conn-str",
+    //      "Pool" : {
+    //          "MinSize" : 1, "MaxSize" : 8,
+    //          "IdleTimeoutMs" : 60000, "CheckoutTimeoutMs" : 5000,
+    //          "ValidateAfterMs" : 1000
+    //      },
+    //      "StatementCacheSize" : 64
+    //  }
+    //
+    // all of which are optional but "ConnStr". `Init()` opens the first
+    // `MinSize` connections, and fails with RESOURCE_UNAVAILABLE if it
+    // can't. Each connection keeps its prepared statements (see
+    // "OdbcConnection.h").
+    //
+    // The product and inventory operations aren't implemented yet: they
+    // return NOT_IMPLEMENTED until they can be tested against a SQL Server.
+    class ProductHandlerMSSql : public ProductHandlerBase {
       public: 
-        ProductHandlerMSSql() : logger(nullptr), state(State::Uninitialized) {}
+        ProductHandlerMSSql();
         ProductHandlerMSSql(const ProductHandlerMSSql &) = delete;
         ProductHandlerMSSql& operator=(const ProductHandlerMSSql &) = delete;
+        ~ProductHandlerMSSql() override;
+
+        // the wide API of IProductHandler
+        using ProductHandlerBase::Init;
+        using ProductHandlerBase::AddProductDefinition;
+        using ProductHandlerBase::AddProductDefinitions;
+        using ProductHandlerBase::GetProductDefinitionById;
+        using ProductHandlerBase::GetProductDefinitions;
+        using ProductHandlerBase::GetNextProductDefinitions;
         
-        ErrorCode Init(const std::wstring &configJson,
+        ErrorCode Init(std::string_view configJson,
                        ILogger *logger) override;
         ErrorCode Shutdown()            override;
 
-        ErrorCode AddProductDefinition(const std::wstring &name,
-                                               const std::wstring &gen_details,
-                                               const StrList &categories,
-                                               const StrList &metadata,
-                                               uint64_t &o_id) override;
+        ErrorCode AddProductDefinition(std::string_view name,
+                                       std::string_view gen_details,
+                                       const StrViewList &categories,
+                                       const StrViewList &metadata,
+                                       uint64_t &o_id) override;
+        ErrorCode AddProductDefinitions(const ProductBatch &batch,
+                                        std::vector<uint64_t> &o_ids) override;
         ErrorCode
         GetProductDefinitionById(uint64_t id,
-                                 std::wstring &o_prodDefJson) const override;
+                                 std::string &o_prodDefJson) const override;
         ErrorCode GetProductDefinitions(
-            const std::wstring &name, const std::wstring &gen_details_regex,
-            const StrList &categories, const StrList &metadata,
-            int numItemsToGet, std::wstring &o_prodDefJson,
-            Handle *o_CollectionHandle = nullptr) const override;
+            std::string_view name, std::string_view gen_details_regex,
+            const StrViewList &categories, const StrViewList &metadata,
+            int numItemsToGet, std::string &o_prodDefJson,
+            Handle *o_CollectionHandle = nullptr,
+            int *o_numItems = nullptr) const override;
         /* GetNextProductDefinitions Output JSON format: same as for
          * GetProductDefinitions
          * */
         ErrorCode
         GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
-                                  std::wstring &o_prodDefJson) const override;
+                                  std::string &o_prodDefJson,
+                                  int *o_numItems = nullptr) const override;
+        ErrorCode
+        GetProductDefinitionById(uint64_t id,
+                                 ProductDefinition &o_prodDef) const override;
+        ErrorCode GetProductDefinitions(
+            std::string_view name, std::string_view gen_details_regex,
+            const StrViewList &categories, const StrViewList &metadata,
+            int numItemsToGet, const ProductVisitor &visitor,
+            Handle *o_CollectionHandle = nullptr) const override;
+        ErrorCode
+        GetNextProductDefinitions(Handle collectionHandle, int numItemsToGet,
+                                  const ProductVisitor &visitor) const override;
         ErrorCode
         CloseCollectionHandle(Handle collectionHandle) override;
         ErrorCode AddProductInventory(uint64_t id,
@@ -43,6 +96,14 @@ namespace iti {
                                          uint64_t &o_numPresent) override;
         ErrorCode
         ReportProductInventory(uint64_t id, uint64_t &o_numPresent) const override;
+        ErrorCode AdjustProductInventories(
+            const std::vector<InventoryChange> &changes, Atomicity atomicity,
+            std::vector<InventoryResult> &o_results) override;
+
+        // the pool is empty, and the caches too, when the handler isn't
+        // initialized
+        std::optional<ConnectionPoolStats> PoolStats() const override;
+        std::optional<StatementStats> StatementCacheStats() const override;
 
       private:
         ILogger *logger;
@@ -52,5 +113,9 @@ namespace iti {
         };
         State state;
         nlohmann::json configJson;
+
+        std::unique_ptr<db::OdbcEnvironment> env;
+        std::unique_ptr<db::StatementCounters> statements;
+        std::unique_ptr<db::ConnectionPool> pool;
     };
     }; // namespace iti
@@ -1,23 +1,27 @@
 #pragma once
 
-#include <codecvt>
-#include <locale>
+#include <stdexcept>
 #include <string>
 
-#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING 1
+#include "utf.h"
 
 namespace iti {
 
+// WstrToStr converts UTF-16 (UTF-32 where wchar_t is 4 bytes) to UTF-8. It
+// throws std::range_error on invalid input, as std::wstring_convert did.
 inline std::string WstrToStr(const std::wstring &source) {
-    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
-    std::string dest = convert.to_bytes((std::u16string &)source);
+    std::string dest;
+    if (!utf::wide_to_utf8(source, dest)) {
+        throw std::range_error("WstrToStr: invalid UTF-16/UTF-32");
+    }
     return dest;
 }
 
 inline std::wstring StrToWstr(const std::string &source) {
-    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
-    std::u16string dest = convert.from_bytes(source);
-    return (std::wstring &)dest;
+    std::wstring dest;
+    if (!utf::utf8_to_wide(source, dest)) {
+        throw std::range_error("StrToWstr: invalid UTF-8");
+    }
+    return dest;
 }
 } // namespace iti
- 
\ No newline at end of file
@@ -0,0 +1,22 @@
+#!/bin/sh
+# run.sh builds one of the test programs of the library (the `*.test.cpp`
+# files, see "../Sparcpoint.Core.Lib/test.h") with the library sources that
+# don't need ODBC, and runs it. Paths are relative to this directory:
+#
+#	./run.sh ProductHandlerInMemory.test.cpp
+#	CXXFLAGS="-O1 -fsanitize=thread" ./run.sh ProductHandlerInMemory.test.cpp
+#
+# Extra arguments go to the compiler ($CXX, g++ by default), after
+# $CXXFLAGS (-O2 by default): ODBC sources and libraries, say.
+set -e
+cd "$(dirname "$0")"
+src=$1
+shift
+out=${TMPDIR:-/tmp}/$(basename "$src" .cpp)
+${CXX:-g++} -std=c++17 ${CXXFLAGS:--O2} -I. -I../Sparcpoint.Core.Lib \
+    -I../vendor/nlohmann-3.10.2 -o "$out" "$src" \
+    $(ls *.cpp | grep -v -e '\.bench\.cpp$' -e '\.test\.cpp$' \
+        -e '^OdbcConnection\.cpp$' -e '^ProductHandlerMSSql\.cpp$' \
+        -e '^ProductHandlerFactory\.cpp$') \
+    -lpthread "$@"
+"$out"
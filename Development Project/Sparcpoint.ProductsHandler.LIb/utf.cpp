@@ -0,0 +1,295 @@
+#include "utf.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ITI_UTF_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace iti {
+namespace utf {
+namespace {
+inline unsigned trailing_zeros(unsigned v) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return unsigned(i);
+#else
+    return unsigned(__builtin_ctz(v));
+#endif
+}
+
+inline bool is_surrogate(uint32_t c) { return c >= 0xd800 && c <= 0xdfff; }
+
+// ascii_run returns the number of ASCII bytes at the start of `s`.
+size_t ascii_run(const char *s, size_t n) {
+    size_t i = 0;
+#ifdef ITI_UTF_SSE2
+    for (; i + 16 <= n; i += 16) {
+        int mask = _mm_movemask_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i)));
+        if (mask != 0) {
+            return i + trailing_zeros(unsigned(mask));
+        }
+    }
+#endif
+    while (i < n && static_cast<unsigned char>(s[i]) < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+// decode_utf8 decodes the character at `s[i]`, and moves `i` past it.
+bool decode_utf8(const char *s, size_t n, size_t &i, uint32_t &cp) {
+    auto c = static_cast<unsigned char>(s[i]);
+    if (c < 0x80) {
+        cp = c;
+        i++;
+        return true;
+    }
+
+    size_t size;
+    uint32_t min;
+    if ((c & 0xe0) == 0xc0) {
+        size = 2;
+        cp   = c & 0x1f;
+        min  = 0x80;
+    } else if ((c & 0xf0) == 0xe0) {
+        size = 3;
+        cp   = c & 0x0f;
+        min  = 0x800;
+    } else if ((c & 0xf8) == 0xf0) {
+        size = 4;
+        cp   = c & 0x07;
+        min  = 0x10000;
+    } else {
+        return false;
+    }
+    if (n - i < size) {
+        return false;
+    }
+    for (size_t k = 1; k < size; k++) {
+        auto b = static_cast<unsigned char>(s[i + k]);
+        if ((b & 0xc0) != 0x80) {
+            return false;
+        }
+        cp = (cp << 6) | (b & 0x3f);
+    }
+
+    // overlong forms, surrogates and past the last code point
+    if (cp < min || cp > 0x10ffff || is_surrogate(cp)) {
+        return false;
+    }
+    i += size;
+    return true;
+}
+
+char *encode_utf8(uint32_t cp, char *o) {
+    if (cp < 0x80) {
+        *o++ = char(cp);
+    } else if (cp < 0x800) {
+        *o++ = char(0xc0 | (cp >> 6));
+        *o++ = char(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        *o++ = char(0xe0 | (cp >> 12));
+        *o++ = char(0x80 | ((cp >> 6) & 0x3f));
+        *o++ = char(0x80 | (cp & 0x3f));
+    } else {
+        *o++ = char(0xf0 | (cp >> 18));
+        *o++ = char(0x80 | ((cp >> 12) & 0x3f));
+        *o++ = char(0x80 | ((cp >> 6) & 0x3f));
+        *o++ = char(0x80 | (cp & 0x3f));
+    }
+    return o;
+}
+
+// widen_ascii copies the ASCII bytes at the start of `s` to `o`, one unit
+// each, and returns how many there were.
+template <class Char> size_t widen_ascii(const char *s, size_t n, Char *o) {
+    size_t i = 0;
+#ifdef ITI_UTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        if (_mm_movemask_epi8(v) != 0) {
+            break;
+        }
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        auto *out  = reinterpret_cast<__m128i *>(o + i);
+        if constexpr (sizeof(Char) == 2) {
+            _mm_storeu_si128(out, lo);
+            _mm_storeu_si128(out + 1, hi);
+        } else {
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+        }
+    }
+#endif
+    for (; i < n && static_cast<unsigned char>(s[i]) < 0x80; i++) {
+        o[i] = Char(s[i]);
+    }
+    return i;
+}
+
+// narrow_ascii copies the ASCII units at the start of `s` to `o`, one byte
+// each, and returns how many there were.
+template <class Char> size_t narrow_ascii(const Char *s, size_t n, char *o) {
+    size_t i = 0;
+#ifdef ITI_UTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    if constexpr (sizeof(Char) == 2) {
+        const __m128i high = _mm_set1_epi16(short(0xff80));
+        for (; i + 8 <= n; i += 8) {
+            __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, high), zero);
+            if (_mm_movemask_epi8(ascii) != 0xffff) {
+                break;
+            }
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(o + i),
+                             _mm_packus_epi16(v, v));
+        }
+    } else {
+        const __m128i high = _mm_set1_epi32(int(0xffffff80));
+        for (; i + 8 <= n; i += 8) {
+            __m128i a =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            __m128i b =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + 4));
+            __m128i ascii = _mm_and_si128(
+                _mm_cmpeq_epi32(_mm_and_si128(a, high), zero),
+                _mm_cmpeq_epi32(_mm_and_si128(b, high), zero));
+            if (_mm_movemask_epi8(ascii) != 0xffff) {
+                break;
+            }
+            __m128i units = _mm_packs_epi32(a, b);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(o + i),
+                             _mm_packus_epi16(units, units));
+        }
+    }
+#endif
+    for (; i < n && uint32_t(s[i]) < 0x80; i++) {
+        o[i] = char(s[i]);
+    }
+    return i;
+}
+
+// from_utf8 converts UTF-8 to UTF-16 (2 byte units) or UTF-32.
+template <class Char>
+bool from_utf8(std::string_view in, std::basic_string<Char> &out) {
+    // a unit (or a surrogate pair) never takes more than its UTF-8 bytes
+    const size_t base = out.size();
+    out.resize(base + in.size());
+
+    Char *o        = out.data() + base;
+    const char *s  = in.data();
+    const size_t n = in.size();
+    bool ok        = true;
+    for (size_t i = 0; i < n;) {
+        size_t run = widen_ascii(s + i, n - i, o);
+        i += run;
+        o += run;
+        if (i == n) {
+            break;
+        }
+
+        uint32_t cp;
+        if (!decode_utf8(s, n, i, cp)) {
+            ok = false;
+            break;
+        }
+        if (sizeof(Char) == 2 && cp >= 0x10000) {
+            cp -= 0x10000;
+            *o++ = Char(0xd800 + (cp >> 10));
+            *o++ = Char(0xdc00 + (cp & 0x3ff));
+        } else {
+            *o++ = Char(cp);
+        }
+    }
+    out.resize(size_t(o - out.data()));
+    return ok;
+}
+
+// to_utf8 converts UTF-16 (2 byte units) or UTF-32 to UTF-8.
+template <class Char>
+bool to_utf8(std::basic_string_view<Char> in, std::string &out) {
+    const size_t base = out.size();
+    out.resize(base + in.size() * (sizeof(Char) == 2 ? 3 : 4));
+
+    char *o        = out.data() + base;
+    const Char *s  = in.data();
+    const size_t n = in.size();
+    bool ok        = true;
+    for (size_t i = 0; i < n;) {
+        size_t run = narrow_ascii(s + i, n - i, o);
+        i += run;
+        o += run;
+        if (i == n) {
+            break;
+        }
+
+        uint32_t cp = uint32_t(s[i++]);
+        if constexpr (sizeof(Char) == 2) {
+            cp &= 0xffff;
+            if (cp >= 0xd800 && cp <= 0xdbff && i < n &&
+                (uint32_t(s[i]) & 0xfc00) == 0xdc00) {
+                cp = 0x10000 + ((cp - 0xd800) << 10) +
+                     ((uint32_t(s[i++]) & 0xffff) - 0xdc00);
+            }
+        }
+        if (cp > 0x10ffff || is_surrogate(cp)) {
+            ok = false;
+            break;
+        }
+        o = encode_utf8(cp, o);
+    }
+    out.resize(size_t(o - out.data()));
+    return ok;
+}
+} // namespace
+
+bool validate_utf8(std::string_view s) {
+    for (size_t i = 0; i < s.size();) {
+        i += ascii_run(s.data() + i, s.size() - i);
+        uint32_t cp;
+        if (i < s.size() && !decode_utf8(s.data(), s.size(), i, cp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool utf8_to_utf16(std::string_view in, std::u16string &out) {
+    return from_utf8(in, out);
+}
+
+bool utf8_to_utf32(std::string_view in, std::u32string &out) {
+    return from_utf8(in, out);
+}
+
+bool utf16_to_utf8(std::u16string_view in, std::string &out) {
+    return to_utf8(in, out);
+}
+
+bool utf32_to_utf8(std::u32string_view in, std::string &out) {
+    return to_utf8(in, out);
+}
+
+bool utf8_to_wide(std::string_view in, std::wstring &out) {
+    return from_utf8(in, out);
+}
+
+bool wide_to_utf8(std::wstring_view in, std::string &out) {
+    return to_utf8(in, out);
+}
+} // namespace utf
+} // namespace iti
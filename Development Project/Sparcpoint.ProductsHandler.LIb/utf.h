@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// UTF-8, UTF-16 and UTF-32 validation and transcoding.
+//
+// Runs of ASCII, the bulk of product data, are checked and widened or
+// narrowed 16 bytes at a time with SSE2; other characters are decoded one by
+// one. Invalid input (malformed or overlong sequences, unpaired surrogates,
+// code points past U+10FFFF) is rejected, never replaced.
+//
+// The conversions append to `out`, which callers can reuse from call to call.
+// On failure they return false, and `out` holds part of the conversion.
+namespace iti {
+namespace utf {
+
+bool validate_utf8(std::string_view s);
+
+bool utf8_to_utf16(std::string_view in, std::u16string &out);
+bool utf8_to_utf32(std::string_view in, std::u32string &out);
+bool utf16_to_utf8(std::u16string_view in, std::string &out);
+bool utf32_to_utf8(std::u32string_view in, std::string &out);
+
+// wchar_t text is UTF-16 on Windows, and UTF-32 elsewhere.
+bool utf8_to_wide(std::string_view in, std::wstring &out);
+bool wide_to_utf8(std::wstring_view in, std::string &out);
+
+} // namespace utf
+} // namespace iti
@@ -0,0 +1,286 @@
+// utf tests (see "test.h"), also meant to be run under the sanitizers:
+//
+//	./run.sh utf.test.cpp
+//	CXXFLAGS="-O1 -fsanitize=address,undefined" ./run.sh utf.test.cpp
+//
+// The transcoder is checked on hand-picked invalid input, on every code
+// point, and against the reference decoder and encoder below on random
+// strings.
+
+#include "test.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utf.h"
+
+using namespace iti::utf;
+
+namespace {
+
+// ref_decode decodes UTF-8 one byte at a time, following table 3-7 of the
+// Unicode standard ("Well-Formed UTF-8 Byte Sequences").
+bool ref_decode(const std::string &s, std::u32string &out) {
+    for (size_t i = 0; i < s.size();) {
+        const uint8_t b = uint8_t(s[i]);
+        size_t len;
+        uint8_t lo = 0x80, hi = 0xbf; // range of the second byte
+        if (b < 0x80) {
+            out.push_back(b);
+            i++;
+            continue;
+        } else if (b >= 0xc2 && b <= 0xdf) {
+            len = 2;
+        } else if (b >= 0xe0 && b <= 0xef) {
+            len = 3;
+            lo  = b == 0xe0 ? 0xa0 : 0x80;
+            hi  = b == 0xed ? 0x9f : 0xbf;
+        } else if (b >= 0xf0 && b <= 0xf4) {
+            len = 4;
+            lo  = b == 0xf0 ? 0x90 : 0x80;
+            hi  = b == 0xf4 ? 0x8f : 0xbf;
+        } else {
+            return false;
+        }
+        if (s.size() - i < len) {
+            return false;
+        }
+        const uint8_t b1 = uint8_t(s[i + 1]);
+        if (b1 < lo || b1 > hi) {
+            return false;
+        }
+        uint32_t cp = b & (0x7f >> len);
+        for (size_t k = 1; k < len; k++) {
+            const uint8_t c = uint8_t(s[i + k]);
+            if ((c & 0xc0) != 0x80) {
+                return false;
+            }
+            cp = (cp << 6) | (c & 0x3f);
+        }
+        out.push_back(cp);
+        i += len;
+    }
+    return true;
+}
+
+// ref_encode encodes code points as UTF-8.
+bool ref_encode(const std::u32string &in, std::string &out) {
+    for (char32_t cp : in) {
+        if (cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+            return false;
+        } else if (cp < 0x80) {
+            out.push_back(char(cp));
+        } else if (cp < 0x800) {
+            out.push_back(char(0xc0 | (cp >> 6)));
+            out.push_back(char(0x80 | (cp & 0x3f)));
+        } else if (cp < 0x10000) {
+            out.push_back(char(0xe0 | (cp >> 12)));
+            out.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+            out.push_back(char(0x80 | (cp & 0x3f)));
+        } else {
+            out.push_back(char(0xf0 | (cp >> 18)));
+            out.push_back(char(0x80 | ((cp >> 12) & 0x3f)));
+            out.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+            out.push_back(char(0x80 | (cp & 0x3f)));
+        }
+    }
+    return true;
+}
+
+// ref_utf16 decodes UTF-16 into code points, rejecting unpaired surrogates.
+bool ref_utf16(const std::u16string &in, std::u32string &out) {
+    for (size_t i = 0; i < in.size(); i++) {
+        const uint32_t u = in[i];
+        if (u >= 0xdc00 && u <= 0xdfff) {
+            return false;
+        }
+        if (u < 0xd800 || u > 0xdbff) {
+            out.push_back(u);
+            continue;
+        }
+        if (i + 1 == in.size() || in[i + 1] < 0xdc00 || in[i + 1] > 0xdfff) {
+            return false;
+        }
+        out.push_back(0x10000 + ((u - 0xd800) << 10) + (in[++i] - 0xdc00));
+    }
+    return true;
+}
+
+std::u16string to_utf16(const std::u32string &in) {
+    std::u16string out;
+    for (char32_t cp : in) {
+        if (cp < 0x10000) {
+            out.push_back(char16_t(cp));
+        } else {
+            out.push_back(char16_t(0xd800 + ((cp - 0x10000) >> 10)));
+            out.push_back(char16_t(0xdc00 + ((cp - 0x10000) & 0x3ff)));
+        }
+    }
+    return out;
+}
+
+// padded puts `s` after and before runs of ASCII long enough to take the
+// SSE2 path, so that it is reached both from there and from the tail.
+std::vector<std::string> padded(const std::string &s) {
+    const std::string run(19, 'a');
+    return {s, run + s, s + run, run + s + run, "a" + s};
+}
+
+// rejected checks that every conversion from UTF-8 rejects `s`.
+bool rejected(const std::string &s) {
+    bool ok = true;
+    for (const std::string &p : padded(s)) {
+        std::u16string u16;
+        std::u32string u32;
+        std::wstring w;
+        ok = ITI_CHECK(!validate_utf8(p)) && ok;
+        ok = ITI_CHECK(!utf8_to_utf16(p, u16)) && ok;
+        ok = ITI_CHECK(!utf8_to_utf32(p, u32)) && ok;
+        ok = ITI_CHECK(!utf8_to_wide(p, w)) && ok;
+    }
+    return ok;
+}
+
+void invalid_utf8() {
+    const char *cases[] = {
+        // overlong forms of U+0000, U+002F, U+007F, U+07FF and U+FFFF
+        "\xc0\x80", "\xc0\xaf", "\xc1\xbf", "\xe0\x80\x80", "\xe0\x9f\xbf",
+        "\xf0\x80\x80\x80", "\xf0\x8f\xbf\xbf", "\xf8\x88\x80\x80\x80",
+        // surrogates: lone high, lone low, and a pair encoded separately
+        "\xed\xa0\x80", "\xed\xbf\xbf", "\xed\xa0\xbd\xed\xb8\x80",
+        // past U+10FFFF
+        "\xf4\x90\x80\x80", "\xf4\xbf\xbf\xbf", "\xf5\x80\x80\x80",
+        "\xf7\xbf\xbf\xbf", "\xfe", "\xff",
+        // truncated, stray and missing continuation bytes
+        "\xc3", "\xe2\x82", "\xf0\x9f\x98", "\x80", "\xbf", "\xc3\x28",
+        "\xe2\x28\xa1", "\xf0\x9f\x28\x80"};
+    for (const char *c : cases) {
+        if (!rejected(c)) {
+            std::printf("  accepted:");
+            for (const char *b = c; *b; b++) {
+                std::printf(" %02x", unsigned(uint8_t(*b)));
+            }
+            std::printf("\n");
+        }
+    }
+    // NUL is a character like any other
+    const std::string nul("a\0b", 3);
+    ITI_CHECK(validate_utf8(nul));
+}
+
+void invalid_utf16_utf32() {
+    const std::u16string cases16[] = {
+        u"\xd800", u"\xdbff", u"\xdc00", u"\xdfff",
+        std::u16string{0xd800, u'a'},   // high, then not a low
+        std::u16string{0xdc00, 0xd800}, // reversed pair
+        std::u16string{0xd800, 0xd800, 0xdc00}};
+    for (const std::u16string &c : cases16) {
+        for (const std::u16string &p :
+             {c, std::u16string(19, u'a') + c, c + std::u16string(19, u'a')}) {
+            std::string out;
+            ITI_CHECK(!utf16_to_utf8(p, out));
+        }
+    }
+
+    const std::u32string cases32[] = {U"\xd800", U"\xdfff", U"\x110000",
+                                      U"\xffffffff", U"\x7fffffff"};
+    for (const std::u32string &c : cases32) {
+        for (const std::u32string &p :
+             {c, std::u32string(19, U'a') + c, c + std::u32string(19, U'a')}) {
+            std::string out;
+            ITI_CHECK(!utf32_to_utf8(p, out));
+            if (sizeof(wchar_t) == 4) {
+                std::wstring w(p.begin(), p.end());
+                ITI_CHECK(!wide_to_utf8(w, out));
+            }
+        }
+    }
+}
+
+// every_code_point converts each scalar value through every form and back.
+void every_code_point() {
+    std::u32string all;
+    for (char32_t cp = 0; cp <= 0x10ffff; cp++) {
+        if (cp < 0xd800 || cp > 0xdfff) {
+            all.push_back(cp);
+        }
+    }
+    std::string want;
+    ref_encode(all, want);
+
+    std::string utf8;
+    ITI_CHECK(utf32_to_utf8(all, utf8) && utf8 == want);
+    std::string from16;
+    ITI_CHECK(utf16_to_utf8(to_utf16(all), from16) && from16 == want);
+
+    std::u32string u32;
+    ITI_CHECK(utf8_to_utf32(want, u32) && u32 == all);
+    std::u16string u16;
+    ITI_CHECK(utf8_to_utf16(want, u16) && u16 == to_utf16(all));
+    std::wstring w;
+    std::string fromWide;
+    ITI_CHECK(utf8_to_wide(want, w) && wide_to_utf8(w, fromWide) &&
+              fromWide == want);
+    ITI_CHECK(validate_utf8(want));
+}
+
+// random_strings compares the transcoder with the reference on random
+// strings, mostly valid text with a byte or a unit changed at times.
+void random_strings() {
+    std::mt19937 rng(43);
+    const char32_t samples[] = {U'a', U'~', 0x7f,   0x80,    0xe9,    0x7ff,
+                                0x800, 0x20ac, 0xd7ff, 0xe000, 0xfffd,
+                                0xffff, 0x10000, 0x1f600, 0x10ffff};
+    constexpr size_t nSamples = sizeof(samples) / sizeof(samples[0]);
+    size_t mismatches = 0;
+    for (int n = 0; n < 300000; n++) {
+        std::u32string cps;
+        const size_t len = rng() % 40;
+        for (size_t k = 0; k < len; k++) {
+            cps.push_back(rng() % 3 ? char32_t('a' + rng() % 26)
+                                    : samples[rng() % nSamples]);
+        }
+        std::string s;
+        ref_encode(cps, s);
+        std::u16string s16 = to_utf16(cps);
+        if (n % 2 && !s.empty()) {
+            s[rng() % s.size()] = char(rng());
+        }
+        if (n % 4 == 1 && !s16.empty()) {
+            s16[rng() % s16.size()] = char16_t(0xd800 + rng() % 0x800);
+        }
+
+        std::u32string want;
+        const bool valid = ref_decode(s, want);
+        std::u32string u32;
+        std::u16string u16;
+        bool same = validate_utf8(s) == valid &&
+                    utf8_to_utf32(s, u32) == valid &&
+                    utf8_to_utf16(s, u16) == valid &&
+                    (!valid || (u32 == want && u16 == to_utf16(want)));
+
+        std::u32string want16;
+        std::string want8, got8;
+        const bool valid16 =
+            ref_utf16(s16, want16) && ref_encode(want16, want8);
+        same = same && utf16_to_utf8(s16, got8) == valid16 &&
+               (!valid16 || got8 == want8);
+        if (!same && mismatches++ < 5) {
+            std::printf("  mismatch on string %d\n", n);
+        }
+    }
+    ITI_CHECK(mismatches == 0);
+}
+
+} // namespace
+
+int main() {
+    invalid_utf8();
+    invalid_utf16_utf32();
+    every_code_point();
+    random_strings();
+    return iti::test::report("utf");
+}